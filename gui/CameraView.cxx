@@ -38,6 +38,7 @@
 #include "FeatureOptions.h"
 #include "FieldInformation.h"
 #include "ImageOptions.h"
+#include "ImagePyramid.h"
 #include "vtkMaptkCamera.h"
 #include "vtkMaptkFeatureTrackRepresentation.h"
 
@@ -47,7 +48,9 @@
 
 #include <vtkCamera.h>
 #include <vtkCellArray.h>
+#include <vtkCommand.h>
 #include <vtkDoubleArray.h>
+#include <vtkEventQtSlotConnect.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
 #include <vtkInteractorStyleRubberBand2D.h>
@@ -59,6 +62,7 @@
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
 #include <vtkRenderWindow.h>
+#include <vtkSmartPointer.h>
 #include <vtkUnsignedCharArray.h>
 #include <vtkUnsignedIntArray.h>
 
@@ -70,6 +74,9 @@
 #include <QtGui/QToolButton>
 #include <QtGui/QWidgetAction>
 
+#include <algorithm>
+#include <vector>
+
 QTE_IMPLEMENT_D_FUNC(CameraView)
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -89,6 +96,8 @@ struct LandmarkData
   unsigned observations;
 };
 
+typedef std::pair<kwiver::vital::landmark_id_t, LandmarkData> LandmarkEntry;
+
 //-----------------------------------------------------------------------------
 class ActorColorOption : public QWidget
 {
@@ -144,6 +153,7 @@ public:
     VertexCloud();
 
     void clear();
+    void resize(vtkIdType count, int pointsPerCell);
 
     vtkNew<vtkPoints> points;
     vtkNew<vtkCellArray> verts;
@@ -166,6 +176,7 @@ public:
 
     void addSegment(double x1, double y1, double z1,
                     double x2, double y2, double z2);
+    void setSegments(size_t count, double const* segments, double z);
   };
 
   struct LandmarkCloud : PointCloud
@@ -173,6 +184,9 @@ public:
     LandmarkCloud();
 
     void addPoint(double x, double y, double z, LandmarkData const& data);
+    void setPoints(size_t count, kwiver::vital::landmark_id_t const* ids,
+                   double const* points, double z,
+                   std::vector<LandmarkEntry> const& landmarkData);
 
     void clear();
 
@@ -181,7 +195,11 @@ public:
     vtkNew<vtkDoubleArray> elevations;
   };
 
-  CameraViewPrivate() : featuresDirty(false) {}
+  typedef QHash<quint64, vtkSmartPointer<vtkImageActor>> TileActors;
+
+  CameraViewPrivate()
+    : imagePyramid(0), tiledImage(false), imageVisible(true),
+      imageScale(1.0), fullResolutionRequested(false), featuresDirty(false) {}
 
   void setPopup(QAction* action, QMenu* menu);
   void setPopup(QAction* action, QWidget* widget);
@@ -190,6 +208,13 @@ public:
 
   void updateFeatures(CameraView* q);
 
+  bool showTile(TileActors& actors, int level, int x, int y, double z);
+
+  static LandmarkData const& findLandmarkData(
+    std::vector<LandmarkEntry> const& entries,
+    kwiver::vital::landmark_id_t id,
+    std::vector<LandmarkEntry>::const_iterator& hint);
+
   Ui::CameraView UI;
   Am::CameraView AM;
 
@@ -199,12 +224,23 @@ public:
   vtkNew<vtkImageActor> imageActor;
   vtkNew<vtkImageData> emptyImage;
 
+  ImagePyramid* imagePyramid;
+  TileActors tileActors;
+  bool tiledImage;
+  bool imageVisible;
+
+  double imageScale;
+  bool fullResolutionRequested;
+
+  vtkNew<vtkEventQtSlotConnect> vtkConnect;
+
   vtkNew<vtkMaptkFeatureTrackRepresentation> featureRep;
 
   LandmarkCloud landmarks;
   SegmentCloud residuals;
 
-  QHash<kwiver::vital::landmark_id_t, LandmarkData> landmarkData;
+  // Landmark data, sorted by landmark identifier
+  std::vector<LandmarkEntry> landmarkData;
 
   PointOptions* landmarkOptions;
 
@@ -239,6 +275,28 @@ void CameraViewPrivate::VertexCloud::clear()
   this->verts->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::VertexCloud::resize(vtkIdType count, int pointsPerCell)
+{
+  // Replace the points with count cells of pointsPerCell new points each; the
+  // caller fills in the point coordinates
+  auto const pointCount = count * pointsPerCell;
+  this->points->SetNumberOfPoints(pointCount);
+
+  auto cells = this->verts->WritePointer(count, count * (pointsPerCell + 1));
+  for (vtkIdType i = 0; i < pointCount; )
+  {
+    *(cells++) = pointsPerCell;
+    for (int n = 0; n < pointsPerCell; ++n)
+    {
+      *(cells++) = i++;
+    }
+  }
+
+  this->points->Modified();
+  this->verts->Modified();
+}
+
 //-----------------------------------------------------------------------------
 CameraViewPrivate::PointCloud::PointCloud()
 {
@@ -280,6 +338,19 @@ void CameraViewPrivate::SegmentCloud::addSegment(
   this->verts->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::SegmentCloud::setSegments(
+  size_t count, double const* segments, double z)
+{
+  auto const n = static_cast<vtkIdType>(count);
+  this->resize(n, 2);
+
+  for (vtkIdType i = 0; i < 2 * n; ++i, segments += 2)
+  {
+    this->points->SetPoint(i, segments[0], segments[1], z);
+  }
+}
+
 //-----------------------------------------------------------------------------
 CameraViewPrivate::LandmarkCloud::LandmarkCloud()
 {
@@ -330,12 +401,74 @@ void CameraViewPrivate::LandmarkCloud::addPoint(
   this->elevations->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void CameraViewPrivate::LandmarkCloud::setPoints(
+  size_t count, kwiver::vital::landmark_id_t const* ids,
+  double const* points, double z,
+  std::vector<LandmarkEntry> const& landmarkData)
+{
+  auto const n = static_cast<vtkIdType>(count);
+  this->resize(n, 1);
+
+  this->colors->SetNumberOfTuples(n);
+  this->observations->SetNumberOfTuples(n);
+  this->elevations->SetNumberOfTuples(n);
+
+  auto colors = this->colors->GetPointer(0);
+  auto observations = this->observations->GetPointer(0);
+  auto elevations = this->elevations->GetPointer(0);
+
+  auto hint = landmarkData.cbegin();
+  for (vtkIdType i = 0; i < n; ++i, points += 2)
+  {
+    this->points->SetPoint(i, points[0], points[1], z);
+
+    auto const& data =
+      CameraViewPrivate::findLandmarkData(landmarkData, ids[i], hint);
+
+    *(colors++) = data.color.r;
+    *(colors++) = data.color.g;
+    *(colors++) = data.color.b;
+    *(observations++) = data.observations;
+    *(elevations++) = data.elevation;
+  }
+
+  this->colors->Modified();
+  this->observations->Modified();
+  this->elevations->Modified();
+}
+
 //END geometry helpers
 
 ///////////////////////////////////////////////////////////////////////////////
 
 //BEGIN CameraViewPrivate implementation
 
+//-----------------------------------------------------------------------------
+LandmarkData const& CameraViewPrivate::findLandmarkData(
+  std::vector<LandmarkEntry> const& entries, kwiver::vital::landmark_id_t id,
+  std::vector<LandmarkEntry>::const_iterator& hint)
+{
+  static auto const defaultData = LandmarkData{{}, 0.0, 0};
+
+  // Identifiers are usually requested in ascending order, so start searching
+  // from the previous match when possible
+  auto const first =
+    (hint != entries.cend() && hint->first <= id ? hint : entries.cbegin());
+  auto const iter = std::lower_bound(
+    first, entries.cend(), id,
+    [](LandmarkEntry const& entry, kwiver::vital::landmark_id_t id){
+      return entry.first < id;
+    });
+  if (iter == entries.cend() || iter->first != id)
+  {
+    return defaultData;
+  }
+
+  hint = iter;
+  return iter->second;
+}
+
 //-----------------------------------------------------------------------------
 void CameraViewPrivate::setPopup(QAction* action, QMenu* menu)
 {
@@ -388,6 +521,37 @@ void CameraViewPrivate::updateFeatures(CameraView* q)
   }
 }
 
+//-----------------------------------------------------------------------------
+bool CameraViewPrivate::showTile(
+  TileActors& actors, int level, int x, int y, double z)
+{
+  auto const key = (static_cast<quint64>(level) << 48) |
+                   (static_cast<quint64>(y) << 24) |
+                   static_cast<quint64>(x);
+
+  // Reuse existing actor, if the tile is already shown
+  auto actor = this->tileActors.value(key);
+  if (!actor)
+  {
+    auto const data = this->imagePyramid->tile(level, x, y);
+    if (!data)
+    {
+      return false;
+    }
+
+    // Tiles share the property of the main image actor, so that changes to
+    // the image options apply to them
+    actor = vtkSmartPointer<vtkImageActor>::New();
+    actor->SetInputData(data);
+    actor->SetProperty(this->imageActor->GetProperty());
+    actor->SetPosition(0.0, 0.0, z);
+    this->renderer->AddViewProp(actor);
+  }
+
+  actors.insert(key, actor);
+  return true;
+}
+
 //END CameraViewPrivate implementation
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -489,6 +653,13 @@ CameraView::CameraView(QWidget* parent, Qt::WindowFlags flags)
   d->renderer->AddViewProp(d->imageActor.GetPointer());
   d->imageActor->SetPosition(0.0, 0.0, -0.5);
 
+  // Select image tiles to show (if showing a tiled image) when a render
+  // starts, so that the tiles match the current view
+  d->vtkConnect->Connect(d->renderer.GetPointer(), vtkCommand::StartEvent,
+                         this, SLOT(updateImageTiles()));
+  d->vtkConnect->Connect(d->renderer.GetPointer(), vtkCommand::StartEvent,
+                         this, SLOT(updateImageResolution()));
+
   // Create "dummy" image data for use when we have no "real" image
   d->emptyImage->SetExtent(0, 0, 0, 0, 0, 0);
   d->emptyImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
@@ -517,11 +688,65 @@ void CameraView::setImagePath(QString const& path)
   d->UI.labelImagePath->setText(path);
 }
 
+//-----------------------------------------------------------------------------
+void CameraView::setImagePyramid(ImagePyramid* pyramid)
+{
+  QTE_D();
+
+  if (d->imagePyramid)
+  {
+    disconnect(d->imagePyramid, 0, d->UI.renderWidget, 0);
+  }
+
+  d->imagePyramid = pyramid;
+
+  if (pyramid)
+  {
+    connect(pyramid, SIGNAL(levelsAvailable()),
+            d->UI.renderWidget, SLOT(update()));
+    connect(pyramid, SIGNAL(tilesAvailable()),
+            d->UI.renderWidget, SLOT(update()));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void CameraView::setTiledImage(QSize const& dimensions)
+{
+  QTE_D();
+
+  // Show the image of the pyramid; the tiles are selected when rendering
+  d->tiledImage = true;
+  d->imageActor->SetInputData(d->emptyImage.GetPointer());
+  d->imageActor->SetVisibility(false);
+
+  d->imageBounds[0] = 0.0; d->imageBounds[1] = dimensions.width() - 1;
+  d->imageBounds[2] = 0.0; d->imageBounds[3] = dimensions.height() - 1;
+  d->imageBounds[4] = 0.0; d->imageBounds[5] = 0.0;
+
+  d->setTransforms(dimensions.height());
+
+  // Remove tiles of the previous image
+  foreach (auto const& actor, d->tileActors)
+  {
+    d->renderer->RemoveViewProp(actor);
+  }
+  d->tileActors.clear();
+
+  d->UI.renderWidget->update();
+}
+
 //-----------------------------------------------------------------------------
 void CameraView::setImageData(vtkImageData* data, QSize const& dimensions)
 {
   QTE_D();
 
+  if (d->tiledImage)
+  {
+    d->tiledImage = false;
+    d->imageActor->SetVisibility(d->imageVisible);
+    this->updateImageTiles();
+  }
+
   if (!data)
   {
     // If no image given, clear current image and replace with "empty" image
@@ -535,15 +760,21 @@ void CameraView::setImageData(vtkImageData* data, QSize const& dimensions)
   }
   else
   {
-    // Set data on image actor
+    // Set data on image actor; the image may be at reduced resolution, so
+    // use the given dimensions for the bounds
     d->imageActor->SetInputData(data);
     d->imageActor->Update();
 
-    d->imageActor->GetBounds(d->imageBounds);
-    auto const h = d->imageBounds[3] + 1 - d->imageBounds[2];
-    d->setTransforms(qMax(0, static_cast<int>(h)));
+    d->imageBounds[0] = 0.0; d->imageBounds[1] = dimensions.width() - 1;
+    d->imageBounds[2] = 0.0; d->imageBounds[3] = dimensions.height() - 1;
+    d->imageBounds[4] = 0.0; d->imageBounds[5] = 0.0;
+
+    d->setTransforms(qMax(0, dimensions.height()));
   }
 
+  d->imageScale = (data ? data->GetSpacing()[0] : 1.0);
+  d->fullResolutionRequested = false;
+
   d->UI.renderWidget->update();
 }
 
@@ -568,6 +799,9 @@ void CameraView::setLandmarksData(kwiver::vital::landmark_map const& lm)
   auto maxObservations = unsigned{0};
   auto minZ = qInf(), maxZ = -qInf();
 
+  d->landmarkData.clear();
+  d->landmarkData.reserve(landmarks.size());
+
   foreach (auto const& lmi, landmarks)
   {
     auto const z = lmi.second->loc()[2];
@@ -575,7 +809,7 @@ void CameraView::setLandmarksData(kwiver::vital::landmark_map const& lm)
     auto const observations = lmi.second->observations();
     auto const ld = LandmarkData{color, z, observations};
 
-    d->landmarkData.insert(lmi.first, ld);
+    d->landmarkData.push_back({lmi.first, ld});
 
     haveColor = haveColor || (color != defaultColor);
     maxObservations = qMax(maxObservations, observations);
@@ -622,7 +856,21 @@ void CameraView::addLandmark(
 {
   QTE_D();
 
-  d->landmarks.addPoint(x, y, 0.0, d->landmarkData.value(id));
+  auto hint = d->landmarkData.cbegin();
+  auto const& data = d->findLandmarkData(d->landmarkData, id, hint);
+  d->landmarks.addPoint(x, y, 0.0, data);
+
+  d->UI.renderWidget->update();
+}
+
+//-----------------------------------------------------------------------------
+void CameraView::setLandmarks(
+  size_t count, kwiver::vital::landmark_id_t const* ids,
+  double const* points)
+{
+  QTE_D();
+
+  d->landmarks.setPoints(count, ids, points, 0.0, d->landmarkData);
 
   d->UI.renderWidget->update();
 }
@@ -640,6 +888,16 @@ void CameraView::addResidual(
   d->UI.renderWidget->update();
 }
 
+//-----------------------------------------------------------------------------
+void CameraView::setResiduals(size_t count, double const* segments)
+{
+  QTE_D();
+
+  d->residuals.setSegments(count, segments, -0.2);
+
+  d->UI.renderWidget->update();
+}
+
 //-----------------------------------------------------------------------------
 void CameraView::clearLandmarks()
 {
@@ -667,7 +925,8 @@ void CameraView::setImageVisible(bool state)
 {
   QTE_D();
 
-  d->imageActor->SetVisibility(state);
+  d->imageVisible = state;
+  d->imageActor->SetVisibility(state && !d->tiledImage);
   d->UI.renderWidget->update();
 }
 
@@ -732,4 +991,104 @@ void CameraView::updateFeatures()
   }
 }
 
+//-----------------------------------------------------------------------------
+void CameraView::updateImageTiles()
+{
+  QTE_D();
+
+  auto actors = CameraViewPrivate::TileActors{};
+  auto const pyramid = d->imagePyramid;
+
+  if (d->tiledImage && d->imageVisible && pyramid &&
+      pyramid->firstAvailableLevel() < pyramid->levelCount())
+  {
+    auto const coarsest = pyramid->levelCount() - 1;
+    auto const camera = d->renderer->GetActiveCamera();
+    int const* const size = d->renderer->GetSize();
+
+    // Choose the coarsest level that has at least one pixel per screen pixel
+    auto const scale = camera->GetParallelScale();
+    auto const unitsPerPixel = 2.0 * scale / qMax(1, size[1]);
+    auto level = 0;
+    while (level < coarsest && (2 << level) <= unitsPerPixel)
+    {
+      ++level;
+    }
+    level = qMax(level, pyramid->firstAvailableLevel());
+
+    // Show the tiles of that level which intersect the view
+    auto complete = true;
+    if (level < coarsest)
+    {
+      double fp[3];
+      camera->GetFocalPoint(fp);
+
+      auto const hh = scale;
+      auto const hw = scale * size[0] / qMax(1, size[1]);
+      auto const tileSize = static_cast<int>(ImagePyramid::TileSize);
+      auto const tileExtent = static_cast<double>(tileSize << level);
+      auto const& ld = pyramid->levelDimensions(level);
+      auto const nx = (ld.width() + tileSize - 1) / tileSize;
+      auto const ny = (ld.height() + tileSize - 1) / tileSize;
+
+      auto const x0 = qBound(0, qFloor((fp[0] - hw) / tileExtent), nx - 1);
+      auto const x1 = qBound(0, qFloor((fp[0] + hw) / tileExtent), nx - 1);
+      auto const y0 = qBound(0, qFloor((fp[1] - hh) / tileExtent), ny - 1);
+      auto const y1 = qBound(0, qFloor((fp[1] + hh) / tileExtent), ny - 1);
+
+      for (int y = y0; y <= y1; ++y)
+      {
+        for (int x = x0; x <= x1; ++x)
+        {
+          complete = d->showTile(actors, level, x, y, -0.5) && complete;
+        }
+      }
+    }
+    else
+    {
+      complete = false;
+    }
+
+    // Show the overview beneath the detail tiles to fill in any which are not
+    // loaded yet
+    if (!complete)
+    {
+      d->showTile(actors, coarsest, 0, 0, -0.6);
+    }
+  }
+
+  // Remove tiles no longer needed
+  foreach (auto const key, d->tileActors.keys())
+  {
+    if (!actors.contains(key))
+    {
+      d->renderer->RemoveViewProp(d->tileActors[key]);
+    }
+  }
+  d->tileActors.swap(actors);
+}
+
+//-----------------------------------------------------------------------------
+void CameraView::updateImageResolution()
+{
+  QTE_D();
+
+  if (d->tiledImage || d->imageScale <= 1.0 || d->fullResolutionRequested)
+  {
+    return;
+  }
+
+  // Request the full resolution image once image pixels are magnified
+  auto const camera = d->renderer->GetActiveCamera();
+  int const* const size = d->renderer->GetSize();
+  auto const unitsPerPixel =
+    2.0 * camera->GetParallelScale() / qMax(1, size[1]);
+
+  if (unitsPerPixel < d->imageScale)
+  {
+    d->fullResolutionRequested = true;
+    emit this->fullResolutionRequested();
+  }
+}
+
 //END CameraView
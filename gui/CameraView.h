@@ -35,6 +35,8 @@
 
 #include <qtGlobal.h>
 
+#include <cstddef>
+
 #include <QtGui/QWidget>
 
 class vtkImageData;
@@ -44,6 +46,8 @@ namespace kwiver { namespace vital { class track; } }
 
 class vtkMaptkCamera;
 
+class ImagePyramid;
+
 class CameraViewPrivate;
 
 class CameraView : public QWidget
@@ -56,11 +60,34 @@ public:
 
   void addFeatureTrack(kwiver::vital::track const&);
 
+  void setImagePyramid(ImagePyramid*);
+
+  /// Replace the displayed landmarks.
+  ///
+  /// \p points holds \p count packed (x, y) image coordinates, and \p ids
+  /// the identifiers of the corresponding landmarks, preferably in ascending
+  /// order. This is much faster than adding landmarks one at a time.
+  void setLandmarks(std::size_t count,
+                    kwiver::vital::landmark_id_t const* ids,
+                    double const* points);
+
+  /// Replace the displayed residuals.
+  ///
+  /// \p segments holds \p count packed (x1, y1, x2, y2) segments in image
+  /// coordinates.
+  void setResiduals(std::size_t count, double const* segments);
+
+signals:
+  /// Emitted when the view is zoomed in beyond the resolution of a reduced
+  /// resolution image.
+  void fullResolutionRequested();
+
 public slots:
   void setBackgroundColor(QColor const&);
 
   void setImagePath(QString const&);
   void setImageData(vtkImageData* data, QSize const& dimensions);
+  void setTiledImage(QSize const& dimensions);
 
   void setLandmarksData(kwiver::vital::landmark_map const&);
 
@@ -84,6 +111,8 @@ protected slots:
   void setResidualsVisible(bool);
 
   void updateFeatures();
+  void updateImageTiles();
+  void updateImageResolution();
 
 private:
   QTE_DECLARE_PRIVATE_RPTR(CameraView)
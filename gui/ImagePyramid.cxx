@@ -0,0 +1,753 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ImagePyramid.h"
+
+#include <vital/util/thread_pool.h>
+
+#include <vtkImageData.h>
+#include <vtkImageReader2.h>
+#include <vtkImageReader2Factory.h>
+#include <vtkSmartPointer.h>
+
+#include <QtGui/QDesktopServices>
+
+#include <QtCore/QCache>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace // anonymous
+{
+
+// Images with more pixels than this are shown using a pyramid
+static auto const LargeImagePixels = qint64{1} << 25;
+
+// Size of the in-memory tile cache, in kilobytes
+static auto const TileCacheSize = 256 * 1024;
+
+// Maximum size of the tiles of all images in the disk cache, in bytes; the
+// tiles of the least recently used images are removed beyond this
+static auto const MaxTileDiskUsage = qint64{8} << 30;
+
+static char const TileMagic[4] = { 'M', 'T', 'K', 'T' };
+static char const CompleteMarker[] = "complete";
+
+//-----------------------------------------------------------------------------
+struct TileHeader
+{
+  char magic[4];
+  qint32 width;
+  qint32 height;
+  qint32 components;
+};
+
+//-----------------------------------------------------------------------------
+struct TileEntry
+{
+  vtkSmartPointer<vtkImageData> data;
+};
+
+//-----------------------------------------------------------------------------
+struct PyramidState
+{
+  PyramidState(QObject* receiver, int levels)
+    : canceled(false), deliveryPending(false), availableLevel(levels),
+      receiver(receiver) {}
+
+  void requestDelivery();
+
+  std::atomic<bool> canceled;
+  std::atomic<bool> deliveryPending;
+  std::atomic<int> availableLevel;
+
+  // Tiles read but not yet delivered, guarded by mutex
+  std::mutex mutex;
+  std::vector<std::pair<quint64, vtkSmartPointer<vtkImageData>>> tiles;
+
+  QObject* const receiver;
+};
+
+//-----------------------------------------------------------------------------
+void PyramidState::requestDelivery()
+{
+  // Request delivery of results, unless a request is already pending
+  if (!this->deliveryPending.exchange(true))
+  {
+    QMetaObject::invokeMethod(this->receiver, "deliverResults",
+                              Qt::QueuedConnection);
+  }
+}
+
+//-----------------------------------------------------------------------------
+quint64 tileKey(int level, int x, int y)
+{
+  return (static_cast<quint64>(level) << 48) |
+         (static_cast<quint64>(y) << 24) |
+         static_cast<quint64>(x);
+}
+
+//-----------------------------------------------------------------------------
+QString tileFileName(int level, int x, int y)
+{
+  return QString("%1_%2_%3.tile").arg(level).arg(x).arg(y);
+}
+
+//-----------------------------------------------------------------------------
+int levelCount(QSize const& dimensions)
+{
+  auto w = dimensions.width(), h = dimensions.height();
+  auto levels = 1;
+  while (qMax(w, h) > ImagePyramid::TileSize)
+  {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+    ++levels;
+  }
+  return levels;
+}
+
+//-----------------------------------------------------------------------------
+QString cacheRoot()
+{
+  auto const& base =
+    QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+  return QDir(base).filePath("tiles");
+}
+
+//-----------------------------------------------------------------------------
+QString cacheDirectory(QString const& imagePath)
+{
+  // Key the cache on the image identity, so that a modified image gets a new
+  // set of tiles
+  auto const fi = QFileInfo(imagePath);
+  auto const& identity =
+    QString("%1\n%2\n%3").arg(fi.absoluteFilePath())
+                         .arg(fi.lastModified().toMSecsSinceEpoch())
+                         .arg(fi.size());
+  auto const& hash = QCryptographicHash::hash(
+    identity.toUtf8(), QCryptographicHash::Md5).toHex();
+
+  return QDir(cacheRoot()).filePath(QString::fromLatin1(hash));
+}
+
+//-----------------------------------------------------------------------------
+void markUsed(QDir const& cacheDir)
+{
+  // The modification time of the marker records when the tiles were last
+  // used, so that the least recently used tiles can be evicted
+  QFile marker(cacheDir.filePath(CompleteMarker));
+  if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    marker.write(QByteArray::number(QDateTime::currentMSecsSinceEpoch()));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void trimCache(QString const& keepDir)
+{
+  struct CacheEntry
+  {
+    QDateTime lastUsed;
+    qint64 size;
+    QString path;
+  };
+
+  // Find the size and last use of the tiles of each image; tiles still being
+  // generated have no marker, and are dated by their directory instead
+  auto entries = std::vector<CacheEntry>{};
+  auto total = qint64{0};
+  auto const& keep = QDir(keepDir).absolutePath();
+  foreach (auto const& di, QDir(cacheRoot()).entryInfoList(
+                             QDir::Dirs | QDir::NoDotAndDotDot))
+  {
+    auto entry = CacheEntry{di.lastModified(), 0, di.absoluteFilePath()};
+    foreach (auto const& fi, QDir(entry.path).entryInfoList(QDir::Files))
+    {
+      entry.size += fi.size();
+      if (fi.fileName() == CompleteMarker)
+      {
+        entry.lastUsed = fi.lastModified();
+      }
+    }
+
+    total += entry.size;
+    if (entry.path != keep)
+    {
+      entries.push_back(entry);
+    }
+  }
+
+  if (total <= MaxTileDiskUsage)
+  {
+    return;
+  }
+
+  // Remove the least recently used tiles until the cache is small enough
+  std::sort(entries.begin(), entries.end(),
+            [](CacheEntry const& a, CacheEntry const& b){
+              return a.lastUsed < b.lastUsed;
+            });
+  for (auto const& entry : entries)
+  {
+    if (total <= MaxTileDiskUsage)
+    {
+      break;
+    }
+
+    auto dir = QDir(entry.path);
+    foreach (auto const& name, dir.entryList(QDir::Files))
+    {
+      dir.remove(name);
+    }
+    dir.rmdir(entry.path);
+    total -= entry.size;
+  }
+}
+
+//-----------------------------------------------------------------------------
+std::vector<unsigned char> downsample(
+  unsigned char const* in, int w, int h, int c)
+{
+  auto const ow = (w + 1) / 2, oh = (h + 1) / 2;
+  auto out = std::vector<unsigned char>(static_cast<size_t>(ow * oh) * c);
+
+  auto* o = out.data();
+  for (int y = 0; y < oh; ++y)
+  {
+    auto const* const r0 = in + static_cast<size_t>(2 * y) * w * c;
+    auto const* const r1 =
+      in + static_cast<size_t>(qMin(2 * y + 1, h - 1)) * w * c;
+
+    for (int x = 0; x < ow; ++x)
+    {
+      auto const x0 = 2 * x * c, x1 = qMin(2 * x + 1, w - 1) * c;
+      for (int k = 0; k < c; ++k)
+      {
+        *o++ = static_cast<unsigned char>(
+          (r0[x0 + k] + r0[x1 + k] + r1[x0 + k] + r1[x1 + k] + 2) >> 2);
+      }
+    }
+  }
+
+  return out;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> makeTile(int level, int x, int y,
+                                       int width, int height, int components)
+{
+  auto const scale = static_cast<double>(1 << level);
+  auto const x0 = x * ImagePyramid::TileSize;
+  auto const y0 = y * ImagePyramid::TileSize;
+
+  // Place the tile in full resolution pixel coordinates; each tile pixel is
+  // centered on the block of full resolution pixels that it covers
+  auto const tile = vtkSmartPointer<vtkImageData>::New();
+  tile->SetExtent(x0, x0 + width - 1, y0, y0 + height - 1, 0, 0);
+  tile->SetSpacing(scale, scale, 1.0);
+  tile->SetOrigin(0.5 * (scale - 1.0), 0.5 * (scale - 1.0), 0.0);
+  tile->AllocateScalars(VTK_UNSIGNED_CHAR, components);
+
+  return tile;
+}
+
+//-----------------------------------------------------------------------------
+bool writeTile(QDir const& dir, int level, int x, int y,
+               unsigned char const* data, int w, int h, int c)
+{
+  auto const x0 = x * ImagePyramid::TileSize;
+  auto const y0 = y * ImagePyramid::TileSize;
+
+  TileHeader header;
+  memcpy(header.magic, TileMagic, sizeof(TileMagic));
+  header.width = qMin(+ImagePyramid::TileSize, w - x0);
+  header.height = qMin(+ImagePyramid::TileSize, h - y0);
+  header.components = c;
+
+  // Write to a temporary file and then rename it, so that a reader never
+  // sees a partial tile
+  auto const& path = dir.filePath(tileFileName(level, x, y));
+  QFile file(path + ".tmp");
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    return false;
+  }
+
+  auto ok = file.write(reinterpret_cast<char const*>(&header),
+                       sizeof(header)) == sizeof(header);
+
+  auto const rowBytes = static_cast<qint64>(header.width) * c;
+  for (int j = 0; ok && j < header.height; ++j)
+  {
+    auto const* const row =
+      data + (static_cast<size_t>(y0 + j) * w + x0) * c;
+    ok = file.write(reinterpret_cast<char const*>(row), rowBytes) == rowBytes;
+  }
+
+  file.close();
+  QFile::remove(path);
+  return ok && file.rename(path);
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> readTile(
+  QString const& cacheDir, int level, int x, int y)
+{
+  QFile file(QDir(cacheDir).filePath(tileFileName(level, x, y)));
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return nullptr;
+  }
+
+  TileHeader header;
+  if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+        sizeof(header) ||
+      memcmp(header.magic, TileMagic, sizeof(TileMagic)) != 0 ||
+      header.width < 1 || header.width > ImagePyramid::TileSize ||
+      header.height < 1 || header.height > ImagePyramid::TileSize ||
+      header.components < 1 || header.components > 4)
+  {
+    return nullptr;
+  }
+
+  auto const tile = makeTile(level, x, y, header.width, header.height,
+                             header.components);
+  auto const bytes =
+    static_cast<qint64>(header.width) * header.height * header.components;
+  auto* const data = static_cast<char*>(tile->GetScalarPointer());
+
+  if (file.read(data, bytes) != bytes)
+  {
+    return nullptr;
+  }
+
+  return tile;
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class ImagePyramidPrivate
+{
+public:
+  ImagePyramidPrivate(ImagePyramid* q)
+    : levelCount(0), reportedLevel(0), tiles(TileCacheSize), q_ptr(q) {}
+
+  template <typename Function>
+  void enqueue(Function work);
+
+  void generate();
+  void cancel();
+
+  QString imagePath;
+  QString cacheDir;
+  QSize dimensions;
+  int levelCount;
+  int reportedLevel;
+
+  std::shared_ptr<PyramidState> state;
+  std::vector<std::future<void>> jobs;
+
+  QCache<quint64, TileEntry> tiles;
+  QSet<quint64> pendingTiles;
+  QSet<quint64> failedTiles;
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(ImagePyramid)
+  QTE_DECLARE_PUBLIC(ImagePyramid)
+};
+
+QTE_IMPLEMENT_D_FUNC(ImagePyramid)
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+void ImagePyramidPrivate::enqueue(Function work)
+{
+  // Discard jobs that have finished
+  auto const isFinished = [](std::future<void> const& f){
+    return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  };
+  this->jobs.erase(
+    std::remove_if(this->jobs.begin(), this->jobs.end(), isFinished),
+    this->jobs.end());
+
+  auto const state = this->state;
+  auto const job = [state, work]{
+    if (!state->canceled)
+    {
+      work(*state);
+    }
+    state->requestDelivery();
+  };
+
+  this->jobs.push_back(kwiver::vital::thread_pool::instance().enqueue(job));
+}
+
+//-----------------------------------------------------------------------------
+void ImagePyramidPrivate::generate()
+{
+  auto const imagePath = this->imagePath;
+  auto const cacheDir = QDir(this->cacheDir);
+  auto const levels = this->levelCount;
+
+  this->enqueue([imagePath, cacheDir, levels](PyramidState& state){
+    // Decode full resolution image
+    auto const reader = vtkSmartPointer<vtkImageReader2>::Take(
+      vtkImageReader2Factory::CreateImageReader2(qPrintable(imagePath)));
+    if (!reader)
+    {
+      qWarning() << "Failed to create image reader for image" << imagePath;
+      return;
+    }
+
+    reader->SetFileName(qPrintable(imagePath));
+    reader->Update();
+
+    auto const image = reader->GetOutput();
+    if (!image || image->GetScalarType() != VTK_UNSIGNED_CHAR)
+    {
+      qWarning() << "Failed to read image" << imagePath;
+      return;
+    }
+
+    int dims[3];
+    image->GetDimensions(dims);
+    auto const c = image->GetNumberOfScalarComponents();
+
+    // Compute reduced resolution levels
+    std::vector<std::vector<unsigned char>> reduced(levels);
+    std::vector<QSize> sizes(levels);
+    sizes[0] = QSize(dims[0], dims[1]);
+    for (int level = 1; level < levels; ++level)
+    {
+      auto const& prev = sizes[level - 1];
+      auto const* const in =
+        (level == 1 ? static_cast<unsigned char*>(image->GetScalarPointer())
+                    : reduced[level - 1].data());
+
+      reduced[level] = downsample(in, prev.width(), prev.height(), c);
+      sizes[level] = QSize((prev.width() + 1) / 2, (prev.height() + 1) / 2);
+
+      if (state.canceled)
+      {
+        return;
+      }
+    }
+
+    // Write tiles, coarsest level first, so that a low resolution image can
+    // be shown as soon as possible
+    for (int level = levels - 1; level >= 0; --level)
+    {
+      auto const* const data =
+        (level ? reduced[level].data()
+               : static_cast<unsigned char*>(image->GetScalarPointer()));
+      auto const w = sizes[level].width(), h = sizes[level].height();
+      auto const tx = (w + ImagePyramid::TileSize - 1) / ImagePyramid::TileSize;
+      auto const ty = (h + ImagePyramid::TileSize - 1) / ImagePyramid::TileSize;
+
+      for (int y = 0; y < ty; ++y)
+      {
+        for (int x = 0; x < tx; ++x)
+        {
+          if (state.canceled)
+          {
+            return;
+          }
+          if (!writeTile(cacheDir, level, x, y, data, w, h, c))
+          {
+            qWarning() << "Failed to write image tile to" << cacheDir.path();
+            return;
+          }
+        }
+      }
+
+      state.availableLevel = level;
+
+      // Deliver the overview directly, since it will be needed immediately
+      if (level == levels - 1)
+      {
+        auto const tile = makeTile(level, 0, 0, w, h, c);
+        memcpy(tile->GetScalarPointer(), data,
+               static_cast<size_t>(w) * h * c);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.tiles.emplace_back(tileKey(level, 0, 0), tile);
+      }
+
+      // Free memory as soon as possible
+      if (level)
+      {
+        reduced[level] = std::vector<unsigned char>{};
+      }
+
+      state.requestDelivery();
+    }
+
+    markUsed(cacheDir);
+    trimCache(cacheDir.path());
+  });
+}
+
+//-----------------------------------------------------------------------------
+void ImagePyramidPrivate::cancel()
+{
+  if (this->state)
+  {
+    this->state->canceled = true;
+    this->state.reset();
+  }
+
+  this->tiles.clear();
+  this->pendingTiles.clear();
+  this->failedTiles.clear();
+}
+
+//-----------------------------------------------------------------------------
+ImagePyramid::ImagePyramid(QObject* parent)
+  : QObject(parent), d_ptr(new ImagePyramidPrivate(this))
+{
+}
+
+//-----------------------------------------------------------------------------
+ImagePyramid::~ImagePyramid()
+{
+  QTE_D();
+
+  d->cancel();
+  for (auto& job : d->jobs)
+  {
+    job.wait();
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool ImagePyramid::isLargeImage(QSize const& dimensions)
+{
+  auto const pixels =
+    static_cast<qint64>(dimensions.width()) * dimensions.height();
+  return pixels > LargeImagePixels;
+}
+
+//-----------------------------------------------------------------------------
+void ImagePyramid::setImage(QString const& path, QSize const& dimensions)
+{
+  QTE_D();
+
+  if (path == d->imagePath && dimensions == d->dimensions && d->state)
+  {
+    return;
+  }
+
+  d->cancel();
+
+  d->imagePath = path;
+  d->dimensions = dimensions;
+  d->levelCount = ::levelCount(dimensions);
+  d->cacheDir = cacheDirectory(path);
+  d->state = std::make_shared<PyramidState>(this, d->levelCount);
+  d->reportedLevel = d->levelCount;
+
+  auto const dir = QDir(d->cacheDir);
+  if (dir.exists(CompleteMarker))
+  {
+    markUsed(dir);
+    d->state->availableLevel = 0;
+    d->reportedLevel = 0;
+  }
+  else if (!dir.mkpath("."))
+  {
+    qWarning() << "Failed to create tile cache directory" << d->cacheDir;
+  }
+  else
+  {
+    d->generate();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ImagePyramid::clear()
+{
+  QTE_D();
+
+  d->cancel();
+
+  d->imagePath.clear();
+  d->cacheDir.clear();
+  d->dimensions = QSize();
+  d->levelCount = 0;
+  d->reportedLevel = 0;
+}
+
+//-----------------------------------------------------------------------------
+QString ImagePyramid::imagePath() const
+{
+  QTE_D();
+  return d->imagePath;
+}
+
+//-----------------------------------------------------------------------------
+QSize ImagePyramid::dimensions() const
+{
+  QTE_D();
+  return d->dimensions;
+}
+
+//-----------------------------------------------------------------------------
+int ImagePyramid::levelCount() const
+{
+  QTE_D();
+  return d->levelCount;
+}
+
+//-----------------------------------------------------------------------------
+int ImagePyramid::firstAvailableLevel() const
+{
+  QTE_D();
+  return (d->state ? d->reportedLevel : d->levelCount);
+}
+
+//-----------------------------------------------------------------------------
+QSize ImagePyramid::levelDimensions(int level) const
+{
+  QTE_D();
+
+  auto w = d->dimensions.width(), h = d->dimensions.height();
+  for (int i = 0; i < level; ++i)
+  {
+    w = (w + 1) / 2;
+    h = (h + 1) / 2;
+  }
+  return QSize(w, h);
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* ImagePyramid::tile(int level, int x, int y)
+{
+  QTE_D();
+
+  if (!d->state || level < d->reportedLevel || level >= d->levelCount)
+  {
+    return nullptr;
+  }
+
+  auto const key = tileKey(level, x, y);
+  if (auto const entry = d->tiles.object(key))
+  {
+    return entry->data;
+  }
+
+  // Request tile, if not already requested (or known to be unreadable)
+  if (!d->pendingTiles.contains(key) && !d->failedTiles.contains(key))
+  {
+    d->pendingTiles.insert(key);
+
+    auto const cacheDir = d->cacheDir;
+    d->enqueue([cacheDir, level, x, y, key](PyramidState& state){
+      auto const tile = readTile(cacheDir, level, x, y);
+
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.tiles.emplace_back(key, tile);
+    });
+  }
+
+  return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+vtkImageData* ImagePyramid::overview()
+{
+  QTE_D();
+  return this->tile(d->levelCount - 1, 0, 0);
+}
+
+//-----------------------------------------------------------------------------
+void ImagePyramid::deliverResults()
+{
+  QTE_D();
+
+  auto const state = d->state;
+  if (!state)
+  {
+    return;
+  }
+
+  // Clear the pending flag first, so that results arriving while these are
+  // being delivered will request another delivery
+  state->deliveryPending = false;
+
+  auto tiles = std::vector<std::pair<quint64, vtkSmartPointer<vtkImageData>>>{};
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    tiles.swap(state->tiles);
+  }
+
+  auto const level = state->availableLevel.load();
+  if (level < d->reportedLevel)
+  {
+    d->reportedLevel = level;
+    emit this->levelsAvailable();
+  }
+
+  if (!tiles.empty())
+  {
+    for (auto const& t : tiles)
+    {
+      d->pendingTiles.remove(t.first);
+      if (!t.second)
+      {
+        qWarning() << "Failed to read image tile from" << d->cacheDir;
+        d->failedTiles.insert(t.first);
+      }
+      else
+      {
+        auto const dims = t.second->GetDimensions();
+        auto const cost = qMax(1, dims[0] * dims[1] *
+                                  t.second->GetNumberOfScalarComponents() /
+                                  1024);
+        d->tiles.insert(t.first, new TileEntry{t.second}, cost);
+      }
+    }
+
+    emit this->tilesAvailable();
+  }
+}
@@ -0,0 +1,120 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_IMAGEPYRAMID_H_
+#define MAPTK_IMAGEPYRAMID_H_
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+#include <QtCore/QSize>
+
+class vtkImageData;
+
+class ImagePyramidPrivate;
+
+/// Multi-resolution, tiled representation of a large image.
+///
+/// The pyramid divides an image into levels, each having half the resolution
+/// of the previous level (level 0 is the full resolution image), down to a
+/// level which fits in a single tile. Each level is divided into square tiles.
+///
+/// The first time an image is used, its tiles are generated in the background
+/// and written to a disk cache, coarsest level first. Tiles are then read
+/// from the disk cache on request, also in the background, and held in a
+/// bounded memory cache. The disk cache is also bounded; once it grows too
+/// large, the tiles of the least recently used images are removed. Each tile
+/// is an image whose origin and spacing place it in the pixel coordinates of
+/// the full resolution image.
+class ImagePyramid : public QObject
+{
+  Q_OBJECT
+
+public:
+  enum { TileSize = 1024 };
+
+  explicit ImagePyramid(QObject* parent = 0);
+  virtual ~ImagePyramid();
+
+  /// Test if an image is large enough that it should be shown using a
+  /// pyramid, rather than loaded directly.
+  static bool isLargeImage(QSize const& dimensions);
+
+  /// Set the image for which to provide tiles.
+  ///
+  /// If the tiles for the image are not already in the disk cache, they are
+  /// generated in the background. Any tiles from a previous image are
+  /// discarded.
+  void setImage(QString const& path, QSize const& dimensions);
+
+  /// Discard the current image.
+  void clear();
+
+  QString imagePath() const;
+  QSize dimensions() const;
+
+  /// Get the number of levels of the pyramid.
+  int levelCount() const;
+
+  /// Get the finest level for which tiles are available.
+  ///
+  /// This returns #levelCount if no levels are available yet.
+  int firstAvailableLevel() const;
+
+  /// Get the dimensions, in pixels, of \p level.
+  QSize levelDimensions(int level) const;
+
+  /// Get the tile at (\p x, \p y) of \p level.
+  ///
+  /// If the tile is not in memory, it is requested and this returns \c null;
+  /// #tilesAvailable is emitted when the tile has been read.
+  vtkImageData* tile(int level, int x, int y);
+
+  /// Get the single tile of the coarsest level.
+  vtkImageData* overview();
+
+signals:
+  /// Emitted when the tiles of one or more additional levels are available.
+  void levelsAvailable();
+
+  /// Emitted when one or more requested tiles have been read.
+  void tilesAvailable();
+
+protected slots:
+  void deliverResults();
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(ImagePyramid)
+  QTE_DECLARE_PRIVATE(ImagePyramid)
+
+  QTE_DISABLE_COPY(ImagePyramid)
+};
+
+#endif
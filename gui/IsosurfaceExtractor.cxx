@@ -0,0 +1,957 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "IsosurfaceExtractor.h"
+
+#include <maptk/parallel.h>
+
+#include <vital/util/thread_pool.h>
+
+#include <vtkCallbackCommand.h>
+#include <vtkCellData.h>
+#include <vtkCellDataToPointData.h>
+#include <vtkContourFilter.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkImageShrink3D.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStructuredGrid.h>
+#include <vtkVersion.h>
+#include <vtkXMLStructuredGridReader.h>
+
+#if VTK_MAJOR_VERSION >= 7
+#include <vtkFlyingEdges3D.h>
+#else
+#include <vtkSynchronizedTemplates3D.h>
+#endif
+
+#include <qtStlUtil.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVector>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace // anonymous
+{
+
+// Maximum number of surfaces of each kind (full resolution and preview) to
+// keep in the cache
+static auto const MaxCachedSurfaces = 8;
+
+// Maximum memory used by cached full resolution surfaces, in kilobytes
+static auto const MaxCachedSurfaceMemory = 512 * 1024;
+
+// Approximate number of voxels in the preview volume
+static auto const PreviewVoxels = 64 * 64 * 64;
+
+//-----------------------------------------------------------------------------
+struct ExtractorState
+{
+  struct Surface
+  {
+    double threshold;
+    bool preview;
+    vtkSmartPointer<vtkPolyData> data;
+  };
+
+  ExtractorState(QObject* receiver)
+    : canceled(false), deliveryPending(false), loaded(false),
+      receiver(receiver) {}
+
+  void requestDelivery();
+
+  std::atomic<bool> canceled;
+  std::atomic<bool> deliveryPending;
+
+  // Results not yet delivered, guarded by mutex
+  std::mutex mutex;
+  bool loaded;
+  vtkSmartPointer<vtkDataSet> volume;
+  vtkSmartPointer<vtkDataSet> source;
+  vtkSmartPointer<vtkImageData> previewSource;
+  std::vector<Surface> surfaces;
+
+  QObject* const receiver;
+};
+
+//-----------------------------------------------------------------------------
+void ExtractorState::requestDelivery()
+{
+  // Request delivery of results, unless a request is already pending
+  if (!this->deliveryPending.exchange(true))
+  {
+    QMetaObject::invokeMethod(this->receiver, "deliverResults",
+                              Qt::QueuedConnection);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool regularLattice(
+  vtkStructuredGrid* grid, double origin[3], double spacing[3])
+{
+  // Test if the grid is an axis-aligned regular lattice, which can be
+  // represented as image data
+  int dims[3];
+  grid->GetDimensions(dims);
+  if (dims[0] < 2 || dims[1] < 2 || dims[2] < 2)
+  {
+    return false;
+  }
+
+  auto const points = grid->GetPoints();
+  double p[3];
+  points->GetPoint(0, origin);
+  points->GetPoint(1, p);
+  spacing[0] = p[0] - origin[0];
+  points->GetPoint(dims[0], p);
+  spacing[1] = p[1] - origin[1];
+  points->GetPoint(dims[0] * dims[1], p);
+  spacing[2] = p[2] - origin[2];
+
+  if (spacing[0] <= 0.0 || spacing[1] <= 0.0 || spacing[2] <= 0.0)
+  {
+    return false;
+  }
+
+  auto const tolerance =
+    1e-4 * std::min(spacing[0], std::min(spacing[1], spacing[2]));
+
+  std::atomic<bool> regular(true);
+  kwiver::maptk::parallel_for(dims[2], [&](int k0, int k1){
+    double q[3];
+    auto id = static_cast<vtkIdType>(k0) * dims[0] * dims[1];
+    for (int k = k0; k < k1 && regular; ++k)
+    {
+      for (int j = 0; j < dims[1]; ++j)
+      {
+        for (int i = 0; i < dims[0]; ++i, ++id)
+        {
+          points->GetPoint(id, q);
+          if (std::fabs(q[0] - (origin[0] + i * spacing[0])) > tolerance ||
+              std::fabs(q[1] - (origin[1] + j * spacing[1])) > tolerance ||
+              std::fabs(q[2] - (origin[2] + k * spacing[2])) > tolerance)
+          {
+            regular = false;
+            return;
+          }
+        }
+      }
+    }
+  }, 1);
+
+  return regular;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void averageCells(T const* cells, T* points, int const dims[3])
+{
+  // Compute the value at each point as the average of the cells that use the
+  // point, as vtkCellDataToPointData would
+  auto const cx = dims[0] - 1;
+  auto const cy = dims[1] - 1;
+  auto const cz = dims[2] - 1;
+
+  kwiver::maptk::parallel_for(dims[2], [=](int k0, int k1){
+    for (int k = k0; k < k1; ++k)
+    {
+      auto const kb = std::max(k - 1, 0), ke = std::min(k, cz - 1);
+      for (int j = 0; j < dims[1]; ++j)
+      {
+        auto const jb = std::max(j - 1, 0), je = std::min(j, cy - 1);
+        auto out = points + (static_cast<vtkIdType>(k) * dims[1] + j) * dims[0];
+        for (int i = 0; i < dims[0]; ++i)
+        {
+          auto const ib = std::max(i - 1, 0), ie = std::min(i, cx - 1);
+
+          auto sum = 0.0;
+          for (int kk = kb; kk <= ke; ++kk)
+          {
+            for (int jj = jb; jj <= je; ++jj)
+            {
+              auto const row =
+                cells + (static_cast<vtkIdType>(kk) * cy + jj) * cx;
+              for (int ii = ib; ii <= ie; ++ii)
+              {
+                sum += row[ii];
+              }
+            }
+          }
+
+          auto const n = (ke - kb + 1) * (je - jb + 1) * (ie - ib + 1);
+          out[i] = static_cast<T>(sum / n);
+        }
+      }
+    }
+  }, 1);
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataArray> cellToPointScalars(
+  vtkDataArray* cellScalars, int const dims[3])
+{
+  auto const cellCount =
+    static_cast<vtkIdType>(dims[0] - 1) * (dims[1] - 1) * (dims[2] - 1);
+  if (cellScalars->GetNumberOfComponents() != 1 ||
+      cellScalars->GetNumberOfTuples() != cellCount)
+  {
+    return nullptr;
+  }
+
+  auto const pointCount =
+    static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+
+  // Average in the native type for float and double; convert anything else
+  // to double first
+  vtkSmartPointer<vtkDataArray> cells = cellScalars;
+  auto const type = cells->GetDataType();
+  if (type != VTK_FLOAT && type != VTK_DOUBLE)
+  {
+    auto const converted = vtkSmartPointer<vtkDoubleArray>::New();
+    converted->DeepCopy(cells);
+    cells = converted;
+  }
+
+  vtkSmartPointer<vtkDataArray> points;
+  points.TakeReference(cells->NewInstance());
+  points->SetNumberOfComponents(1);
+  points->SetNumberOfTuples(pointCount);
+  points->SetName(cellScalars->GetName());
+
+  switch (cells->GetDataType())
+  {
+    case VTK_FLOAT:
+      averageCells(static_cast<float const*>(cells->GetVoidPointer(0)),
+                   static_cast<float*>(points->GetVoidPointer(0)), dims);
+      break;
+    default:
+      averageCells(static_cast<double const*>(cells->GetVoidPointer(0)),
+                   static_cast<double*>(points->GetVoidPointer(0)), dims);
+      break;
+  }
+
+  return points;
+}
+
+//-----------------------------------------------------------------------------
+void releaseMapping(vtkObject*, unsigned long, void* clientData, void*)
+{
+  // Closing the file unmaps the memory
+  delete static_cast<QFile*>(clientData);
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> readMetaImage(
+  QString const& path, char const* arrayName)
+{
+  // Read the header; only uncompressed, single channel, three dimensional,
+  // axis aligned volumes in native byte order are supported
+  QFile header(path);
+  if (!header.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    qWarning() << "Failed to open volume" << path;
+    return nullptr;
+  }
+
+  QHash<QString, QString> fields;
+  while (!header.atEnd())
+  {
+    auto const line = QString::fromUtf8(header.readLine()).trimmed();
+    auto const split = line.indexOf('=');
+    if (split > 0)
+    {
+      auto const key = line.left(split).trimmed();
+      fields.insert(key, line.mid(split + 1).trimmed());
+      if (key == "ElementDataFile")
+      {
+        break;
+      }
+    }
+  }
+  auto const headerEnd = header.pos();
+  header.close();
+
+  auto const values = [&fields](char const* key){
+    QVector<double> result;
+    auto const& items = fields.value(key).split(' ', QString::SkipEmptyParts);
+    foreach (auto const& v, items)
+    {
+      result.append(v.toDouble());
+    }
+    return result;
+  };
+  auto const isTrue = [&fields](char const* key){
+    return fields.value(key).compare("true", Qt::CaseInsensitive) == 0;
+  };
+
+  QHash<QString, int> types;
+  types.insert("MET_UCHAR", VTK_UNSIGNED_CHAR);
+  types.insert("MET_CHAR", VTK_SIGNED_CHAR);
+  types.insert("MET_USHORT", VTK_UNSIGNED_SHORT);
+  types.insert("MET_SHORT", VTK_SHORT);
+  types.insert("MET_UINT", VTK_UNSIGNED_INT);
+  types.insert("MET_INT", VTK_INT);
+  types.insert("MET_FLOAT", VTK_FLOAT);
+  types.insert("MET_DOUBLE", VTK_DOUBLE);
+
+  auto const dims = values("DimSize");
+  auto const spacing = fields.contains("ElementSpacing")
+                     ? values("ElementSpacing") : values("ElementSize");
+  auto const origin = fields.contains("Offset") ? values("Offset")
+                    : fields.contains("Origin") ? values("Origin")
+                                                : values("Position");
+  auto const transform = values("TransformMatrix");
+  auto const type = types.value(fields.value("ElementType"), VTK_VOID);
+  auto const dataFile = fields.value("ElementDataFile");
+  auto const msb = isTrue("BinaryDataByteOrderMSB") ||
+                   isTrue("ElementByteOrderMSB");
+
+  if (fields.value("NDims").toInt() != 3 || dims.count() != 3 ||
+      type == VTK_VOID || dataFile.isEmpty() ||
+      fields.value("ElementNumberOfChannels", "1").toInt() != 1 ||
+      isTrue("CompressedData") ||
+      msb != (QSysInfo::ByteOrder == QSysInfo::BigEndian) ||
+      (!transform.isEmpty() &&
+       transform != QVector<double>{1, 0, 0, 0, 1, 0, 0, 0, 1}))
+  {
+    qWarning() << "Unsupported volume format in" << path;
+    return nullptr;
+  }
+
+  // Map the voxel data
+  auto const sameFile = (dataFile == "LOCAL");
+  auto const dataPath = (sameFile ? path
+                         : QFileInfo(path).dir().absoluteFilePath(dataFile));
+  QScopedPointer<QFile> data(new QFile(dataPath));
+  if (!data->open(QIODevice::ReadOnly))
+  {
+    qWarning() << "Failed to open volume data" << dataPath;
+    return nullptr;
+  }
+
+  auto scalars = vtkSmartPointer<vtkDataArray>::Take(
+    vtkDataArray::CreateDataArray(type));
+  auto const count = static_cast<vtkIdType>(dims[0]) *
+                     static_cast<vtkIdType>(dims[1]) *
+                     static_cast<vtkIdType>(dims[2]);
+  auto const size = static_cast<qint64>(count) * scalars->GetDataTypeSize();
+  auto const skip = fields.value("HeaderSize", "0").toLongLong();
+  auto const offset = (sameFile ? headerEnd
+                       : skip >= 0 ? skip : data->size() - size);
+
+  if (offset < 0 || offset + size > data->size())
+  {
+    qWarning() << "Volume data in" << dataPath << "is truncated";
+    return nullptr;
+  }
+
+  auto const mapped = data->map(offset, size);
+  auto const alignment = static_cast<quintptr>(scalars->GetDataTypeSize());
+  if (mapped && reinterpret_cast<quintptr>(mapped) % alignment == 0)
+  {
+    // Use the mapped memory directly; the mapping is kept until the array is
+    // destroyed
+    scalars->SetVoidArray(mapped, count, 1);
+
+    auto const release = vtkSmartPointer<vtkCallbackCommand>::New();
+    release->SetCallback(&releaseMapping);
+    release->SetClientData(data.take());
+    scalars->AddObserver(vtkCommand::DeleteEvent, release);
+  }
+  else
+  {
+    // Memory mapping is not available; read the data instead
+    scalars->SetNumberOfTuples(count);
+    data->seek(offset);
+    if (data->read(static_cast<char*>(scalars->GetVoidPointer(0)), size) !=
+        size)
+    {
+      qWarning() << "Failed to read volume data from" << dataPath;
+      return nullptr;
+    }
+  }
+  scalars->SetName(arrayName);
+
+  auto const image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(dims[0], dims[1], dims[2]);
+  if (spacing.count() == 3)
+  {
+    image->SetSpacing(spacing[0], spacing[1], spacing[2]);
+  }
+  if (origin.count() == 3)
+  {
+    image->SetOrigin(origin[0], origin[1], origin[2]);
+  }
+  image->GetPointData()->SetScalars(scalars);
+
+  return image;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> shrink(vtkImageData* image)
+{
+  auto const voxels = static_cast<double>(image->GetNumberOfPoints());
+  auto const factor =
+    static_cast<int>(std::ceil(std::cbrt(voxels / PreviewVoxels)));
+  if (factor < 2)
+  {
+    return nullptr;
+  }
+
+  auto const filter = vtkSmartPointer<vtkImageShrink3D>::New();
+  filter->SetInputData(image);
+  filter->SetShrinkFactors(factor, factor, factor);
+  filter->AveragingOn();
+  filter->Update();
+
+  auto const result = vtkSmartPointer<vtkImageData>::New();
+  result->ShallowCopy(filter->GetOutput());
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> extractSurface(
+  vtkDataSet* input, double threshold)
+{
+  vtkSmartPointer<vtkPolyDataAlgorithm> filter;
+
+  if (vtkImageData::SafeDownCast(input))
+  {
+#if VTK_MAJOR_VERSION >= 7
+    auto const f = vtkSmartPointer<vtkFlyingEdges3D>::New();
+#else
+    auto const f = vtkSmartPointer<vtkSynchronizedTemplates3D>::New();
+#endif
+    f->SetValue(0, threshold);
+    f->ComputeNormalsOn();
+    f->ComputeScalarsOn();
+    filter = f;
+  }
+  else
+  {
+    auto const f = vtkSmartPointer<vtkContourFilter>::New();
+    f->SetValue(0, threshold);
+    f->ComputeNormalsOn();
+    f->ComputeScalarsOn();
+    filter = f;
+  }
+
+  filter->SetInputData(input);
+  filter->SetInputArrayToProcess(0, 0, 0,
+                                 vtkDataObject::FIELD_ASSOCIATION_POINTS,
+                                 vtkDataSetAttributes::SCALARS);
+  filter->Update();
+
+  auto const surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->ShallowCopy(filter->GetOutput());
+  return surface;
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class IsosurfaceExtractorPrivate
+{
+public:
+  typedef std::pair<double, vtkSmartPointer<vtkPolyData>> CachedSurface;
+  typedef std::list<CachedSurface> SurfaceCache;
+
+  IsosurfaceExtractorPrivate(IsosurfaceExtractor* q)
+    : isPreview(false), threshold(0.0), thresholdSet(false),
+      extracting(false), extractingPreview(false), q_ptr(q) {}
+
+  template <typename Function>
+  void enqueue(Function work);
+
+  void cancel();
+  void update();
+  void extract(double threshold, bool preview);
+  void setSurface(vtkPolyData* surface, bool preview);
+
+  static vtkPolyData* find(SurfaceCache& cache, double threshold);
+  static void insert(SurfaceCache& cache, CachedSurface const& surface,
+                     int maxMemory);
+
+  std::shared_ptr<ExtractorState> state;
+  std::vector<std::future<void>> jobs;
+
+  vtkSmartPointer<vtkDataSet> volume;
+  vtkSmartPointer<vtkDataSet> source;
+  vtkSmartPointer<vtkImageData> previewSource;
+
+  SurfaceCache surfaces;
+  SurfaceCache previews;
+
+  vtkSmartPointer<vtkPolyData> surface;
+  bool isPreview;
+
+  double threshold;
+  bool thresholdSet;
+  bool extracting;
+  bool extractingPreview;
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(IsosurfaceExtractor)
+  QTE_DECLARE_PUBLIC(IsosurfaceExtractor)
+};
+
+QTE_IMPLEMENT_D_FUNC(IsosurfaceExtractor)
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+void IsosurfaceExtractorPrivate::enqueue(Function work)
+{
+  // Discard jobs that have finished
+  auto const isFinished = [](std::future<void> const& f){
+    return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  };
+  this->jobs.erase(
+    std::remove_if(this->jobs.begin(), this->jobs.end(), isFinished),
+    this->jobs.end());
+
+  auto const state = this->state;
+  auto const job = [state, work]{
+    if (!state->canceled)
+    {
+      work(*state);
+    }
+    state->requestDelivery();
+  };
+
+  this->jobs.push_back(kwiver::vital::thread_pool::instance().enqueue(job));
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractorPrivate::cancel()
+{
+  if (this->state)
+  {
+    this->state->canceled = true;
+    this->state.reset();
+  }
+
+  this->extracting = false;
+  this->extractingPreview = false;
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractorPrivate::update()
+{
+  if (!this->source || !this->thresholdSet)
+  {
+    return;
+  }
+
+  auto const t = this->threshold;
+
+  // Use the full resolution surface, if available
+  if (auto const surface = find(this->surfaces, t))
+  {
+    this->setSurface(surface, false);
+    return;
+  }
+
+  // Otherwise, use the preview surface (computing it if needed) until the
+  // full resolution surface is available
+  if (auto const surface = find(this->previews, t))
+  {
+    this->setSurface(surface, true);
+  }
+  else if (this->previewSource && !this->extractingPreview)
+  {
+    this->extract(t, true);
+  }
+
+  // Only one full resolution surface is computed at a time; if the threshold
+  // changes while one is being computed, the surface for the new threshold is
+  // computed once the current one is done
+  if (!this->extracting)
+  {
+    this->extract(t, false);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractorPrivate::extract(double threshold, bool preview)
+{
+  // Give the job its own copy (sharing the data arrays) of the input, so that
+  // concurrent jobs do not share pipeline information
+  auto const& source =
+    (preview ? vtkSmartPointer<vtkDataSet>{this->previewSource}
+             : this->source);
+
+  vtkSmartPointer<vtkDataSet> input;
+  input.TakeReference(source->NewInstance());
+  input->ShallowCopy(source);
+
+  (preview ? this->extractingPreview : this->extracting) = true;
+
+  this->enqueue([input, threshold, preview](ExtractorState& state){
+    auto const& surface = extractSurface(input, threshold);
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.surfaces.push_back({threshold, preview, surface});
+  });
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractorPrivate::setSurface(vtkPolyData* surface, bool preview)
+{
+  QTE_Q();
+
+  if (surface != this->surface || preview != this->isPreview)
+  {
+    this->surface = surface;
+    this->isPreview = preview;
+    emit q->surfaceChanged();
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkPolyData* IsosurfaceExtractorPrivate::find(
+  SurfaceCache& cache, double threshold)
+{
+  for (auto iter = cache.begin(); iter != cache.end(); ++iter)
+  {
+    if (iter->first == threshold)
+    {
+      // Move to front of the cache, as it is the most recently used
+      cache.splice(cache.begin(), cache, iter);
+      return cache.front().second;
+    }
+  }
+
+  return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractorPrivate::insert(
+  SurfaceCache& cache, CachedSurface const& surface, int maxMemory)
+{
+  // A surface may be extracted again while an earlier extraction for the same
+  // threshold is in progress; keep only the newest one
+  cache.remove_if([&surface](CachedSurface const& s){
+    return s.first == surface.first;
+  });
+  cache.push_front(surface);
+
+  // Evict least recently used surfaces, always keeping the newest one
+  auto memory = 0ul;
+  auto count = 0;
+  for (auto iter = cache.begin(); iter != cache.end(); )
+  {
+    memory += iter->second->GetActualMemorySize();
+    if (count && (count >= MaxCachedSurfaces ||
+                  memory > static_cast<unsigned long>(maxMemory)))
+    {
+      iter = cache.erase(iter);
+    }
+    else
+    {
+      ++iter;
+      ++count;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+IsosurfaceExtractor::IsosurfaceExtractor(QObject* parent)
+  : QObject(parent), d_ptr(new IsosurfaceExtractorPrivate(this))
+{
+}
+
+//-----------------------------------------------------------------------------
+IsosurfaceExtractor::~IsosurfaceExtractor()
+{
+  QTE_D();
+
+  d->cancel();
+  for (auto& job : d->jobs)
+  {
+    job.wait();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractor::loadVolume(
+  QString const& path, QString const& arrayName)
+{
+  QTE_D();
+
+  d->cancel();
+
+  d->volume = nullptr;
+  d->source = nullptr;
+  d->previewSource = nullptr;
+  d->surfaces.clear();
+  d->previews.clear();
+  d->state = std::make_shared<ExtractorState>(this);
+
+  auto const filename = stdString(path);
+  auto const name = stdString(arrayName);
+  d->enqueue([filename, name](ExtractorState& state){
+    vtkSmartPointer<vtkDataSet> volume;
+    vtkSmartPointer<vtkDataSet> source;
+    vtkSmartPointer<vtkImageData> image;
+
+    if (QFileInfo(qtString(filename)).suffix().toLower() == "mhd")
+    {
+      // Raw volumes are mapped into memory and used as-is
+      image = readMetaImage(qtString(filename), name.c_str());
+      volume = image;
+    }
+    else
+    {
+      // Read volume
+      auto const reader = vtkSmartPointer<vtkXMLStructuredGridReader>::New();
+      reader->SetFileName(filename.c_str());
+      reader->Update();
+
+      auto const grid = vtkSmartPointer<vtkStructuredGrid>::New();
+      grid->ShallowCopy(reader->GetOutput());
+      volume = grid;
+
+      int dims[3];
+      double origin[3], spacing[3];
+      grid->GetDimensions(dims);
+
+      auto const pointScalars = grid->GetPointData()->GetArray(name.c_str());
+      auto const cellScalars = grid->GetCellData()->GetArray(name.c_str());
+      if ((pointScalars || cellScalars) &&
+          regularLattice(grid, origin, spacing))
+      {
+        // Regular grid; convert to image data, computing the point scalars
+        // directly rather than copying the whole grid, and drop the grid
+        // (including its explicit point coordinates)
+        auto const scalars =
+          (pointScalars ? vtkSmartPointer<vtkDataArray>{pointScalars}
+                        : cellToPointScalars(cellScalars, dims));
+        if (scalars)
+        {
+          image = vtkSmartPointer<vtkImageData>::New();
+          image->SetDimensions(dims);
+          image->SetOrigin(origin);
+          image->SetSpacing(spacing);
+          image->GetPointData()->SetScalars(scalars);
+
+          // The volume, which is what is saved, keeps every array of the
+          // grid (but not the point scalars averaged from the cells); the
+          // image used for extraction holds only the scalars, as the filters
+          // would interpolate any other point arrays onto the surface
+          auto const gridImage = vtkSmartPointer<vtkImageData>::New();
+          gridImage->SetDimensions(dims);
+          gridImage->SetOrigin(origin);
+          gridImage->SetSpacing(spacing);
+          gridImage->GetPointData()->ShallowCopy(grid->GetPointData());
+          gridImage->GetCellData()->ShallowCopy(grid->GetCellData());
+          gridImage->GetFieldData()->ShallowCopy(grid->GetFieldData());
+          volume = gridImage;
+        }
+      }
+      else
+      {
+        // Transform cell data to point data for surface extraction
+        auto const cellToPoint =
+          vtkSmartPointer<vtkCellDataToPointData>::New();
+        cellToPoint->SetInputData(grid);
+        cellToPoint->Update();
+
+        auto const output =
+          vtkStructuredGrid::SafeDownCast(cellToPoint->GetOutput());
+        auto const scalars =
+          (output ? output->GetPointData()->GetArray(name.c_str()) : nullptr);
+        if (scalars)
+        {
+          // Irregular grid; extract surfaces from the grid itself
+          auto const pointGrid = vtkSmartPointer<vtkStructuredGrid>::New();
+          pointGrid->ShallowCopy(output);
+          pointGrid->GetPointData()->SetScalars(scalars);
+          source = pointGrid;
+        }
+      }
+    }
+
+    vtkSmartPointer<vtkImageData> previewSource;
+    if (image)
+    {
+      source = image;
+      previewSource = shrink(image);
+    }
+    else if (!source)
+    {
+      qWarning() << "Failed to read volume scalars from"
+                 << qtString(filename);
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.loaded = true;
+    state.volume = volume;
+    state.source = source;
+    state.previewSource = previewSource;
+  });
+}
+
+//-----------------------------------------------------------------------------
+vtkDataSet* IsosurfaceExtractor::volume() const
+{
+  QTE_D();
+  return d->volume;
+}
+
+//-----------------------------------------------------------------------------
+vtkPolyData* IsosurfaceExtractor::surface() const
+{
+  QTE_D();
+  return d->surface;
+}
+
+//-----------------------------------------------------------------------------
+bool IsosurfaceExtractor::isPreview() const
+{
+  QTE_D();
+  return d->isPreview;
+}
+
+//-----------------------------------------------------------------------------
+vtkPolyData* IsosurfaceExtractor::fullSurface()
+{
+  QTE_D();
+
+  if (!d->source || !d->thresholdSet)
+  {
+    return nullptr;
+  }
+
+  if (!d->find(d->surfaces, d->threshold))
+  {
+    // Extract the surface now, rather than waiting for the background
+    // extraction, which may not even have been started yet
+    vtkSmartPointer<vtkDataSet> input;
+    input.TakeReference(d->source->NewInstance());
+    input->ShallowCopy(d->source);
+
+    auto const& surface = extractSurface(input, d->threshold);
+    d->insert(d->surfaces, {d->threshold, surface}, MaxCachedSurfaceMemory);
+  }
+
+  d->update();
+  return d->surface;
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractor::setThreshold(double threshold)
+{
+  QTE_D();
+
+  d->threshold = threshold;
+  d->thresholdSet = true;
+  d->update();
+}
+
+//-----------------------------------------------------------------------------
+void IsosurfaceExtractor::deliverResults()
+{
+  QTE_D();
+
+  auto const state = d->state;
+  if (!state)
+  {
+    return;
+  }
+
+  // Clear the pending flag first, so that results arriving while these are
+  // being delivered will request another delivery
+  state->deliveryPending = false;
+
+  auto loaded = false;
+  auto surfaces = std::vector<ExtractorState::Surface>{};
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->loaded)
+    {
+      loaded = true;
+      state->loaded = false;
+
+      d->volume = state->volume;
+      d->source = state->source;
+      d->previewSource = state->previewSource;
+
+      state->volume = nullptr;
+      state->source = nullptr;
+      state->previewSource = nullptr;
+    }
+    surfaces.swap(state->surfaces);
+  }
+
+  if (loaded)
+  {
+    emit this->volumeLoaded();
+  }
+
+  for (auto const& s : surfaces)
+  {
+    if (s.preview)
+    {
+      d->extractingPreview = false;
+      if (s.data)
+      {
+        d->insert(d->previews, {s.threshold, s.data}, MaxCachedSurfaceMemory);
+      }
+    }
+    else
+    {
+      d->extracting = false;
+      if (s.data)
+      {
+        d->insert(d->surfaces, {s.threshold, s.data}, MaxCachedSurfaceMemory);
+      }
+    }
+  }
+
+  d->update();
+}
@@ -0,0 +1,118 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_ISOSURFACEEXTRACTOR_H_
+#define MAPTK_ISOSURFACEEXTRACTOR_H_
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+
+class vtkDataSet;
+class vtkPolyData;
+
+class IsosurfaceExtractorPrivate;
+
+/// Extracts isosurfaces from a volume in the background.
+///
+/// The extractor loads a volume and extracts the isosurface at the requested
+/// threshold using the shared thread pool. Regular volumes are converted to
+/// image data, which allows using a faster, multithreaded surface extraction
+/// algorithm, and a reduced resolution copy of the volume is used to provide
+/// a quick preview of the surface while the full resolution surface is being
+/// computed. Recently extracted surfaces are cached, so that returning to a
+/// previous threshold is instantaneous.
+class IsosurfaceExtractor : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit IsosurfaceExtractor(QObject* parent = 0);
+  virtual ~IsosurfaceExtractor();
+
+  /// Load the volume from \p path.
+  ///
+  /// The volume is read in the background; #volumeLoaded is emitted when it
+  /// is available. The scalars used for extracting surfaces are given by
+  /// \p arrayName.
+  ///
+  /// The volume may be a VTK structured grid (\c .vts) or an uncompressed
+  /// MetaImage (\c .mhd), whose voxel data is memory mapped rather than read.
+  /// Structured grids which are regular lattices are converted to image data,
+  /// with the point scalars computed from the cell scalars in parallel.
+  void loadVolume(QString const& path, QString const& arrayName);
+
+  /// Get the volume.
+  ///
+  /// This is the volume as read from the volume file, or the equivalent image
+  /// data if the volume is a regular lattice. Either way, it holds all the
+  /// data arrays stored in the file; point scalars which were averaged from
+  /// cell scalars for surface extraction are not included.
+  ///
+  /// This returns \c null if the volume has not been loaded.
+  vtkDataSet* volume() const;
+
+  /// Get the current surface.
+  ///
+  /// This is the surface for the most recently requested threshold, if it is
+  /// available, or a preview of it, if that is available, or else the most
+  /// recent surface available.
+  vtkPolyData* surface() const;
+
+  /// Test if the current surface is a preview.
+  bool isPreview() const;
+
+  /// Get the full resolution surface for the most recently requested
+  /// threshold.
+  ///
+  /// If that surface is not available yet, it is extracted on the calling
+  /// thread. Either way, it becomes the current surface. This returns \c null
+  /// if the volume has not been loaded or no threshold has been requested.
+  vtkPolyData* fullSurface();
+
+public slots:
+  /// Request the surface at \p threshold.
+  void setThreshold(double threshold);
+
+signals:
+  void volumeLoaded();
+  void surfaceChanged();
+
+protected slots:
+  void deliverResults();
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(IsosurfaceExtractor)
+  QTE_DECLARE_PRIVATE(IsosurfaceExtractor)
+
+  QTE_DISABLE_COPY(IsosurfaceExtractor)
+};
+
+#endif
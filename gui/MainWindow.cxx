@@ -37,21 +37,28 @@
 #include "tools/CanonicalTransformTool.h"
 #include "tools/InitCamerasLandmarksTool.h"
 #include "tools/NeckerReversalTool.h"
+#include "tools/PipelineTool.h"
 #include "tools/TrackFeaturesTool.h"
 #include "tools/TrackFilterTool.h"
 
 #include "AboutDialog.h"
+#include "ImagePyramid.h"
 #include "MatchMatrixWindow.h"
+#include "PreviewImage.h"
 #include "Project.h"
+#include "ProjectLoader.h"
+#include "SessionCache.h"
 #include "vtkMaptkImageDataGeometryFilter.h"
 #include "vtkMaptkImageUnprojectDepth.h"
 #include "vtkMaptkCamera.h"
 
+#include <maptk/dense_camera_map.h>
 #include <maptk/version.h>
 
 #include <vital/io/camera_io.h>
 #include <vital/io/landmark_map_io.h>
 #include <vital/io/track_set_io.h>
+#include <vital/util/thread_pool.h>
 #include <arrows/core/match_matrix.h>
 
 #include <vtksys/SystemTools.hxx>
@@ -75,8 +82,12 @@
 #include <QtGui/QApplication>
 #include <QtGui/QColorDialog>
 #include <QtGui/QDesktopServices>
+#include <QtGui/QDesktopWidget>
 #include <QtGui/QFileDialog>
 #include <QtGui/QMessageBox>
+#include <QtGui/QProgressBar>
+#include <QtGui/QStatusBar>
+#include <QtGui/QToolButton>
 
 #include <QtCore/QDebug>
 #include <QtCore/QQueue>
@@ -84,6 +95,10 @@
 #include <QtCore/QTimer>
 #include <QtCore/QUrl>
 
+#include <algorithm>
+#include <future>
+#include <vector>
+
 ///////////////////////////////////////////////////////////////////////////////
 
 //BEGIN miscellaneous helpers
@@ -238,7 +253,10 @@ public:
   MainWindowPrivate()
     : activeTool(0)
     , toolUpdateActiveFrame(-1)
-    , activeCameraIndex(-1) {}
+    , activeCameraIndex(-1)
+    , loadingProject(false)
+    , imageOverviewPending(false)
+    , loadedImageFull(false) {}
 
   void addTool(AbstractTool* tool, MainWindow* mainWindow);
 
@@ -254,12 +272,19 @@ public:
 
   void setActiveCamera(int);
   void updateCameraView();
+  void packLandmarks();
+  void showTracks();
+
+  void writeSession();
 
-  void loadImage(QString const& path, vtkMaptkCamera* camera);
+  void loadImage(QString const& path, vtkMaptkCamera* camera,
+                 bool fullResolution = false);
+  void clearTiledImage();
 
   void loadDepthMap(QString const& imagePath);
 
   void setActiveTool(AbstractTool* tool);
+  void updateToolsEnabled();
 
   // Member variables
   Ui::MainWindow UI;
@@ -283,11 +308,34 @@ public:
   kwiver::vital::feature_track_set_sptr tracks;
   kwiver::vital::landmark_map_sptr landmarks;
 
+  // Packed landmark positions (x, y, z) and identifiers, in ascending order
+  // of identifier, for projecting landmarks into the camera view
+  kwiver::vital::landmark_map_sptr packedLandmarks;
+  std::vector<kwiver::vital::landmark_id_t> landmarkIds;
+  std::vector<double> landmarkPositions;
+
   int activeCameraIndex;
 
   QQueue<int> orphanImages;
   QQueue<int> orphanCameras;
 
+  ProjectLoader* projectLoader;
+  QProgressBar* loadProgress;
+  QToolButton* loadCancel;
+  bool loadingProject;
+  QStringList pendingProjects;
+
+  QString sessionCachePath;
+  QStringList sessionSources;
+  std::future<void> sessionWrite;
+
+  ImagePyramid* imagePyramid;
+  bool imageOverviewPending;
+
+  QString loadedImagePath;
+  QSize loadedImageSize;
+  bool loadedImageFull;
+
   vtkNew<vtkXMLImageDataReader> depthReader;
   vtkNew<vtkMaptkImageUnprojectDepth> depthFilter;
   vtkNew<vtkMaptkImageDataGeometryFilter> depthGeometryFilter;
@@ -417,19 +465,20 @@ std::vector<std::string> MainWindowPrivate::imagePaths() const
 //-----------------------------------------------------------------------------
 kwiver::vital::camera_map_sptr MainWindowPrivate::cameraMap() const
 {
-  kwiver::vital::camera_map::map_camera_t map;
+  // Frames are numbered contiguously, so store the cameras densely
+  auto const map = std::make_shared<kwiver::maptk::dense_camera_map>();
 
   foreach (auto i, qtIndexRange(this->cameras.count()))
   {
     auto const& cd = this->cameras[i];
     if (cd.camera)
     {
-      map.insert(std::make_pair(static_cast<kwiver::vital::frame_id_t>(i),
-                                cd.camera->GetCamera()));
+      map->insert(static_cast<kwiver::vital::frame_id_t>(i),
+                  cd.camera->GetCamera());
     }
   }
 
-  return std::make_shared<kwiver::vital::simple_camera_map>(map);
+  return map;
 }
 
 //-----------------------------------------------------------------------------
@@ -459,11 +508,16 @@ void MainWindowPrivate::updateCameras(
         this->updateCameraView();
       }
 
-      allowExport = allowExport || iter.second;
+      allowExport = true;
     }
   }
 
-  this->UI.actionExportCameras->setEnabled(allowExport);
+  // Cameras may arrive in several chunks, so only ever enable exporting here;
+  // a chunk without valid cameras does not mean none are loaded
+  if (allowExport)
+  {
+    this->UI.actionExportCameras->setEnabled(true);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -496,8 +550,6 @@ void MainWindowPrivate::updateCameraView()
   this->UI.cameraView->setActiveFrame(
     static_cast<unsigned>(this->activeCameraIndex));
 
-  QHash<kwiver::vital::track_id_t, kwiver::vital::vector_2d> landmarkPoints;
-
   auto const& cd = this->cameras[this->activeCameraIndex];
 
   // Show camera image
@@ -513,56 +565,157 @@ void MainWindowPrivate::updateCameraView()
   }
 
   // Show landmarks
-  this->UI.cameraView->clearLandmarks();
-  if (this->landmarks)
+  this->packLandmarks();
+
+  auto const landmarkCount = static_cast<vtkIdType>(this->landmarkIds.size());
+  std::vector<double> landmarkPoints(2 * landmarkCount);
+  std::vector<vtkIdType> landmarkIndices(landmarkCount);
+  auto const visibleCount = cd.camera->ProjectPoints(
+    landmarkCount, this->landmarkPositions.data(),
+    landmarkPoints.data(), landmarkIndices.data());
+
+  // Visible landmarks are in the same order as the packed landmarks, so
+  // their identifiers are also sorted
+  std::vector<kwiver::vital::landmark_id_t> visibleIds(visibleCount);
+  for (vtkIdType i = 0; i < visibleCount; ++i)
   {
-    // Map landmarks to camera space
-    auto const& landmarks = this->landmarks->landmarks();
-    foreach (auto const& lm, landmarks)
-    {
-      double pp[2];
-      if (cd.camera->ProjectPoint(lm.second->loc(), pp))
-      {
-        // Add projected landmark to camera view
-        auto const id = lm.first;
-        this->UI.cameraView->addLandmark(id, pp[0], pp[1]);
-        landmarkPoints.insert(id, kwiver::vital::vector_2d(pp[0], pp[1]));
-      }
-    }
+    visibleIds[i] = this->landmarkIds[landmarkIndices[i]];
   }
+  this->UI.cameraView->setLandmarks(
+    visibleIds.size(), visibleIds.data(), landmarkPoints.data());
 
   // Show residuals
-  this->UI.cameraView->clearResiduals();
+  std::vector<double> residuals;
   if (this->tracks)
   {
-    auto const& tracks = this->tracks->tracks();
-    foreach (auto const& track, tracks)
+    auto const& states = this->tracks->frame_states(this->activeCameraIndex);
+    for (auto const& state : states)
     {
-      auto const& state = track->find(this->activeCameraIndex);
-      if ( state == track->end() )
-      {
-        continue;
-      }
-      auto fts = std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(*state);
-      if ( fts && fts->feature)
+      auto const& track = state->track();
+      auto fts = std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
+      if ( track && fts && fts->feature)
       {
         auto const id = track->id();
-        if (landmarkPoints.contains(id))
+        auto const iter =
+          std::lower_bound(visibleIds.cbegin(), visibleIds.cend(), id);
+        if (iter != visibleIds.cend() && *iter == id)
         {
           auto const& fp = fts->feature->loc();
-          auto const& lp = landmarkPoints[id];
-          this->UI.cameraView->addResidual(id, fp[0], fp[1], lp[0], lp[1]);
+          auto const lp =
+            landmarkPoints.data() + 2 * (iter - visibleIds.cbegin());
+          residuals.push_back(fp[0]);
+          residuals.push_back(fp[1]);
+          residuals.push_back(lp[0]);
+          residuals.push_back(lp[1]);
         }
       }
     }
   }
+  this->UI.cameraView->setResiduals(residuals.size() / 4, residuals.data());
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::packLandmarks()
+{
+  if (this->packedLandmarks == this->landmarks)
+  {
+    return;
+  }
+
+  this->packedLandmarks = this->landmarks;
+  this->landmarkIds.clear();
+  this->landmarkPositions.clear();
+
+  if (this->landmarks)
+  {
+    auto const& landmarks = this->landmarks->landmarks();
+    this->landmarkIds.reserve(landmarks.size());
+    this->landmarkPositions.reserve(3 * landmarks.size());
+    foreach (auto const& lm, landmarks)
+    {
+      auto const& loc = lm.second->loc();
+      this->landmarkIds.push_back(lm.first);
+      this->landmarkPositions.push_back(loc[0]);
+      this->landmarkPositions.push_back(loc[1]);
+      this->landmarkPositions.push_back(loc[2]);
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::showTracks()
+{
+  this->updateCameraView();
+
+  foreach (auto const& track, this->tracks->tracks())
+  {
+    this->UI.cameraView->addFeatureTrack(*track);
+  }
+
+  this->UI.actionExportTracks->setEnabled(
+      this->tracks && this->tracks->size());
+
+  this->UI.actionShowMatchMatrix->setEnabled(
+      this->tracks && this->tracks->size());
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::writeSession()
+{
+  // Take a snapshot of the current data; the cache is written in the
+  // background, but the data it references is never modified in place
+  auto const cache = std::make_shared<SessionCache>();
+  cache->tracks = this->tracks;
+  cache->landmarks = this->landmarks;
+
+  foreach (auto const& cd, this->cameras)
+  {
+    int w = -1, h = -1;
+    if (cd.camera)
+    {
+      cd.camera->GetImageDimensions(w, h);
+      cache->cameras.push_back(cd.camera->GetCamera());
+    }
+    else
+    {
+      cache->cameras.push_back(kwiver::vital::camera_sptr());
+    }
+    cache->imageDimensions.push_back(QSize(w, h));
+  }
+
+  auto const path = this->sessionCachePath;
+  auto const sources = this->sessionSources;
+
+  if (this->sessionWrite.valid())
+  {
+    this->sessionWrite.wait();
+  }
+  this->sessionWrite = kwiver::vital::thread_pool::instance().enqueue(
+    [cache, path, sources]{ cache->write(path, sources); });
 }
 
 //-----------------------------------------------------------------------------
-void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
+void MainWindowPrivate::loadImage(
+  QString const& path, vtkMaptkCamera* camera, bool fullResolution)
 {
+  // Don't decode the image again if it is already shown at the resolution
+  // requested
+  if (!path.isEmpty() && path == this->loadedImagePath &&
+      (this->loadedImageFull || !fullResolution))
+  {
+    if (camera)
+    {
+      camera->SetImageDimensions(this->loadedImageSize.width(),
+                                 this->loadedImageSize.height());
+    }
+    return;
+  }
+  this->loadedImagePath.clear();
+
   if (path.isEmpty())
   {
+    this->clearTiledImage();
+
     auto imageDimensions = QSize(1, 1);
     if (camera)
     {
@@ -586,8 +739,73 @@ void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
       return;
     }
 
-    // Load the image
+    // Get the image size without decoding the image
     reader->SetFileName(qPrintable(path));
+    reader->UpdateInformation();
+
+    int extent[6];
+    reader->GetDataExtent(extent);
+    auto const fullSize =
+      QSize(extent[1] - extent[0] + 1, extent[3] - extent[2] + 1);
+
+    if (reader->GetDataScalarType() == VTK_UNSIGNED_CHAR &&
+        ImagePyramid::isLargeImage(fullSize))
+    {
+      // Show large images using the image pyramid, so that only the tiles
+      // needed for the current view are loaded; the world view uses the
+      // pyramid overview
+      reader->Delete();
+
+      if (camera)
+      {
+        camera->SetImageDimensions(fullSize.width(), fullSize.height());
+      }
+
+      this->imagePyramid->setImage(path, fullSize);
+      this->UI.cameraView->setTiledImage(fullSize);
+
+      auto const overview = this->imagePyramid->overview();
+      this->UI.worldView->setImageData(overview, fullSize);
+      this->imageOverviewPending = !overview;
+
+      this->loadedImagePath = path;
+      this->loadedImageSize = fullSize;
+      this->loadedImageFull = true;
+      return;
+    }
+
+    this->clearTiledImage();
+
+    if (!fullResolution)
+    {
+      // Decode a screen sized preview, if the image is larger than that; the
+      // full resolution image is loaded if the camera view is zoomed in
+      auto const desktop = QApplication::desktop();
+      auto const& screen = desktop->screenGeometry(this->UI.cameraView);
+
+      auto previewSize = QSize();
+      auto const preview = readPreviewImage(path, screen.size(), &previewSize);
+      if (preview)
+      {
+        reader->Delete();
+
+        if (camera)
+        {
+          camera->SetImageDimensions(previewSize.width(),
+                                     previewSize.height());
+        }
+
+        this->UI.cameraView->setImageData(preview, previewSize);
+        this->UI.worldView->setImageData(preview, previewSize);
+
+        this->loadedImagePath = path;
+        this->loadedImageSize = previewSize;
+        this->loadedImageFull = false;
+        return;
+      }
+    }
+
+    // Load the image
     reader->Update();
 
     // Get dimensions
@@ -609,10 +827,18 @@ void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
         camera->SetImageDimensions(dimensions);
       }
 
-      // Set image on views
+      // Set image on views; when replacing a preview, the world view keeps
+      // the preview
       auto const size = QSize(dimensions[0], dimensions[1]);
       this->UI.cameraView->setImageData(data, size);
-      this->UI.worldView->setImageData(data, size);
+      if (!fullResolution)
+      {
+        this->UI.worldView->setImageData(data, size);
+      }
+
+      this->loadedImagePath = path;
+      this->loadedImageSize = size;
+      this->loadedImageFull = true;
     }
 
     // Delete the reader
@@ -621,6 +847,13 @@ void MainWindowPrivate::loadImage(QString const& path, vtkMaptkCamera* camera)
 }
 
 
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::clearTiledImage()
+{
+  this->imagePyramid->clear();
+  this->imageOverviewPending = false;
+}
+
 //-----------------------------------------------------------------------------
 void MainWindowPrivate::loadDepthMap(QString const& imagePath)
 {
@@ -664,14 +897,24 @@ void MainWindowPrivate::setActiveTool(AbstractTool* tool)
                      tool, SLOT(cancel()));
   }
 
-  auto const enableTools = !tool;
+  this->updateToolsEnabled();
+}
+
+//-----------------------------------------------------------------------------
+void MainWindowPrivate::updateToolsEnabled()
+{
+  auto const tool = this->activeTool;
+
+  // Tools operate on a snapshot of the data, so don't allow them (or opening
+  // more data) while a project is still loading
+  auto const enableTools = !tool && !this->loadingProject;
   auto const enableCancel = tool && tool->isCancelable();
   foreach (auto const& tool, this->tools)
   {
     tool->setEnabled(enableTools);
   }
   this->UI.actionCancelComputation->setEnabled(enableCancel);
-  this->UI.actionOpen->setEnabled(enableTools);
+  this->UI.actionOpen->setEnabled(!tool && !this->loadingProject);
 }
 
 //END MainWindowPrivate
@@ -699,6 +942,7 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   d->addTool(new CanonicalTransformTool(this), this);
   d->addTool(new NeckerReversalTool(this), this);
   d->addTool(new TrackFilterTool(this), this);
+  d->addTool(PipelineTool::createReconstructionPipeline(this), this);
 
   d->UI.menuView->addSeparator();
   d->UI.menuView->addAction(d->UI.cameraViewDock->toggleViewAction());
@@ -767,6 +1011,51 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   connect(d->UI.depthMapViewDock, SIGNAL(visibilityChanged(bool)),
           d->UI.depthMapView, SLOT(updateView(bool)));
 
+  // Set up tiled display of large images
+  d->imagePyramid = new ImagePyramid(this);
+  d->UI.cameraView->setImagePyramid(d->imagePyramid);
+
+  connect(d->imagePyramid, SIGNAL(levelsAvailable()),
+          this, SLOT(updateImageOverview()));
+  connect(d->imagePyramid, SIGNAL(tilesAvailable()),
+          this, SLOT(updateImageOverview()));
+
+  // Load full resolution images on demand; the request comes while the view
+  // is rendering, so defer handling it
+  connect(d->UI.cameraView, SIGNAL(fullResolutionRequested()),
+          this, SLOT(loadFullResolutionImage()), Qt::QueuedConnection);
+
+  // Set up background project loading
+  d->projectLoader = new ProjectLoader(this);
+
+  d->loadProgress = new QProgressBar(this);
+  d->loadProgress->setFormat("Loading project... %p%");
+  d->loadProgress->setVisible(false);
+
+  d->loadCancel = new QToolButton(this);
+  d->loadCancel->setText("Cancel");
+  d->loadCancel->setToolTip("Cancel loading the project");
+  d->loadCancel->setVisible(false);
+
+  this->statusBar()->addPermanentWidget(d->loadProgress);
+  this->statusBar()->addPermanentWidget(d->loadCancel);
+
+  connect(d->loadCancel, SIGNAL(clicked()),
+          d->projectLoader, SLOT(cancel()));
+  connect(d->projectLoader,
+          SIGNAL(tracksLoaded(kwiver::vital::feature_track_set_sptr)),
+          this, SLOT(setTracks(kwiver::vital::feature_track_set_sptr)));
+  connect(d->projectLoader,
+          SIGNAL(landmarksLoaded(kwiver::vital::landmark_map_sptr)),
+          this, SLOT(setLandmarks(kwiver::vital::landmark_map_sptr)));
+  connect(d->projectLoader,
+          SIGNAL(camerasLoaded(kwiver::vital::camera_map_sptr)),
+          this, SLOT(updateCameras(kwiver::vital::camera_map_sptr)));
+  connect(d->projectLoader, SIGNAL(progress(int, int)),
+          this, SLOT(updateLoadProgress(int, int)));
+  connect(d->projectLoader, SIGNAL(finished()),
+          this, SLOT(finishLoadProject()));
+
   this->setSlideDelay(d->UI.slideDelay->value());
 
 #ifdef VTKWEBGLEXPORTER
@@ -784,6 +1073,7 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   d->uiState.map("ViewBackground", d->viewBackgroundColor);
 
   d->uiState.mapChecked("WorldView/Axes", d->UI.actionShowWorldAxes);
+  d->uiState.mapChecked("Compute/RunInWorker", d->UI.actionRunToolsInWorker);
 
   d->uiState.mapState("Window/state", this);
   d->uiState.mapGeometry("Window/geometry", this);
@@ -807,6 +1097,11 @@ MainWindow::~MainWindow()
 {
   QTE_D();
   d->uiState.save();
+
+  if (d->sessionWrite.valid())
+  {
+    d->sessionWrite.wait();
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -877,6 +1172,14 @@ void MainWindow::loadProject(QString const& path)
 {
   QTE_D();
 
+  // Starting the loader again would cancel the load in progress, so load the
+  // project once that load has finished
+  if (d->loadingProject)
+  {
+    d->pendingProjects.append(path);
+    return;
+  }
+
   Project project;
   if (!project.read(path))
   {
@@ -884,46 +1187,77 @@ void MainWindow::loadProject(QString const& path)
     return;
   }
 
-  // Load tracks
-  if (!project.tracks.isEmpty())
-  {
-    this->loadTracks(project.tracks);
-  }
+  auto const firstFrame = d->cameras.count();
+  auto const& cachePath = SessionCache::path(path);
+  auto const& sources = SessionCache::sources(path, project);
 
-  // Load landmarks
-  if (!project.landmarks.isEmpty())
+  SessionCache cache;
+  if (cache.read(cachePath, sources) &&
+      cache.cameras.size() == static_cast<size_t>(project.images.count()))
   {
-    this->loadLandmarks(project.landmarks);
-  }
+    // Restore the project data from the session cache
+    foreach (auto i, qtIndexRange(project.images.count()))
+    {
+      auto const& ip = project.images[i];
+      if (project.cameraPath.isEmpty())
+      {
+        d->addImage(ip);
+        continue;
+      }
 
-  // Load cameras and/or images
-  if (project.cameraPath.isEmpty())
-  {
-    foreach (auto const& ip, project.images)
+      auto const& camera = cache.cameras[static_cast<size_t>(i)];
+      d->addFrame(camera, ip);
+
+      auto const& dims = cache.imageDimensions[static_cast<size_t>(i)];
+      if (camera && dims.isValid())
+      {
+        auto& cd = d->cameras.last();
+        cd.camera->SetImageDimensions(dims.width(), dims.height());
+        cd.camera->Update();
+      }
+    }
+
+    if (cache.tracks && cache.tracks->size())
     {
-      d->addImage(ip);
+      d->tracks = cache.tracks;
+      d->showTracks();
+    }
+    if (cache.landmarks && cache.landmarks->size())
+    {
+      this->setLandmarks(cache.landmarks);
     }
   }
   else
   {
-    auto const cameraDir = kwiver::vital::path_t(kvPath(project.cameraPath));
-    foreach (auto const& ip, project.images)
+    // Add frames for the images; if the project has cameras, they are added
+    // to the frames as they are loaded
+    if (project.cameraPath.isEmpty())
     {
-      try
+      foreach (auto const& ip, project.images)
       {
-        auto const& camera =
-          kwiver::vital::read_krtd_file(kvPath(ip), cameraDir);
-
-        // Add camera to scene
-        d->addFrame(camera, ip);
+        d->addImage(ip);
       }
-      catch (...)
+    }
+    else
+    {
+      foreach (auto const& ip, project.images)
       {
-        qWarning() << "failed to read camera for" << ip
-                   << "from" << project.cameraPath;
         d->addFrame(kwiver::vital::camera_sptr(), ip);
       }
     }
+
+    // Write a session cache once loading completes, unless other data is
+    // already loaded, in which case the cache would not match the project
+    d->sessionCachePath = (firstFrame ? QString() : cachePath);
+    d->sessionSources = sources;
+
+    // Load tracks, landmarks and cameras in the background
+    d->loadingProject = true;
+    d->updateToolsEnabled();
+    d->loadProgress->setValue(0);
+    d->loadProgress->setVisible(true);
+    d->loadCancel->setVisible(true);
+    d->projectLoader->start(project, firstFrame);
   }
 
   // Associate depth maps with cameras
@@ -933,11 +1267,13 @@ void MainWindow::loadProject(QString const& path)
     if (i >= 0 && i < d->cameras.count())
     {
       d->cameras[i].depthMapPath = dm.value();
-    }
 
-    if (i == d->activeCameraIndex)
-    {
-      d->loadDepthMap(dm.value());
+      // If the camera is still loading, the depth map will be loaded when the
+      // load completes
+      if (i == d->activeCameraIndex && d->cameras[i].camera)
+      {
+        d->loadDepthMap(dm.value());
+      }
     }
   }
 
@@ -982,25 +1318,12 @@ void MainWindow::loadCamera(QString const& path)
 //-----------------------------------------------------------------------------
 void MainWindow::loadTracks(QString const& path)
 {
-  QTE_D();
-
   try
   {
     auto const& tracks = kwiver::vital::read_feature_track_file(kvPath(path));
     if (tracks)
     {
-      d->tracks = tracks;
-      d->updateCameraView();
-
-      foreach (auto const& track, tracks->tracks())
-      {
-        d->UI.cameraView->addFeatureTrack(*track);
-      }
-
-      d->UI.actionExportTracks->setEnabled(
-          d->tracks && d->tracks->size());
-
-      d->UI.actionShowMatchMatrix->setEnabled(!tracks->tracks().empty());
+      this->setTracks(tracks);
     }
   }
   catch (...)
@@ -1012,21 +1335,12 @@ void MainWindow::loadTracks(QString const& path)
 //-----------------------------------------------------------------------------
 void MainWindow::loadLandmarks(QString const& path)
 {
-  QTE_D();
-
   try
   {
     auto const& landmarks = kwiver::vital::read_ply_file(kvPath(path));
     if (landmarks)
     {
-      d->landmarks = landmarks;
-      d->UI.worldView->setLandmarks(*landmarks);
-      d->UI.cameraView->setLandmarksData(*landmarks);
-
-      d->UI.actionExportLandmarks->setEnabled(
-        d->landmarks && d->landmarks->size());
-
-      d->updateCameraView();
+      this->setLandmarks(landmarks);
     }
   }
   catch (...)
@@ -1035,6 +1349,114 @@ void MainWindow::loadLandmarks(QString const& path)
   }
 }
 
+//-----------------------------------------------------------------------------
+void MainWindow::setTracks(kwiver::vital::feature_track_set_sptr const& tracks)
+{
+  QTE_D();
+
+  d->tracks = tracks;
+  d->showTracks();
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::setLandmarks(
+  kwiver::vital::landmark_map_sptr const& landmarks)
+{
+  QTE_D();
+
+  d->landmarks = landmarks;
+  d->UI.worldView->setLandmarks(*landmarks);
+  d->UI.cameraView->setLandmarksData(*landmarks);
+
+  d->UI.actionExportLandmarks->setEnabled(
+    d->landmarks && d->landmarks->size());
+
+  d->updateCameraView();
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::updateCameras(kwiver::vital::camera_map_sptr const& cameras)
+{
+  QTE_D();
+  d->updateCameras(cameras);
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::updateLoadProgress(int completed, int total)
+{
+  QTE_D();
+
+  d->loadProgress->setMaximum(qMax(total, 1));
+  d->loadProgress->setValue(completed);
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::finishLoadProject()
+{
+  QTE_D();
+
+  d->loadingProject = false;
+  d->updateToolsEnabled();
+  d->loadProgress->setVisible(false);
+  d->loadCancel->setVisible(false);
+
+  // Save a snapshot of the loaded data so that the project can be reopened
+  // quickly
+  if (!d->projectLoader->isCanceled() && !d->sessionCachePath.isEmpty())
+  {
+    d->writeSession();
+  }
+  d->sessionCachePath.clear();
+  d->sessionSources.clear();
+
+  // Refresh the active frame, now that its camera (and thus its depth map, if
+  // any) is available
+  if (d->activeCameraIndex >= 0)
+  {
+    d->setActiveCamera(d->activeCameraIndex);
+  }
+
+  d->UI.worldView->resetView();
+
+  // Load the projects that were opened while this one was loading, unless
+  // the load was canceled
+  if (d->projectLoader->isCanceled())
+  {
+    d->pendingProjects.clear();
+  }
+  while (!d->loadingProject && !d->pendingProjects.isEmpty())
+  {
+    this->loadProject(d->pendingProjects.takeFirst());
+  }
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::updateImageOverview()
+{
+  QTE_D();
+
+  if (d->imageOverviewPending)
+  {
+    if (auto const overview = d->imagePyramid->overview())
+    {
+      d->imageOverviewPending = false;
+      d->UI.worldView->setImageData(overview, d->imagePyramid->dimensions());
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void MainWindow::loadFullResolutionImage()
+{
+  QTE_D();
+
+  if (d->activeCameraIndex >= 0)
+  {
+    auto const& cd = d->cameras[d->activeCameraIndex];
+    d->loadImage(cd.imagePath, cd.camera, true);
+  }
+}
+
 //-----------------------------------------------------------------------------
 void MainWindow::saveLandmarks()
 {
@@ -1284,7 +1706,8 @@ void MainWindow::saveVolume()
   QTE_D();
 
   auto const path = QFileDialog::getSaveFileName(
-    this, "Export Volume", QString("volume.vts"),
+    this, "Export Volume", QString("volume.vti"),
+    "VTK Image Data (*.vti);;"
     "Mesh file (*.vts);;"
     "All Files (*)");
 
@@ -1407,6 +1830,7 @@ void MainWindow::executeTool(QObject* object)
     tool->setTracks(d->tracks);
     tool->setCameras(d->cameraMap());
     tool->setLandmarks(d->landmarks);
+    tool->setRunInWorker(d->UI.actionRunToolsInWorker->isChecked());
 
     if (!tool->execute())
     {
@@ -1464,9 +1888,11 @@ void MainWindow::acceptToolResults(std::shared_ptr<ToolData> data)
     }
   }
 
+  // Tools limit the rate of intermediate updates themselves, so just defer
+  // the update until control returns to the event loop
   if(updateNeeded)
   {
-    QTimer::singleShot(1000, this, SLOT(updateToolResults()));
+    QTimer::singleShot(0, this, SLOT(updateToolResults()));
   }
 }
 
@@ -1493,16 +1919,7 @@ void MainWindow::updateToolResults()
   {
     d->tracks = d->toolUpdateTracks;
     d->UI.cameraView->clearFeatureTracks();
-    d->updateCameraView();
-
-    foreach (auto const& track, d->tracks->tracks())
-    {
-      d->UI.cameraView->addFeatureTrack(*track);
-    }
-    d->UI.actionExportTracks->setEnabled(
-        d->tracks && d->tracks->size());
-
-    d->UI.actionShowMatchMatrix->setEnabled(!d->tracks->tracks().empty());
+    d->showTracks();
     d->toolUpdateTracks = NULL;
   }
   if (d->toolUpdateActiveFrame >= 0)
@@ -31,6 +31,10 @@
 #ifndef MAPTK_MAINWINDOW_H_
 #define MAPTK_MAINWINDOW_H_
 
+#include <vital/types/camera_map.h>
+#include <vital/types/landmark_map.h>
+#include <vital/types/feature_track_set.h>
+
 #include <qtGlobal.h>
 
 #include <QMainWindow>
@@ -93,6 +97,15 @@ protected slots:
   void setSlideshowPlaying(bool);
   void nextSlide();
 
+  void setTracks(kwiver::vital::feature_track_set_sptr const&);
+  void setLandmarks(kwiver::vital::landmark_map_sptr const&);
+  void updateCameras(kwiver::vital::camera_map_sptr const&);
+  void updateLoadProgress(int completed, int total);
+  void finishLoadProject();
+
+  void updateImageOverview();
+  void loadFullResolutionImage();
+
   void executeTool(QObject*);
   void acceptToolFinalResults();
   void acceptToolResults(std::shared_ptr<ToolData> data);
@@ -0,0 +1,220 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PreviewImage.h"
+
+#include <vtkImageData.h>
+
+#include <QtGui/QImage>
+#include <QtGui/QImageIOHandler>
+#include <QtGui/QImageReader>
+
+#include <QtCore/QDebug>
+
+#include <algorithm>
+#include <vector>
+
+namespace // anonymous
+{
+
+//-----------------------------------------------------------------------------
+int pixelComponents(QImage const& image)
+{
+  if (image.hasAlphaChannel())
+  {
+    return 4;
+  }
+  return (image.isGrayscale() ? 1 : 3);
+}
+
+//-----------------------------------------------------------------------------
+void unpackRow(QImage const& image, int row, int components,
+               unsigned char* out)
+{
+  auto const* const in =
+    reinterpret_cast<QRgb const*>(image.constScanLine(row));
+  auto const w = image.width();
+
+  switch (components)
+  {
+    case 1:
+      for (int i = 0; i < w; ++i)
+      {
+        out[i] = static_cast<unsigned char>(qGray(in[i]));
+      }
+      break;
+
+    case 3:
+      for (int i = 0; i < w; ++i, out += 3)
+      {
+        out[0] = static_cast<unsigned char>(qRed(in[i]));
+        out[1] = static_cast<unsigned char>(qGreen(in[i]));
+        out[2] = static_cast<unsigned char>(qBlue(in[i]));
+      }
+      break;
+
+    default:
+      for (int i = 0; i < w; ++i, out += 4)
+      {
+        out[0] = static_cast<unsigned char>(qRed(in[i]));
+        out[1] = static_cast<unsigned char>(qGreen(in[i]));
+        out[2] = static_cast<unsigned char>(qBlue(in[i]));
+        out[3] = static_cast<unsigned char>(qAlpha(in[i]));
+      }
+      break;
+  }
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> readPreviewImage(
+  QString const& path, QSize const& targetSize, QSize* fullSize)
+{
+  QImageReader reader(path);
+
+  // Get the image size from the header and determine the reduction factor
+  auto const size = reader.size();
+  if (!size.isValid() || !targetSize.isValid())
+  {
+    return nullptr;
+  }
+
+  auto factor = 1;
+  while (size.width() / (2 * factor) >= targetSize.width() &&
+         size.height() / (2 * factor) >= targetSize.height())
+  {
+    factor *= 2;
+  }
+
+  if (factor == 1)
+  {
+    return nullptr;
+  }
+
+  auto const w = (size.width() + factor - 1) / factor;
+  auto const h = (size.height() + factor - 1) / factor;
+
+  // Decode, at reduced resolution if the format supports it
+  auto const scaledDecode =
+    reader.supportsOption(QImageIOHandler::ScaledSize);
+  if (scaledDecode)
+  {
+    reader.setScaledSize(QSize(w, h));
+  }
+
+  auto image = reader.read();
+  if (image.isNull())
+  {
+    qWarning() << "Failed to read image" << path << reader.errorString();
+    return nullptr;
+  }
+
+  // If the handler ignored the requested size, the image is decoded at full
+  // resolution; reduce it ourselves
+  auto const scaled = scaledDecode && image.size() == QSize(w, h);
+  if (!scaled && image.size() != size)
+  {
+    qWarning() << "Image reader returned an unexpected size for" << path;
+    return nullptr;
+  }
+
+  auto const c = pixelComponents(image);
+  image = image.convertToFormat(
+    image.hasAlphaChannel() ? QImage::Format_ARGB32 : QImage::Format_RGB32);
+
+  // Create output image, placed in full resolution pixel coordinates
+  auto const s = static_cast<double>(factor);
+
+  auto const data = vtkSmartPointer<vtkImageData>::New();
+  data->SetExtent(0, w - 1, 0, h - 1, 0, 0);
+  data->SetSpacing(s, s, 1.0);
+  data->SetOrigin(0.5 * (s - 1.0), 0.5 * (s - 1.0), 0.0);
+  data->AllocateScalars(VTK_UNSIGNED_CHAR, c);
+
+  auto* const out = static_cast<unsigned char*>(data->GetScalarPointer());
+  auto const rowBytes = static_cast<size_t>(w) * c;
+
+  // Note that QImage rows are stored top to bottom, while VTK rows are stored
+  // bottom to top
+  if (scaled)
+  {
+    for (int y = 0; y < h; ++y)
+    {
+      unpackRow(image, h - 1 - y, c, out + y * rowBytes);
+    }
+  }
+  else
+  {
+    // Box filter the full resolution image
+    auto const iw = image.width(), ih = image.height();
+    auto row = std::vector<unsigned char>(static_cast<size_t>(iw) * c);
+    auto sums = std::vector<unsigned>(rowBytes);
+    auto counts = std::vector<unsigned>(static_cast<size_t>(w));
+
+    for (int y = 0; y < h; ++y)
+    {
+      std::fill(sums.begin(), sums.end(), 0u);
+      std::fill(counts.begin(), counts.end(), 0u);
+
+      auto const y0 = y * factor, y1 = qMin(y0 + factor, ih);
+      for (int iy = y0; iy < y1; ++iy)
+      {
+        unpackRow(image, iy, c, row.data());
+        for (int ix = 0; ix < iw; ++ix)
+        {
+          auto const x = ix / factor;
+          for (int k = 0; k < c; ++k)
+          {
+            sums[x * c + k] += row[ix * c + k];
+          }
+          ++counts[x];
+        }
+      }
+
+      auto* const o = out + (h - 1 - y) * rowBytes;
+      for (int x = 0; x < w; ++x)
+      {
+        auto const n = qMax(1u, counts[x]);
+        for (int k = 0; k < c; ++k)
+        {
+          o[x * c + k] =
+            static_cast<unsigned char>((sums[x * c + k] + n / 2) / n);
+        }
+      }
+    }
+  }
+
+  if (fullSize)
+  {
+    *fullSize = size;
+  }
+  return data;
+}
@@ -0,0 +1,56 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_PREVIEWIMAGE_H_
+#define MAPTK_PREVIEWIMAGE_H_
+
+#include <vtkSmartPointer.h>
+
+#include <QtCore/QSize>
+#include <QtCore/QString>
+
+class vtkImageData;
+
+/// Read an image at reduced resolution.
+///
+/// This reads the image at \p path, reduced by the largest power of two
+/// factor which keeps it at least as large as \p targetSize (in both
+/// dimensions). If the image format supports decoding at reduced resolution
+/// (e.g. DCT scaling for JPEG), that is used; otherwise the image is decoded
+/// at full resolution and reduced by box filtering.
+///
+/// The returned image has spacing and origin such that it covers the pixel
+/// coordinates of the full resolution image, whose dimensions are written to
+/// \p fullSize. Returns \c null if the image cannot be read, or if it would
+/// not be reduced, in which case the caller should read the image normally.
+vtkSmartPointer<vtkImageData> readPreviewImage(
+  QString const& path, QSize const& targetSize, QSize* fullSize = 0);
+
+#endif
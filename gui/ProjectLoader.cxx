@@ -0,0 +1,334 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ProjectLoader.h"
+
+#include "Project.h"
+
+#include <vital/io/camera_io.h>
+#include <vital/io/landmark_map_io.h>
+#include <vital/io/track_set_io.h>
+#include <vital/util/thread_pool.h>
+
+#include <qtStlUtil.h>
+
+#include <QtCore/QDebug>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace // anonymous
+{
+
+// Number of cameras read by each job
+static auto const CameraChunkSize = 64;
+
+//-----------------------------------------------------------------------------
+struct LoadState
+{
+  LoadState() : canceled(false), deliveryPending(false), completed(0) {}
+
+  std::atomic<bool> canceled;
+  std::atomic<bool> deliveryPending;
+
+  // Results not yet delivered, guarded by mutex
+  std::mutex mutex;
+  kwiver::vital::feature_track_set_sptr tracks;
+  kwiver::vital::landmark_map_sptr landmarks;
+  std::vector<kwiver::vital::camera_map_sptr> cameras;
+  int completed;
+};
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class ProjectLoaderPrivate
+{
+public:
+  ProjectLoaderPrivate(ProjectLoader* q)
+    : total(0), running(false), q_ptr(q) {}
+
+  template <typename Function>
+  void enqueue(Function work);
+
+  void wait();
+
+  std::shared_ptr<LoadState> state;
+  std::vector<std::future<void>> jobs;
+  int total;
+  bool running;
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(ProjectLoader)
+  QTE_DECLARE_PUBLIC(ProjectLoader)
+};
+
+QTE_IMPLEMENT_D_FUNC(ProjectLoader)
+
+//-----------------------------------------------------------------------------
+template <typename Function>
+void ProjectLoaderPrivate::enqueue(Function work)
+{
+  QTE_Q();
+
+  auto const state = this->state;
+  auto const job = [q, state, work]{
+    if (!state->canceled)
+    {
+      work(*state);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      ++state->completed;
+    }
+
+    // Request delivery of results, unless a request is already pending
+    if (!state->deliveryPending.exchange(true))
+    {
+      QMetaObject::invokeMethod(q, "deliverResults", Qt::QueuedConnection);
+    }
+  };
+
+  this->jobs.push_back(kwiver::vital::thread_pool::instance().enqueue(job));
+  ++this->total;
+}
+
+//-----------------------------------------------------------------------------
+void ProjectLoaderPrivate::wait()
+{
+  for (auto& job : this->jobs)
+  {
+    job.wait();
+  }
+  this->jobs.clear();
+}
+
+//-----------------------------------------------------------------------------
+ProjectLoader::ProjectLoader(QObject* parent)
+  : QObject(parent), d_ptr(new ProjectLoaderPrivate(this))
+{
+}
+
+//-----------------------------------------------------------------------------
+ProjectLoader::~ProjectLoader()
+{
+  QTE_D();
+
+  this->cancel();
+  d->wait();
+}
+
+//-----------------------------------------------------------------------------
+void ProjectLoader::start(Project const& project, int firstFrame)
+{
+  QTE_D();
+
+  // Stop any previous load
+  if (d->running)
+  {
+    this->cancel();
+    d->wait();
+  }
+
+  d->state = std::make_shared<LoadState>();
+  d->total = 0;
+  d->running = true;
+
+  // Load tracks
+  if (!project.tracks.isEmpty())
+  {
+    auto const path = stdString(project.tracks);
+    d->enqueue([path](LoadState& state){
+      try
+      {
+        auto const& tracks = kwiver::vital::read_feature_track_file(path);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.tracks = tracks;
+      }
+      catch (...)
+      {
+        qWarning() << "failed to read tracks from" << qtString(path);
+      }
+    });
+  }
+
+  // Load landmarks
+  if (!project.landmarks.isEmpty())
+  {
+    auto const path = stdString(project.landmarks);
+    d->enqueue([path](LoadState& state){
+      try
+      {
+        auto const& landmarks = kwiver::vital::read_ply_file(path);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.landmarks = landmarks;
+      }
+      catch (...)
+      {
+        qWarning() << "failed to read landmarks from" << qtString(path);
+      }
+    });
+  }
+
+  // Load cameras in chunks
+  if (!project.cameraPath.isEmpty())
+  {
+    auto const cameraDir = stdString(project.cameraPath);
+    auto const imageCount = project.images.count();
+
+    for (int first = 0; first < imageCount; first += CameraChunkSize)
+    {
+      auto const last = qMin(first + CameraChunkSize, imageCount);
+
+      auto paths = std::vector<std::string>{};
+      for (int i = first; i < last; ++i)
+      {
+        paths.push_back(stdString(project.images[i]));
+      }
+
+      auto const offset = firstFrame + first;
+      d->enqueue([paths, cameraDir, offset](LoadState& state){
+        auto cameras = kwiver::vital::camera_map::map_camera_t{};
+
+        for (size_t i = 0; i < paths.size() && !state.canceled; ++i)
+        {
+          try
+          {
+            auto const frame =
+              static_cast<kwiver::vital::frame_id_t>(offset + i);
+            cameras.emplace(frame, kwiver::vital::read_krtd_file(paths[i],
+                                                                 cameraDir));
+          }
+          catch (...)
+          {
+            qWarning() << "failed to read camera for"
+                       << qtString(paths[i]) << "from" << qtString(cameraDir);
+          }
+        }
+
+        auto const map =
+          std::make_shared<kwiver::vital::simple_camera_map>(cameras);
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.cameras.push_back(map);
+      });
+    }
+  }
+
+  if (!d->total)
+  {
+    // Nothing to do; report completion once control returns to the event loop
+    d->state->deliveryPending = true;
+    QMetaObject::invokeMethod(this, "deliverResults", Qt::QueuedConnection);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool ProjectLoader::isRunning() const
+{
+  QTE_D();
+  return d->running;
+}
+
+//-----------------------------------------------------------------------------
+bool ProjectLoader::isCanceled() const
+{
+  QTE_D();
+  return d->state && d->state->canceled;
+}
+
+//-----------------------------------------------------------------------------
+void ProjectLoader::cancel()
+{
+  QTE_D();
+
+  if (d->state)
+  {
+    d->state->canceled = true;
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ProjectLoader::deliverResults()
+{
+  QTE_D();
+
+  auto const state = d->state;
+  if (!state || !d->running)
+  {
+    return;
+  }
+
+  // Clear the pending flag first, so that results arriving while these are
+  // being delivered will request another delivery
+  state->deliveryPending = false;
+
+  auto tracks = kwiver::vital::feature_track_set_sptr{};
+  auto landmarks = kwiver::vital::landmark_map_sptr{};
+  auto cameras = std::vector<kwiver::vital::camera_map_sptr>{};
+  auto completed = 0;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    tracks.swap(state->tracks);
+    landmarks.swap(state->landmarks);
+    cameras.swap(state->cameras);
+    completed = state->completed;
+  }
+
+  if (!state->canceled)
+  {
+    if (tracks)
+    {
+      emit this->tracksLoaded(tracks);
+    }
+    if (landmarks)
+    {
+      emit this->landmarksLoaded(landmarks);
+    }
+    for (auto const& cm : cameras)
+    {
+      emit this->camerasLoaded(cm);
+    }
+  }
+
+  emit this->progress(completed, d->total);
+
+  if (completed >= d->total)
+  {
+    d->running = false;
+    d->jobs.clear();
+    emit this->finished();
+  }
+}
@@ -0,0 +1,106 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_PROJECTLOADER_H_
+#define MAPTK_PROJECTLOADER_H_
+
+#include <vital/types/camera_map.h>
+#include <vital/types/landmark_map.h>
+#include <vital/types/feature_track_set.h>
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+
+struct Project;
+
+class ProjectLoaderPrivate;
+
+/// Loads the data of a project in the background.
+///
+/// The loader reads the tracks, landmarks and cameras of a project
+/// concurrently using the shared thread pool; cameras are read in chunks. As
+/// each load completes, its results are delivered (on the thread that owns
+/// the loader) through the various \c *Loaded signals, so that they can be
+/// shown as they become available.
+class ProjectLoader : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ProjectLoader(QObject* parent = 0);
+  virtual ~ProjectLoader();
+
+  /// Start loading the data of \p project.
+  ///
+  /// Cameras are reported in maps keyed by the index of the image in the
+  /// project, offset by \p firstFrame. If a previous load is still running,
+  /// it is canceled, and any of its results not yet delivered are discarded.
+  /// In that case, #finished is not emitted for the previous load; it is
+  /// only emitted once, when the new load completes or is canceled.
+  void start(Project const& project, int firstFrame);
+
+  /// Test if a load is in progress.
+  bool isRunning() const;
+
+  /// Test if the most recent load was canceled.
+  bool isCanceled() const;
+
+public slots:
+  /// Cancel the load in progress.
+  ///
+  /// Reads already in progress are allowed to complete, but their results
+  /// are discarded. The #finished signal is emitted once all reads have
+  /// stopped.
+  void cancel();
+
+signals:
+  void tracksLoaded(kwiver::vital::feature_track_set_sptr);
+  void landmarksLoaded(kwiver::vital::landmark_map_sptr);
+  void camerasLoaded(kwiver::vital::camera_map_sptr);
+
+  /// Emitted when the number of completed reads changes.
+  void progress(int completed, int total);
+
+  /// Emitted when the load has completed or has been canceled, unless it was
+  /// superseded by a call to #start.
+  void finished();
+
+protected slots:
+  void deliverResults();
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(ProjectLoader)
+  QTE_DECLARE_PRIVATE(ProjectLoader)
+
+  QTE_DISABLE_COPY(ProjectLoader)
+};
+
+#endif
@@ -0,0 +1,898 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SessionCache.h"
+
+#include "Project.h"
+
+#include <maptk/compact_feature_tracks.h>
+#include <maptk/dense_landmark_map.h>
+
+#include <vital/types/camera.h>
+#include <vital/types/descriptor.h>
+#include <vital/types/feature.h>
+#include <vital/types/landmark.h>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace // anonymous
+{
+
+static char const Magic[8] = { 'M', 'T', 'K', 'S', 'E', 'S', 'S', 'N' };
+static quint32 const Version = 3;
+static quint32 const ByteOrderMark = 0x01020304;
+static int const MaxDistortionCoefficients = 8;
+
+enum DescriptorType
+{
+  NoDescriptor = 0,
+  DoubleDescriptor,
+  FloatDescriptor,
+  ByteDescriptor,
+};
+
+//-----------------------------------------------------------------------------
+struct Header
+{
+  char magic[8];
+  quint32 version;
+  quint32 byteOrder;
+  quint64 sourceCount;
+  quint64 sourcePathBytes;
+  quint64 cameraCount;
+  quint64 landmarkCount;
+  quint64 trackCount;
+  quint64 stateCount;
+  quint64 descriptorBytes;
+};
+
+//-----------------------------------------------------------------------------
+struct SourceRecord
+{
+  qint64 modified; // -1 if the file did not exist
+  qint64 size;
+  quint64 pathOffset;
+  quint64 pathLength;
+};
+
+//-----------------------------------------------------------------------------
+struct CameraRecord
+{
+  double center[3];
+  double rotation[4]; // quaternion x, y, z, w
+  double focalLength;
+  double principalPoint[2];
+  double aspectRatio;
+  double skew;
+  double distortion[MaxDistortionCoefficients];
+  qint32 imageDimensions[2];
+  quint32 distortionCount;
+  quint32 valid;
+};
+
+//-----------------------------------------------------------------------------
+struct LandmarkRecord
+{
+  qint64 id;
+  double location[3];
+  double scale;
+  quint32 observations;
+  quint8 color[3];
+  quint8 padding;
+};
+
+//-----------------------------------------------------------------------------
+struct TrackRecord
+{
+  qint64 id;
+  quint64 firstState;
+  quint64 stateCount;
+};
+
+//-----------------------------------------------------------------------------
+struct StateRecord
+{
+  qint64 frame;
+  double location[2];
+  double magnitude;
+  double scale;
+  double angle;
+  quint8 color[3];
+  quint8 hasFeature;
+  quint32 descriptorType;
+  quint64 descriptorOffset; // In bytes, from the start of descriptor data
+  quint64 descriptorSize; // In bytes
+};
+
+// Records are stored back to back, and must keep their successors aligned
+static_assert(sizeof(Header) % 8 == 0, "bad record size");
+static_assert(sizeof(SourceRecord) % 8 == 0, "bad record size");
+static_assert(sizeof(CameraRecord) % 8 == 0, "bad record size");
+static_assert(sizeof(LandmarkRecord) % 8 == 0, "bad record size");
+static_assert(sizeof(TrackRecord) % 8 == 0, "bad record size");
+static_assert(sizeof(StateRecord) % 8 == 0, "bad record size");
+
+//-----------------------------------------------------------------------------
+quint64 padded(quint64 bytes)
+{
+  return (bytes + 7) & ~quint64{7};
+}
+
+//-----------------------------------------------------------------------------
+SourceRecord sourceState(QString const& path)
+{
+  auto record = SourceRecord{-1, -1, 0, 0};
+
+  auto const fi = QFileInfo(path);
+  if (fi.exists())
+  {
+    record.modified = fi.lastModified().toMSecsSinceEpoch();
+    record.size = fi.size();
+  }
+
+  return record;
+}
+
+//-----------------------------------------------------------------------------
+struct DescriptorView
+{
+  DescriptorType type;
+  void const* data;
+  quint64 size; // In bytes
+};
+
+//-----------------------------------------------------------------------------
+template <typename T>
+bool viewDescriptor(kwiver::vital::descriptor const& descriptor,
+                    DescriptorType type, DescriptorView& view)
+{
+  auto const* const typed =
+    dynamic_cast<kwiver::vital::descriptor_array_of<T> const*>(&descriptor);
+  if (!typed)
+  {
+    return false;
+  }
+
+  view.type = type;
+  view.data = typed->raw_data();
+  view.size = static_cast<quint64>(sizeof(T) * typed->size());
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool viewDescriptor(kwiver::vital::track_state_sptr const& state,
+                    DescriptorView& view)
+{
+  view = DescriptorView{NoDescriptor, nullptr, 0};
+
+  auto const& fts =
+    std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
+  if (!fts || !fts->descriptor)
+  {
+    return true;
+  }
+
+  auto const& d = *fts->descriptor;
+  return viewDescriptor<double>(d, DoubleDescriptor, view) ||
+         viewDescriptor<float>(d, FloatDescriptor, view) ||
+         viewDescriptor<kwiver::vital::byte>(d, ByteDescriptor, view);
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+kwiver::vital::descriptor_sptr unpackDescriptor(
+  char const* data, quint64 size)
+{
+  auto const count = static_cast<size_t>(size / sizeof(T));
+  auto const& descriptor =
+    std::make_shared<kwiver::vital::descriptor_dynamic<T>>(count);
+  memcpy(descriptor->raw_data(), data, sizeof(T) * count);
+  return descriptor;
+}
+
+//-----------------------------------------------------------------------------
+class Writer
+{
+public:
+  Writer(QIODevice& out) : out(out), written(0), ok(true) {}
+
+  template <typename T>
+  void put(T const* data, size_t count)
+  {
+    static_assert(std::is_trivial<T>::value, "bad record type");
+    this->putBytes(data, sizeof(T) * count);
+  }
+
+  template <typename T>
+  void put(std::vector<T> const& data)
+  {
+    this->put(data.data(), data.size());
+  }
+
+  void putBytes(void const* data, quint64 size)
+  {
+    auto const bytes = static_cast<qint64>(size);
+    this->ok = this->ok &&
+      (bytes == 0 ||
+       this->out.write(static_cast<char const*>(data), bytes) == bytes);
+    this->written += size;
+  }
+
+  // Pad the data written so far to a multiple of 8 bytes
+  void align()
+  {
+    static char const zero[8] = {};
+    this->putBytes(zero, padded(this->written) - this->written);
+  }
+
+  QIODevice& out;
+  quint64 written;
+  bool ok;
+};
+
+//-----------------------------------------------------------------------------
+class Reader
+{
+public:
+  Reader(uchar const* data, qint64 size)
+    : pos(data), end(data + size) {}
+
+  template <typename T>
+  T const* take(quint64 count)
+  {
+    auto const available = static_cast<quint64>(this->end - this->pos);
+    if (count > available / sizeof(T))
+    {
+      this->pos = this->end;
+      return nullptr;
+    }
+
+    auto const bytes = padded(sizeof(T) * count);
+    auto const* const result = reinterpret_cast<T const*>(this->pos);
+    this->pos += qMin(bytes, available);
+    return result;
+  }
+
+  uchar const* pos;
+  uchar const* const end;
+};
+
+//-----------------------------------------------------------------------------
+CameraRecord cameraRecord(kwiver::vital::camera_sptr const& camera,
+                          QSize const& imageDimensions)
+{
+  auto r = CameraRecord{};
+  memset(&r, 0, sizeof(r));
+
+  r.imageDimensions[0] = imageDimensions.width();
+  r.imageDimensions[1] = imageDimensions.height();
+
+  if (!camera)
+  {
+    return r;
+  }
+
+  auto const& center = camera->center();
+  auto const& q = camera->rotation().quaternion();
+  auto const& ci = camera->intrinsics();
+  auto const& pp = ci->principal_point();
+  auto const& distortion = ci->dist_coeffs();
+
+  r.valid = 1;
+  r.center[0] = center[0];
+  r.center[1] = center[1];
+  r.center[2] = center[2];
+  r.rotation[0] = q.x();
+  r.rotation[1] = q.y();
+  r.rotation[2] = q.z();
+  r.rotation[3] = q.w();
+  r.focalLength = ci->focal_length();
+  r.principalPoint[0] = pp[0];
+  r.principalPoint[1] = pp[1];
+  r.aspectRatio = ci->aspect_ratio();
+  r.skew = ci->skew();
+
+  // The caller has checked that the coefficients fit
+  r.distortionCount = static_cast<quint32>(distortion.size());
+  std::copy(distortion.begin(), distortion.end(), r.distortion);
+
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+LandmarkRecord landmarkRecord(kwiver::vital::landmark_id_t id,
+                              kwiver::vital::landmark const& lm)
+{
+  auto const& loc = lm.loc();
+  auto const& color = lm.color();
+
+  auto r = LandmarkRecord{};
+  r.id = static_cast<qint64>(id);
+  r.location[0] = loc[0];
+  r.location[1] = loc[1];
+  r.location[2] = loc[2];
+  r.scale = lm.scale();
+  r.observations = static_cast<quint32>(lm.observations());
+  r.color[0] = color.r;
+  r.color[1] = color.g;
+  r.color[2] = color.b;
+  r.padding = 0;
+
+  return r;
+}
+
+//-----------------------------------------------------------------------------
+StateRecord stateRecord(kwiver::vital::track_state_sptr const& state)
+{
+  auto s = StateRecord{};
+  memset(&s, 0, sizeof(s));
+  s.frame = static_cast<qint64>(state->frame());
+
+  auto const& fts =
+    std::dynamic_pointer_cast<kwiver::vital::feature_track_state>(state);
+  if (fts && fts->feature)
+  {
+    auto const& loc = fts->feature->loc();
+    auto const& color = fts->feature->color();
+
+    s.hasFeature = 1;
+    s.location[0] = loc[0];
+    s.location[1] = loc[1];
+    s.magnitude = fts->feature->magnitude();
+    s.scale = fts->feature->scale();
+    s.angle = fts->feature->angle();
+    s.color[0] = color.r;
+    s.color[1] = color.g;
+    s.color[2] = color.b;
+  }
+
+  return s;
+}
+
+//-----------------------------------------------------------------------------
+struct Layout
+{
+  quint64 size() const;
+
+  Header header;
+  std::vector<SourceRecord> sourceRecords;
+  QByteArray sourcePaths;
+  std::vector<kwiver::vital::track_sptr> tracks;
+};
+
+//-----------------------------------------------------------------------------
+quint64 Layout::size() const
+{
+  auto const& h = this->header;
+  return sizeof(Header) +
+         sizeof(SourceRecord) * h.sourceCount + padded(h.sourcePathBytes) +
+         sizeof(CameraRecord) * h.cameraCount +
+         sizeof(LandmarkRecord) * h.landmarkCount +
+         sizeof(TrackRecord) * h.trackCount +
+         sizeof(StateRecord) * h.stateCount + padded(h.descriptorBytes);
+}
+
+//-----------------------------------------------------------------------------
+bool layoutCache(SessionCache const& cache, QStringList const& sources,
+                 Layout& layout)
+{
+  // Build source records
+  foreach (auto const& source, sources)
+  {
+    auto const& path = source.toUtf8();
+    auto record = sourceState(source);
+    record.pathOffset = static_cast<quint64>(layout.sourcePaths.size());
+    record.pathLength = static_cast<quint64>(path.size());
+
+    layout.sourceRecords.push_back(record);
+    layout.sourcePaths.append(path);
+  }
+
+  // Check that every camera can be represented, so that a cache which would
+  // lose information is never written
+  for (size_t i = 0; i < cache.cameras.size(); ++i)
+  {
+    auto const& camera = cache.cameras[i];
+    if (camera &&
+        camera->intrinsics()->dist_coeffs().size() >
+          MaxDistortionCoefficients)
+    {
+      qWarning() << "Camera" << i << "has too many distortion coefficients"
+                    " to cache";
+      return false;
+    }
+  }
+
+  // Count track states and descriptor data
+  if (cache.tracks)
+  {
+    layout.tracks = cache.tracks->tracks();
+  }
+
+  auto stateCount = quint64{0};
+  auto descriptorBytes = quint64{0};
+  for (auto const& track : layout.tracks)
+  {
+    for (auto const& state : *track)
+    {
+      auto view = DescriptorView{};
+      if (!viewDescriptor(state, view))
+      {
+        qWarning() << "Track" << track->id() << "has a descriptor of a type"
+                      " which cannot be cached";
+        return false;
+      }
+
+      ++stateCount;
+      descriptorBytes += view.size;
+    }
+  }
+
+  auto& header = layout.header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.byteOrder = ByteOrderMark;
+  header.sourceCount = layout.sourceRecords.size();
+  header.sourcePathBytes = static_cast<quint64>(layout.sourcePaths.size());
+  header.cameraCount = cache.cameras.size();
+  header.landmarkCount = (cache.landmarks ? cache.landmarks->size() : 0);
+  header.trackCount = layout.tracks.size();
+  header.stateCount = stateCount;
+  header.descriptorBytes = descriptorBytes;
+
+  return true;
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+QString SessionCache::path(QString const& projectPath)
+{
+  return projectPath + ".session";
+}
+
+//-----------------------------------------------------------------------------
+QStringList SessionCache::sources(
+  QString const& projectPath, Project const& project)
+{
+  auto sources = QStringList{};
+
+  sources.append(QFileInfo(projectPath).absoluteFilePath());
+  sources.append(project.tracks);
+  sources.append(project.landmarks);
+
+  if (!project.cameraPath.isEmpty())
+  {
+    auto const cameraDir = QDir(project.cameraPath);
+    foreach (auto const& ip, project.images)
+    {
+      auto const& baseName = QFileInfo(ip).completeBaseName();
+      sources.append(cameraDir.filePath(baseName + ".krtd"));
+    }
+  }
+
+  // The images themselves determine the cached image dimensions
+  sources.append(project.images);
+
+  return sources;
+}
+
+//-----------------------------------------------------------------------------
+bool SessionCache::read(QString const& path, QStringList const& sources)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    return false;
+  }
+
+  auto const size = file.size();
+  auto const* const data = file.map(0, size);
+  if (!data)
+  {
+    return false;
+  }
+
+  auto const result = this->read(data, size, sources);
+  file.unmap(const_cast<uchar*>(data));
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+bool SessionCache::read(
+  uchar const* data, qint64 size, QStringList const& sources)
+{
+  Reader in(data, size);
+
+  // Check header
+  auto const* const header = in.take<Header>(1);
+  if (!header ||
+      memcmp(header->magic, Magic, sizeof(Magic)) != 0 ||
+      header->version != Version || header->byteOrder != ByteOrderMark)
+  {
+    return false;
+  }
+
+  // Check sources
+  auto const* const sourceRecords = in.take<SourceRecord>(header->sourceCount);
+  auto const* const sourcePaths = in.take<char>(header->sourcePathBytes);
+  if (!sourceRecords || !sourcePaths)
+  {
+    return false;
+  }
+
+  if (!sources.isEmpty())
+  {
+    if (header->sourceCount != static_cast<quint64>(sources.count()))
+    {
+      return false;
+    }
+
+    for (int i = 0; i < sources.count(); ++i)
+    {
+      auto const& record = sourceRecords[i];
+      if (record.pathOffset > header->sourcePathBytes ||
+          record.pathLength > header->sourcePathBytes - record.pathOffset)
+      {
+        return false;
+      }
+
+      auto const& expectedPath = sources[i].toUtf8();
+      auto const& expectedState = sourceState(sources[i]);
+      if (record.pathLength != static_cast<quint64>(expectedPath.size()) ||
+          memcmp(sourcePaths + record.pathOffset, expectedPath.constData(),
+                 expectedPath.size()) != 0 ||
+          record.modified != expectedState.modified ||
+          record.size != expectedState.size)
+      {
+        return false;
+      }
+    }
+  }
+
+  // Get data sections
+  auto const* const cameraRecords =
+    in.take<CameraRecord>(header->cameraCount);
+  auto const* const landmarkRecords =
+    in.take<LandmarkRecord>(header->landmarkCount);
+  auto const* const trackRecords =
+    in.take<TrackRecord>(header->trackCount);
+  auto const* const stateRecords =
+    in.take<StateRecord>(header->stateCount);
+  auto const* const descriptorData = in.take<char>(header->descriptorBytes);
+  if (!cameraRecords || !landmarkRecords || !trackRecords ||
+      !stateRecords || !descriptorData)
+  {
+    qWarning() << "Session cache is truncated";
+    return false;
+  }
+
+  // Restore cameras
+  this->cameras.assign(header->cameraCount, kwiver::vital::camera_sptr{});
+  this->imageDimensions.assign(header->cameraCount, QSize{});
+  for (size_t i = 0; i < header->cameraCount; ++i)
+  {
+    auto const& r = cameraRecords[i];
+    this->imageDimensions[i] =
+      QSize{r.imageDimensions[0], r.imageDimensions[1]};
+
+    if (r.valid)
+    {
+      auto const dc = qMin(r.distortionCount,
+                           static_cast<quint32>(MaxDistortionCoefficients));
+      Eigen::VectorXd distortion(dc);
+      for (quint32 k = 0; k < dc; ++k)
+      {
+        distortion[k] = r.distortion[k];
+      }
+
+      auto const intrinsics =
+        kwiver::vital::simple_camera_intrinsics{
+          r.focalLength,
+          kwiver::vital::vector_2d{r.principalPoint[0], r.principalPoint[1]},
+          r.aspectRatio, r.skew, distortion};
+      auto const rotation = kwiver::vital::rotation_d{
+        Eigen::Quaterniond{r.rotation[3], r.rotation[0],
+                           r.rotation[1], r.rotation[2]}};
+      auto const center =
+        kwiver::vital::vector_3d{r.center[0], r.center[1], r.center[2]};
+
+      this->cameras[i] = kwiver::vital::simple_camera{
+        center, rotation, intrinsics}.clone();
+    }
+  }
+
+  // Restore landmarks; their ids are normally (nearly) contiguous, in which
+  // case they are held in flat arrays rather than as separate objects
+  auto const firstLandmark = landmarkRecords;
+  auto const lastLandmark = landmarkRecords + header->landmarkCount;
+  auto const landmarkIds = std::minmax_element(
+    firstLandmark, lastLandmark,
+    [](LandmarkRecord const& a, LandmarkRecord const& b){
+      return a.id < b.id; });
+  auto const landmarkIdSpan =
+    (firstLandmark == lastLandmark ? quint64{0} :
+     static_cast<quint64>(landmarkIds.second->id) -
+     static_cast<quint64>(landmarkIds.first->id));
+  auto const useDenseLandmarks =
+    landmarkIdSpan < 2 * quint64{header->landmarkCount} + 1024;
+
+  auto denseLandmarks = std::shared_ptr<kwiver::maptk::dense_landmark_map>{};
+  if (useDenseLandmarks)
+  {
+    denseLandmarks = std::make_shared<kwiver::maptk::dense_landmark_map>();
+  }
+
+  auto landmarkMap = kwiver::vital::landmark_map::map_landmark_t{};
+  for (size_t i = 0; i < header->landmarkCount; ++i)
+  {
+    auto const& r = landmarkRecords[i];
+    auto const& lm = std::make_shared<kwiver::vital::landmark_d>(
+      kwiver::vital::vector_3d{r.location[0], r.location[1], r.location[2]},
+      r.scale);
+    lm->set_color({r.color[0], r.color[1], r.color[2]});
+    lm->set_observations(r.observations);
+
+    auto const id = static_cast<kwiver::vital::landmark_id_t>(r.id);
+    if (denseLandmarks)
+    {
+      denseLandmarks->insert(id, lm);
+    }
+    else
+    {
+      landmarkMap.emplace_hint(landmarkMap.end(), id, lm);
+    }
+  }
+  if (denseLandmarks)
+  {
+    this->landmarks = denseLandmarks;
+  }
+  else
+  {
+    this->landmarks =
+      std::make_shared<kwiver::vital::simple_landmark_map>(landmarkMap);
+  }
+
+  // Restore tracks into compact storage, which holds the observations in
+  // flat arrays; track and state objects are only created when used
+  auto order = std::vector<size_t>(header->trackCount);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [trackRecords](size_t a, size_t b)
+                   { return trackRecords[a].id < trackRecords[b].id; });
+
+  auto const& store = std::make_shared<kwiver::maptk::compact_feature_tracks>();
+  for (size_t n = 0; n < order.size(); ++n)
+  {
+    auto const& r = trackRecords[order[n]];
+    if (r.firstState > header->stateCount ||
+        r.stateCount > header->stateCount - r.firstState ||
+        (n > 0 && r.id == trackRecords[order[n - 1]].id))
+    {
+      qWarning() << "Session cache has invalid track states";
+      return false;
+    }
+
+    store->add_track(static_cast<kwiver::vital::track_id_t>(r.id));
+
+    auto const* const states = stateRecords + r.firstState;
+    for (size_t k = 0; k < r.stateCount; ++k)
+    {
+      auto const& s = states[k];
+      if (!s.hasFeature)
+      {
+        continue;
+      }
+
+      auto descriptor = kwiver::maptk::compact_feature_tracks::no_descriptor;
+      if (s.descriptorType != NoDescriptor)
+      {
+        if (s.descriptorOffset > header->descriptorBytes ||
+            s.descriptorSize > header->descriptorBytes - s.descriptorOffset)
+        {
+          qWarning() << "Session cache has invalid descriptors";
+          return false;
+        }
+
+        auto const* const d = descriptorData + s.descriptorOffset;
+        switch (s.descriptorType)
+        {
+          case DoubleDescriptor:
+            descriptor = store->add_descriptor(
+              unpackDescriptor<double>(d, s.descriptorSize));
+            break;
+          case FloatDescriptor:
+            descriptor = store->add_descriptor(
+              unpackDescriptor<float>(d, s.descriptorSize));
+            break;
+          case ByteDescriptor:
+            descriptor = store->add_descriptor(
+              unpackDescriptor<kwiver::vital::byte>(d, s.descriptorSize));
+            break;
+          default:
+            break;
+        }
+      }
+
+      auto const feature = kwiver::vital::feature_d{
+        kwiver::vital::vector_2d{s.location[0], s.location[1]},
+        s.magnitude, s.scale, s.angle,
+        kwiver::vital::rgb_color{s.color[0], s.color[1], s.color[2]}};
+      store->add_observation(static_cast<kwiver::vital::frame_id_t>(s.frame),
+                             feature, descriptor);
+    }
+  }
+  store->index_frames();
+
+  this->tracks = kwiver::maptk::make_compact_feature_track_set(store);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool SessionCache::write(QString const& path, QStringList const& sources) const
+{
+  // Write to a temporary file, then replace the old cache, so that a reader
+  // never sees a partially written cache
+  auto const tempPath = path + ".tmp";
+  QFile file(tempPath);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qWarning() << "Failed to open session cache" << tempPath
+               << "for writing:" << file.errorString();
+    return false;
+  }
+
+  if (!this->write(file, sources))
+  {
+    qWarning() << "Failed to write session cache" << tempPath;
+    file.close();
+    file.remove();
+    return false;
+  }
+
+  file.close();
+  QFile::remove(path);
+  return file.rename(path);
+}
+
+//-----------------------------------------------------------------------------
+qint64 SessionCache::size(QStringList const& sources) const
+{
+  auto layout = Layout{};
+  if (!layoutCache(*this, sources, layout))
+  {
+    return -1;
+  }
+
+  return static_cast<qint64>(layout.size());
+}
+
+//-----------------------------------------------------------------------------
+bool SessionCache::write(QIODevice& out, QStringList const& sources) const
+{
+  auto layout = Layout{};
+  if (!layoutCache(*this, sources, layout))
+  {
+    return false;
+  }
+
+  // Records are written one at a time as they are built, so the data is
+  // never copied as a whole
+  Writer writer(out);
+  writer.put(&layout.header, 1);
+
+  // Write sources
+  writer.put(layout.sourceRecords);
+  writer.putBytes(layout.sourcePaths.constData(),
+                  layout.header.sourcePathBytes);
+  writer.align();
+
+  // Write cameras
+  for (size_t i = 0; i < this->cameras.size(); ++i)
+  {
+    auto const& dims = (i < this->imageDimensions.size()
+                        ? this->imageDimensions[i] : QSize{0, 0});
+    auto const& r = cameraRecord(this->cameras[i], dims);
+    writer.put(&r, 1);
+  }
+
+  // Write landmarks
+  if (this->landmarks)
+  {
+    for (auto const& lmi : this->landmarks->landmarks())
+    {
+      auto const& r = landmarkRecord(lmi.first, *lmi.second);
+      writer.put(&r, 1);
+    }
+  }
+
+  // Write tracks
+  auto firstState = quint64{0};
+  for (auto const& track : layout.tracks)
+  {
+    auto t = TrackRecord{};
+    t.id = static_cast<qint64>(track->id());
+    t.firstState = firstState;
+    t.stateCount = static_cast<quint64>(track->size());
+    writer.put(&t, 1);
+
+    firstState += t.stateCount;
+  }
+
+  // Write track states; descriptors follow in the same order
+  auto descriptorOffset = quint64{0};
+  for (auto const& track : layout.tracks)
+  {
+    for (auto const& state : *track)
+    {
+      auto view = DescriptorView{};
+      viewDescriptor(state, view);
+
+      auto s = stateRecord(state);
+      if (view.type != NoDescriptor)
+      {
+        s.descriptorType = view.type;
+        s.descriptorOffset = descriptorOffset;
+        s.descriptorSize = view.size;
+        descriptorOffset += view.size;
+      }
+      writer.put(&s, 1);
+    }
+  }
+
+  // Write descriptor data
+  for (auto const& track : layout.tracks)
+  {
+    for (auto const& state : *track)
+    {
+      auto view = DescriptorView{};
+      viewDescriptor(state, view);
+      writer.putBytes(view.data, view.size);
+    }
+  }
+  writer.align();
+
+  // The data must not have changed since it was laid out
+  return writer.ok && writer.written == layout.size();
+}
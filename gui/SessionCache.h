@@ -0,0 +1,107 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_SESSIONCACHE_H_
+#define MAPTK_SESSIONCACHE_H_
+
+#include <vital/types/camera.h>
+#include <vital/types/feature_track_set.h>
+#include <vital/types/landmark_map.h>
+
+#include <QtCore/QSize>
+#include <QtCore/QStringList>
+
+#include <vector>
+
+class QIODevice;
+
+struct Project;
+
+/// Binary snapshot of the data of a loaded project.
+///
+/// The session cache holds the cameras (and their image dimensions), tracks
+/// (including feature descriptors) and landmarks of a project in a flat
+/// binary format which is read directly from a memory
+/// mapping of the cache file, so that a project can be reopened without
+/// parsing its source files. The same format is used to exchange data with
+/// tools running in a worker process. The cache
+/// records the modification time and size of each source file from which the
+/// data was loaded, and is rejected if any of these have changed.
+struct SessionCache
+{
+  /// Get the path of the session cache for the project at \p projectPath.
+  static QString path(QString const& projectPath);
+
+  /// Get the list of source files of a project.
+  static QStringList sources(QString const& projectPath,
+                             Project const& project);
+
+  /// Read the session cache from \p path.
+  ///
+  /// Returns \c false if the cache does not exist, is not valid, or does not
+  /// match the current state of \p sources.
+  bool read(QString const& path, QStringList const& sources);
+
+  /// Read the session cache from a buffer.
+  ///
+  /// If \p sources is not empty, the cache is rejected if it was not
+  /// written for the same source files in their current state.
+  bool read(uchar const* data, qint64 size, QStringList const& sources);
+
+  /// Write the session cache to \p path.
+  bool write(QString const& path, QStringList const& sources) const;
+
+  /// Write the session cache to \p out.
+  ///
+  /// Records are written to \p out as they are built, so writing does not
+  /// hold a second copy of the data in memory.
+  bool write(QIODevice& out, QStringList const& sources) const;
+
+  /// Get the number of bytes #write will write, or -1 if the cache cannot
+  /// be written.
+  qint64 size(QStringList const& sources) const;
+
+  /// Cameras, indexed by frame; missing cameras are null.
+  std::vector<kwiver::vital::camera_sptr> cameras;
+
+  /// Image dimensions, indexed by frame.
+  std::vector<QSize> imageDimensions;
+
+  /// Feature tracks.
+  ///
+  /// On a successful read, the tracks are restored into a compact store
+  /// (see kwiver::maptk::compact_feature_tracks), which keeps feature
+  /// positions in single precision and drops track states without a
+  /// feature.
+  kwiver::vital::feature_track_set_sptr tracks;
+  kwiver::vital::landmark_map_sptr landmarks;
+};
+
+#endif
@@ -38,25 +38,28 @@
 #include "DepthMapOptions.h"
 #include "FieldInformation.h"
 #include "ImageOptions.h"
+#include "IsosurfaceExtractor.h"
 #include "PointOptions.h"
 #include "VolumeOptions.h"
 #include "vtkMaptkImageUnprojectDepth.h"
 #include "vtkMaptkCamera.h"
 #include "vtkMaptkCameraRepresentation.h"
+#include "vtkMaptkOctreePointLOD.h"
 #include "vtkMaptkScalarDataFilter.h"
 
 #include <vital/types/camera.h>
 #include <vital/types/landmark_map.h>
 
 #include <vtkBoundingBox.h>
+#include <vtkCamera.h>
 #include <vtkCellArray.h>
-#include <vtkCellDataToPointData.h>
-#include <vtkContourFilter.h>
 #include <vtkCubeAxesActor.h>
 #include <vtkDoubleArray.h>
+#include <vtkEventQtSlotConnect.h>
 #include <vtkGeometryFilter.h>
 #include <vtkImageActor.h>
 #include <vtkImageData.h>
+#include <vtkImageDataToPointSet.h>
 #include <vtkMaptkImageDataGeometryFilter.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -68,15 +71,15 @@
 #include <vtkProperty.h>
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
-#include <vtkStructuredGrid.h>
+#include <vtkSmartPointer.h>
 #include <vtkTextProperty.h>
 #include <vtkThreshold.h>
 #include <vtkTimeStamp.h>
 #include <vtkUnsignedCharArray.h>
 #include <vtkUnsignedIntArray.h>
 #include <vtkXMLImageDataReader.h>
+#include <vtkXMLImageDataWriter.h>
 #include <vtkXMLPolyDataWriter.h>
-#include <vtkXMLStructuredGridReader.h>
 #include <vtkXMLStructuredGridWriter.h>
 
 
@@ -93,13 +96,44 @@
 #include <QtGui/QWidgetAction>
 
 #include <QtCore/QDebug>
+#include <QtCore/QTimer>
 
 #include <QFileInfo>
 
+#include <array>
+
 using namespace LandmarkArrays;
 
 QTE_IMPLEMENT_D_FUNC(WorldView)
 
+namespace // anonymous
+{
+
+// Number of landmarks drawn while the view is changing
+static auto const InteractiveLandmarkBudget = vtkIdType{250000};
+
+// Delay after the view stops changing before landmark detail is refined, and
+// between refinement steps
+static auto const LandmarkRefineInterval = 200;
+
+typedef std::array<double, 12> ViewState;
+
+//-----------------------------------------------------------------------------
+ViewState viewState(vtkCamera* camera, double aspect)
+{
+  auto state = ViewState{};
+  camera->GetPosition(state.data() + 0);
+  camera->GetFocalPoint(state.data() + 3);
+  camera->GetViewUp(state.data() + 6);
+  state[9] = camera->GetViewAngle();
+  state[10] = (camera->GetParallelProjection()
+               ? camera->GetParallelScale() : -1.0);
+  state[11] = aspect;
+  return state;
+}
+
+} // namespace <anonymous>
+
 //-----------------------------------------------------------------------------
 class WorldViewPrivate
 {
@@ -112,7 +146,9 @@ public:
       cameraRepDirty(false),
       scaleDirty(false),
       axesDirty(false),
-      axesVisible(false)
+      axesVisible(false),
+      landmarkBudget(InteractiveLandmarkBudget),
+      visibleLandmarks(0)
   {
   }
 
@@ -128,6 +164,7 @@ public:
   void updateCameras(WorldView*);
   void updateScale(WorldView*);
   void updateAxes(WorldView*, bool immediate = false);
+  void selectLandmarks();
 
   Ui::WorldView UI;
   Am::WorldView AM;
@@ -145,6 +182,10 @@ public:
   vtkNew<vtkPolyDataMapper> landmarkMapper;
   vtkNew<vtkActor> landmarkActor;
 
+  vtkNew<vtkMaptkOctreePointLOD> landmarkLOD;
+  vtkNew<vtkEventQtSlotConnect> vtkConnect;
+  QTimer landmarkRefineTimer;
+
   vtkNew<vtkImageActor> imageActor;
   vtkNew<vtkImageData> emptyImage;
 
@@ -159,7 +200,7 @@ public:
   DepthMapOptions* depthMapOptions;
 
   VolumeOptions* volumeOptions;
-  vtkContourFilter* contourFilter;
+  IsosurfaceExtractor* isosurface;
 
   vtkNew<vtkMatrix4x4> imageProjection;
   vtkNew<vtkMatrix4x4> imageLocalTransform;
@@ -169,7 +210,7 @@ public:
   vtkNew<vtkActor> depthMapActor;
 
   vtkNew<vtkActor> volumeActor;
-  vtkStructuredGrid* volume;
+  vtkNew<vtkPolyData> volumeSurface;
 
   bool rangeUpdateNeeded;
   bool validDepthInput;
@@ -181,6 +222,10 @@ public:
   bool axesDirty;
 
   bool axesVisible;
+
+  ViewState landmarkView;
+  vtkIdType landmarkBudget;
+  vtkIdType visibleLandmarks;
 };
 
 //-----------------------------------------------------------------------------
@@ -292,6 +337,17 @@ void WorldViewPrivate::updateAxes(WorldView* q, bool immediate)
   }
 }
 
+//-----------------------------------------------------------------------------
+void WorldViewPrivate::selectLandmarks()
+{
+  auto const camera = this->renderer->GetActiveCamera();
+  auto const aspect = this->renderer->GetTiledAspectRatio();
+
+  this->landmarkView = viewState(camera, aspect);
+  this->visibleLandmarks = this->landmarkLOD->SelectPoints(
+    camera, aspect, this->landmarkBudget, this->landmarkVerts.GetPointer());
+}
+
 //-----------------------------------------------------------------------------
 WorldView::WorldView(QWidget* parent, Qt::WindowFlags flags)
   : QWidget(parent, flags), d_ptr(new WorldViewPrivate)
@@ -361,6 +417,11 @@ WorldView::WorldView(QWidget* parent, Qt::WindowFlags flags)
   connect(this, SIGNAL(contourChanged()),
           d->UI.renderWidget, SLOT(update()));
 
+  d->isosurface = new IsosurfaceExtractor(this);
+
+  connect(d->isosurface, SIGNAL(surfaceChanged()),
+          this, SLOT(updateContour()));
+
   // Connect actions
   this->addAction(d->UI.actionViewReset);
   this->addAction(d->UI.actionViewResetLandmarks);
@@ -454,6 +515,16 @@ WorldView::WorldView(QWidget* parent, Qt::WindowFlags flags)
 
   d->landmarkOptions->addMapper(d->landmarkMapper.GetPointer());
 
+  // Set up landmark level of detail; the points drawn are reselected when a
+  // render starts with the view changed, and refined once the view is still
+  d->landmarkRefineTimer.setSingleShot(true);
+  d->landmarkRefineTimer.setInterval(LandmarkRefineInterval);
+
+  connect(&d->landmarkRefineTimer, SIGNAL(timeout()),
+          this, SLOT(refineLandmarks()));
+  d->vtkConnect->Connect(d->renderer.GetPointer(), vtkCommand::StartEvent,
+                         this, SLOT(updateLandmarkDetail()));
+
   // Set up ground plane grid
   d->groundPlane->SetOrigin(-10.0, -10.0, 0.0);
   d->groundPlane->SetPoint1(+10.0, -10.0, 0.0);
@@ -670,32 +741,15 @@ void WorldView::loadVolume(QString path, int nbFrames, QString krtd, QString fra
 
   d->UI.actionShowVolume->setEnabled(true);
 
-  std::string filename = path.toStdString();
-
-  // Create the vtk pipeline
-  // Read volume
-  vtkNew<vtkXMLStructuredGridReader> readerV;
-  readerV->SetFileName(filename.c_str());
-
-  d->volume = readerV->GetOutput();
-  // Transform cell data to point data for contour filter
-  vtkNew<vtkCellDataToPointData> transformCellToPointData;
-  transformCellToPointData->SetInputConnection(readerV->GetOutputPort());
-  transformCellToPointData->PassCellDataOn();
-
-  // Apply contour
-  d->contourFilter = vtkContourFilter::New();
-  d->contourFilter->SetInputConnection(transformCellToPointData->GetOutputPort());
-  d->contourFilter->SetNumberOfContours(1);
-  d->contourFilter->SetValue(0, 0.5);
-  // Declare which table will be use for the contour
-  d->contourFilter->SetInputArrayToProcess(0, 0, 0,
-                                           vtkDataObject::FIELD_ASSOCIATION_POINTS,
-                                           "reconstruction_scalar");
-
-  // Create mapper
+  // Read volume and extract the initial surface in the background
+  d->isosurface->loadVolume(path, "reconstruction_scalar");
+  d->isosurface->setThreshold(0.5);
+
+  // Create mapper; the surface is updated as it is extracted
+  d->volumeSurface->Initialize();
+
   vtkNew<vtkPolyDataMapper> contourMapper;
-  contourMapper->SetInputConnection(d->contourFilter->GetOutputPort());
+  contourMapper->SetInputData(d->volumeSurface.GetPointer());
   contourMapper->SetColorModeToDirectScalars();
 
   // Set the actor's mapper
@@ -733,14 +787,34 @@ void WorldView::computeContour(double threshold)
 {
   QTE_D();
 
-  d->contourFilter->SetValue(0, threshold);
-  d->UI.renderWidget->update();
+  d->isosurface->setThreshold(threshold);
+}
+
+//-----------------------------------------------------------------------------
+void WorldView::updateContour()
+{
+  QTE_D();
+
+  // Show the surface (or its preview) for the current threshold
+  auto const surface = d->isosurface->surface();
+  if (surface)
+  {
+    d->volumeSurface->ShallowCopy(surface);
+  }
+  else
+  {
+    d->volumeSurface->Initialize();
+  }
+  d->volumeSurface->Modified();
 
-  if(d->volumeOptions->isColorOptionsEnabled())
+  // Colorizing is expensive, so only colorize the final surface
+  if (surface && !d->isosurface->isPreview() &&
+      d->volumeOptions->isColorOptionsEnabled())
   {
     d->volumeOptions->colorize();
   }
 
+  emit this->contourChanged();
 }
 
 //-----------------------------------------------------------------------------
@@ -815,32 +889,50 @@ void WorldView::setLandmarks(kwiver::vital::landmark_map const& lm)
   auto maxObservations = unsigned{0};
   auto minZ = qInf(), maxZ = -qInf();
 
-  d->landmarkPoints->Reset();
-  d->landmarkVerts->Reset();
-  d->landmarkColors->Reset();
-  d->landmarkElevations->Reset();
-  d->landmarkObservations->Reset();
-  d->landmarkPoints->Allocate(size);
-  d->landmarkVerts->Allocate(size);
-  d->landmarkColors->Allocate(3 * size);
-  d->landmarkElevations->Allocate(size);
-  d->landmarkObservations->Allocate(size);
-
-  vtkIdType vertIndex = 0;
+  // Gather landmark positions and build the level of detail octree over them;
+  // the octree determines the order in which the landmarks are stored
+  std::vector<kwiver::vital::landmark const*> items;
+  std::vector<double> positions;
+  items.reserve(landmarks.size());
+  positions.reserve(3 * landmarks.size());
   foreach (auto const& lm, landmarks)
   {
     auto const& pos = lm.second->loc();
-    auto const& color = lm.second->color();
-    auto const observations = lm.second->observations();
-
-    d->landmarkPoints->InsertNextPoint(pos.data());
-    d->landmarkVerts->InsertNextCell(1);
-    d->landmarkVerts->InsertCellPoint(vertIndex++);
-    d->landmarkColors->InsertNextValue(color.r);
-    d->landmarkColors->InsertNextValue(color.g);
-    d->landmarkColors->InsertNextValue(color.b);
-    d->landmarkElevations->InsertNextValue(pos[2]);
-    d->landmarkObservations->InsertNextValue(observations);
+    items.push_back(lm.second.get());
+    positions.insert(positions.end(), pos.data(), pos.data() + 3);
+  }
+
+  d->landmarkLOD->Build(positions.data(), size);
+  auto const order = d->landmarkLOD->GetPointOrder();
+
+  // Fill pre-sized arrays in place
+  d->landmarkPoints->SetDataTypeToFloat();
+  d->landmarkPoints->SetNumberOfPoints(size);
+  d->landmarkColors->SetNumberOfTuples(size);
+  d->landmarkElevations->SetNumberOfTuples(size);
+  d->landmarkObservations->SetNumberOfTuples(size);
+
+  auto const pointData = static_cast<float*>(
+    d->landmarkPoints->GetData()->GetVoidPointer(0));
+  auto const colorData = d->landmarkColors->GetPointer(0);
+  auto const elevationData = d->landmarkElevations->GetPointer(0);
+  auto const observationData = d->landmarkObservations->GetPointer(0);
+
+  for (vtkIdType i = 0; i < size; ++i)
+  {
+    auto const& landmark = *items[static_cast<size_t>(order[i])];
+    auto const& pos = landmark.loc();
+    auto const& color = landmark.color();
+    auto const observations = landmark.observations();
+
+    pointData[(3 * i) + 0] = static_cast<float>(pos[0]);
+    pointData[(3 * i) + 1] = static_cast<float>(pos[1]);
+    pointData[(3 * i) + 2] = static_cast<float>(pos[2]);
+    colorData[(3 * i) + 0] = color.r;
+    colorData[(3 * i) + 1] = color.g;
+    colorData[(3 * i) + 2] = color.b;
+    elevationData[i] = pos[2];
+    observationData[i] = observations;
 
     haveColor = haveColor || (color != defaultColor);
     maxObservations = qMax(maxObservations, observations);
@@ -860,10 +952,15 @@ void WorldView::setLandmarks(kwiver::vital::landmark_map const& lm)
   d->landmarkOptions->setDataFields(fields);
 
   d->landmarkPoints->Modified();
-  d->landmarkVerts->Modified();
   d->landmarkColors->Modified();
+  d->landmarkElevations->Modified();
   d->landmarkObservations->Modified();
 
+  // Select the initial set of landmarks to draw
+  d->landmarkBudget = InteractiveLandmarkBudget;
+  d->selectLandmarks();
+  d->landmarkRefineTimer.start();
+
   d->updateScale(this);
   d->updateAxes(this);
 }
@@ -1140,6 +1237,42 @@ void WorldView::updateScale()
   }
 }
 
+//-----------------------------------------------------------------------------
+void WorldView::updateLandmarkDetail()
+{
+  QTE_D();
+
+  auto const camera = d->renderer->GetActiveCamera();
+  auto const aspect = d->renderer->GetTiledAspectRatio();
+
+  if (viewState(camera, aspect) != d->landmarkView)
+  {
+    // View is changing; drop back to the interactive budget and wait for the
+    // view to be still before refining
+    d->landmarkBudget = InteractiveLandmarkBudget;
+    d->selectLandmarks();
+    d->landmarkRefineTimer.start();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void WorldView::refineLandmarks()
+{
+  QTE_D();
+
+  if (d->landmarkBudget < d->visibleLandmarks)
+  {
+    d->landmarkBudget *= 4;
+    d->selectLandmarks();
+    d->UI.renderWidget->update();
+
+    if (d->landmarkBudget < d->visibleLandmarks)
+    {
+      d->landmarkRefineTimer.start();
+    }
+  }
+}
+
 //-----------------------------------------------------------------------------
 void WorldView::updateDepthMapDisplayMode()
 {
@@ -1228,17 +1361,23 @@ void WorldView::saveMesh(const QString &path)
 {
   QTE_D();
 
-  vtkPolyData* mesh = d->contourFilter->GetOutput();
-
-  for (int i = 0; i < mesh->GetPointData()->GetNumberOfArrays(); ++i)
+  // Save the full resolution surface, without its point data, rather than
+  // what is shown (which may be a preview)
+  auto const surface = d->isosurface->fullSurface();
+  if (!surface)
   {
-    mesh->GetPointData()->RemoveArray(i);;
+    qWarning() << "No surface has been extracted from the volume";
+    return;
   }
 
+  vtkNew<vtkPolyData> mesh;
+  mesh->ShallowCopy(surface);
+  mesh->GetPointData()->Initialize();
+
   vtkNew<vtkXMLPolyDataWriter> writer;
 
   writer->SetFileName(path.toStdString().c_str());
-  writer->AddInputDataObject(mesh);
+  writer->AddInputDataObject(mesh.GetPointer());
   writer->SetDataModeToBinary();
   writer->Write();
 
@@ -1254,10 +1393,48 @@ void WorldView::saveVolume(const QString &path)
   //NOTE: For now, the volume is set in the configuration parameters.
   //      It may be generated directly from the GUI in the future.
 
-  vtkNew<vtkXMLStructuredGridWriter> writer;
+  auto const volume = d->isosurface->volume();
+  if (!volume)
+  {
+    qWarning() << "No volume has been loaded";
+    return;
+  }
+
+  vtkSmartPointer<vtkXMLWriter> writer;
+
+  auto const ext = QFileInfo(path).suffix().toLower();
+  if (vtkImageData::SafeDownCast(volume))
+  {
+    if (ext == "vts")
+    {
+      // Regular volumes are held as image data; give them explicit point
+      // coordinates when a structured grid is requested
+      vtkNew<vtkImageDataToPointSet> toGrid;
+      toGrid->SetInputData(volume);
+      toGrid->Update();
+
+      writer = vtkSmartPointer<vtkXMLStructuredGridWriter>::New();
+      writer->SetInputDataObject(toGrid->GetOutput());
+    }
+    else
+    {
+      writer = vtkSmartPointer<vtkXMLImageDataWriter>::New();
+      writer->SetInputDataObject(volume);
+    }
+  }
+  else if (ext == "vti")
+  {
+    qWarning() << "Volume is not a regular grid and cannot be saved as"
+               << "image data";
+    return;
+  }
+  else
+  {
+    writer = vtkSmartPointer<vtkXMLStructuredGridWriter>::New();
+    writer->SetInputDataObject(volume);
+  }
 
   writer->SetFileName(path.toStdString().c_str());
-  writer->AddInputDataObject(d->volume);
   writer->SetDataModeToBinary();
   writer->Write();
 
@@ -1269,15 +1446,32 @@ void WorldView::saveColoredMesh(const QString &path)
 {
   QTE_D();
 
+  // Make the full resolution surface current, so that it is what is shown
+  // (and colored), rather than a preview
+  if (!d->isosurface->fullSurface())
+  {
+    qWarning() << "No surface has been extracted from the volume";
+    return;
+  }
+
+  vtkPolyData* mesh = d->volumeSurface.GetPointer();
+  auto const scalars = mesh->GetPointData()->GetScalars();
+  if (!scalars)
+  {
+    qWarning() << "The surface has not been colored; saving it without colors";
+  }
+
   const QString ext = QFileInfo(path).suffix().toLower();
   if(ext == "ply")
   {
     vtkNew<vtkPLYWriter> writer;
     writer->SetFileName(path.toStdString().c_str());
     writer->SetColorMode(0);
-    vtkSmartPointer<vtkPolyData> mesh = d->contourFilter->GetOutput();
-    writer->SetArrayName(mesh->GetPointData()->GetScalars()->GetName());
-    writer->SetLookupTable(d->volumeActor->GetMapper()->GetLookupTable());
+    if (scalars)
+    {
+      writer->SetArrayName(scalars->GetName());
+      writer->SetLookupTable(d->volumeActor->GetMapper()->GetLookupTable());
+    }
     writer->AddInputDataObject(mesh);
     writer->Write();
   }
@@ -1286,7 +1480,7 @@ void WorldView::saveColoredMesh(const QString &path)
     vtkNew<vtkXMLPolyDataWriter> writer;
     writer->SetFileName(path.toStdString().c_str());
     writer->SetDataModeToBinary();
-    writer->AddInputDataObject(d->contourFilter->GetOutput());
+    writer->AddInputDataObject(mesh);
     writer->Write();
   }
 
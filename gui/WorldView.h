@@ -114,11 +114,14 @@ protected slots:
   void updateAxes();
   void updateCameras();
   void updateScale();
+  void updateLandmarkDetail();
+  void refineLandmarks();
   void updateDepthMapDisplayMode();
   void updateDepthMapThresholds(bool filterState);
   void increaseDepthMapPointSize();
   void decreaseDepthMapPointSize();
   void updateThresholdRanges();
+  void updateContour();
 
 private:
   QTE_DECLARE_PRIVATE_RPTR(WorldView)
@@ -30,6 +30,7 @@
 
 #include "MainWindow.h"
 #include "tools/AbstractTool.h"
+#include "tools/ToolWorker.h"
 
 #include <maptk/version.h>
 
@@ -59,8 +60,15 @@ int main(int argc, char** argv)
 
   // Set up command line options
   qtCliArgs args(argc, argv);
+  qtCliOptions options;
   qtCliOptions nargs;
 
+  options.add("tool-worker <tool>",
+              "Run the named tool as a worker for another instance");
+  options.add("tool-server <name>",
+              "Name of the server to which the tool worker connects");
+  args.addOptions(options);
+
   nargs.add("files", "List of files to open", qtCliOption::NamedList);
   args.addNamedArguments(nargs);
 
@@ -77,6 +85,17 @@ int main(int argc, char** argv)
   kwiver::vital::plugin_manager::instance().add_search_path(rel_path);
   kwiver::vital::plugin_manager::instance().load_all_plugins();
 
+  // Run as a tool worker, if requested
+  if (args.isSet("tool-worker"))
+  {
+    ToolWorker worker(args.value("tool-worker"), args.value("tool-server"));
+    if (!worker.start())
+    {
+      return 1;
+    }
+    return app.exec();
+  }
+
   // Create and show main window
   MainWindow window;
   window.show();
@@ -29,17 +29,97 @@
  */
 
 #include "AbstractTool.h"
+#include "ToolProcess.h"
 
+#include "SessionCache.h"
+
+#include <maptk/dense_camera_map.h>
+#include <maptk/dense_landmark_map.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QIODevice>
 #include <QtCore/QThread>
 
 #include <atomic>
+#include <chrono>
+#include <cstring>
+
+namespace // anonymous
+{
+
+static char const ToolDataMagic[8] = { 'M', 'T', 'K', 'T', 'O', 'O', 'L', 'D' };
+
+enum ToolDataFlag
+{
+  HasTracks = 0x1,
+  HasCameras = 0x2,
+  HasLandmarks = 0x4,
+};
+
+//-----------------------------------------------------------------------------
+struct ToolDataHeader
+{
+  char magic[8];
+  quint64 activeFrame;
+  quint64 pathCount;
+  quint64 pathBytes; // Null terminated UTF-8 paths, padded to 8 bytes
+  quint32 flags;
+  quint32 padding;
+};
+
+static_assert(sizeof(ToolDataHeader) % 8 == 0, "bad record size");
+
+//-----------------------------------------------------------------------------
+QByteArray packPaths(std::vector<std::string> const& paths)
+{
+  auto result = QByteArray{};
+  for (auto const& path : paths)
+  {
+    result.append(path.c_str(), static_cast<int>(path.size()) + 1);
+  }
+  result.append(QByteArray((8 - result.size() % 8) % 8, '\0'));
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+SessionCache packCache(ToolData const& data)
+{
+  auto cache = SessionCache{};
+  if (data.cameras)
+  {
+    for (auto const& ci : data.cameras->cameras())
+    {
+      auto const frame = static_cast<size_t>(ci.first);
+      if (frame >= cache.cameras.size())
+      {
+        cache.cameras.resize(frame + 1);
+      }
+      cache.cameras[frame] = ci.second;
+    }
+  }
+  cache.tracks = data.tracks;
+  cache.landmarks = data.landmarks;
+  return cache;
+}
+
+//-----------------------------------------------------------------------------
+long long now()
+{
+  using namespace std::chrono;
+  auto const t = steady_clock::now().time_since_epoch();
+  return duration_cast<milliseconds>(t).count();
+}
+
+} // namespace <anonymous>
 
 //-----------------------------------------------------------------------------
 class AbstractToolPrivate : public QThread
 {
 public:
   AbstractToolPrivate(AbstractTool* q)
-    : data(std::make_shared<ToolData>()), q_ptr(q) {}
+    : data(std::make_shared<ToolData>()), progressInterval(250),
+      lastProgress(0), progressPending(false), runInWorker(false),
+      worker(0), isStage(false), q_ptr(q) {}
 
   virtual void run() QTE_OVERRIDE;
 
@@ -47,6 +127,19 @@ public:
 
   std::atomic<bool> cancelRequested;
 
+  // Latest intermediate update, accessed only through the std::atomic_*
+  // shared_ptr functions
+  std::shared_ptr<ToolData> progressData;
+  std::atomic<int> progressInterval;
+  std::atomic<long long> lastProgress;
+  std::atomic<bool> progressPending;
+
+  bool runInWorker;
+  ToolProcess* worker;
+
+  // Set while the tool is being prepared to run as a stage of another tool
+  bool isStage;
+
 protected:
   QTE_DECLARE_PUBLIC_PTR(AbstractTool)
   QTE_DECLARE_PUBLIC(AbstractTool)
@@ -83,7 +176,15 @@ void ToolData::copyTracks(feature_track_set_sptr const& newTracks)
 //-----------------------------------------------------------------------------
 void ToolData::copyCameras(camera_map_sptr const& newCameras)
 {
-  if (newCameras)
+  using kwiver::maptk::dense_camera_map;
+
+  // Dense maps hold their cameras by value, so a plain copy is a deep copy
+  auto const dense = std::dynamic_pointer_cast<dense_camera_map>(newCameras);
+  if (dense)
+  {
+    this->cameras = std::make_shared<dense_camera_map>(*dense);
+  }
+  else if (newCameras)
   {
     auto copiedCameras = kwiver::vital::camera_map::map_camera_t{};
     foreach (auto const& ci, newCameras->cameras())
@@ -102,7 +203,16 @@ void ToolData::copyCameras(camera_map_sptr const& newCameras)
 //-----------------------------------------------------------------------------
 void ToolData::copyLandmarks(landmark_map_sptr const& newLandmarks)
 {
-  if (newLandmarks)
+  using kwiver::maptk::dense_landmark_map;
+
+  // Dense maps hold their landmarks by value, so a plain copy is a deep copy
+  auto const dense =
+    std::dynamic_pointer_cast<dense_landmark_map>(newLandmarks);
+  if (dense)
+  {
+    this->landmarks = std::make_shared<dense_landmark_map>(*dense);
+  }
+  else if (newLandmarks)
   {
     auto copiedLandmarks = kwiver::vital::landmark_map::map_landmark_t{};
     foreach (auto const& ci, newLandmarks->landmarks())
@@ -118,6 +228,110 @@ void ToolData::copyLandmarks(landmark_map_sptr const& newLandmarks)
   }
 }
 
+//-----------------------------------------------------------------------------
+qint64 ToolData::size() const
+{
+  auto const cacheBytes = packCache(*this).size(QStringList{});
+  if (cacheBytes < 0)
+  {
+    return -1;
+  }
+
+  return static_cast<qint64>(sizeof(ToolDataHeader)) +
+         packPaths(this->imagePaths).size() + cacheBytes;
+}
+
+//-----------------------------------------------------------------------------
+bool ToolData::write(QIODevice& out) const
+{
+  // Write header and image paths
+  auto const& paths = packPaths(this->imagePaths);
+
+  auto header = ToolDataHeader{};
+  memcpy(header.magic, ToolDataMagic, sizeof(ToolDataMagic));
+  header.activeFrame = this->activeFrame;
+  header.pathCount = this->imagePaths.size();
+  header.pathBytes = static_cast<quint64>(paths.size());
+  header.flags = (this->tracks ? HasTracks : 0) |
+                 (this->cameras ? HasCameras : 0) |
+                 (this->landmarks ? HasLandmarks : 0);
+  header.padding = 0;
+
+  auto const headerBytes = static_cast<qint64>(sizeof(header));
+  if (out.write(reinterpret_cast<char const*>(&header), headerBytes) !=
+        headerBytes ||
+      out.write(paths) != paths.size())
+  {
+    return false;
+  }
+
+  // Write the rest of the data as a session cache
+  return packCache(*this).write(out, QStringList{});
+}
+
+//-----------------------------------------------------------------------------
+bool ToolData::read(uchar const* data, qint64 size)
+{
+  // Read header and image paths
+  auto const headerBytes = static_cast<qint64>(sizeof(ToolDataHeader));
+  if (size < headerBytes)
+  {
+    return false;
+  }
+
+  auto const& header = *reinterpret_cast<ToolDataHeader const*>(data);
+  if (memcmp(header.magic, ToolDataMagic, sizeof(ToolDataMagic)) != 0 ||
+      header.pathBytes % 8 != 0 ||
+      header.pathBytes > static_cast<quint64>(size - headerBytes))
+  {
+    return false;
+  }
+
+  auto paths = std::vector<std::string>{};
+  auto const* next = reinterpret_cast<char const*>(data + headerBytes);
+  auto const* const end = next + header.pathBytes;
+  for (quint64 i = 0; i < header.pathCount; ++i)
+  {
+    auto const* const terminator =
+      static_cast<char const*>(memchr(next, '\0', end - next));
+    if (!terminator)
+    {
+      return false;
+    }
+
+    paths.emplace_back(next, terminator);
+    next = terminator + 1;
+  }
+
+  // Read the rest of the data from the session cache
+  auto const offset = headerBytes + static_cast<qint64>(header.pathBytes);
+  auto cache = SessionCache{};
+  if (!cache.read(data + offset, size - offset, QStringList{}))
+  {
+    return false;
+  }
+
+  auto const cameras = std::make_shared<kwiver::maptk::dense_camera_map>();
+  for (size_t i = 0; i < cache.cameras.size(); ++i)
+  {
+    if (cache.cameras[i])
+    {
+      cameras->insert(static_cast<kwiver::vital::frame_id_t>(i),
+                      cache.cameras[i]);
+    }
+  }
+
+  this->activeFrame = static_cast<unsigned int>(header.activeFrame);
+  this->imagePaths = std::move(paths);
+  this->tracks = (header.flags & HasTracks ? cache.tracks
+                                           : feature_track_set_sptr{});
+  this->cameras = (header.flags & HasCameras ? cameras : camera_map_sptr{});
+  this->landmarks = (header.flags & HasLandmarks ? cache.landmarks
+                                                 : landmark_map_sptr{});
+
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 AbstractTool::AbstractTool(QObject* parent)
   : QAction(parent), d_ptr(new AbstractToolPrivate(this))
@@ -180,6 +394,25 @@ void AbstractTool::cancel()
 {
   QTE_D();
   d->cancelRequested = true;
+
+  if (d->worker)
+  {
+    d->worker->cancel();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void AbstractTool::setProgressInterval(int msec)
+{
+  QTE_D();
+  d->progressInterval = msec;
+}
+
+//-----------------------------------------------------------------------------
+void AbstractTool::setRunInWorker(bool state)
+{
+  QTE_D();
+  d->runInWorker = state;
 }
 
 //-----------------------------------------------------------------------------
@@ -223,6 +456,31 @@ bool AbstractTool::execute(QWidget* window)
   QTE_D();
 
   d->cancelRequested = false;
+
+  if (d->isStage)
+  {
+    // The tool which is running this as a stage will call run() itself
+    return true;
+  }
+
+  auto const name = QString::fromLatin1(this->metaObject()->className());
+  if (d->runInWorker && ToolProcess::supports(name))
+  {
+    d->worker = new ToolProcess(this);
+    connect(d->worker, SIGNAL(updated(std::shared_ptr<ToolData>)),
+            this, SIGNAL(updated(std::shared_ptr<ToolData>)));
+    connect(d->worker, SIGNAL(completed(std::shared_ptr<ToolData>)),
+            this, SLOT(acceptWorkerResults(std::shared_ptr<ToolData>)));
+
+    if (!d->worker->start(name, *d->data))
+    {
+      delete d->worker;
+      d->worker = 0;
+      return false;
+    }
+    return true;
+  }
+
   d->start();
   return true;
 }
@@ -234,6 +492,102 @@ bool AbstractTool::isCanceled() const
   return d->cancelRequested;
 }
 
+//-----------------------------------------------------------------------------
+void AbstractTool::reportProgress(
+  std::function<std::shared_ptr<ToolData>()> const& snapshot)
+{
+  QTE_D();
+
+  // Skip the update if the previous one has not been consumed yet, or if it
+  // is too soon after the previous one
+  auto const t = now();
+  if (d->progressPending || t - d->lastProgress < d->progressInterval)
+  {
+    return;
+  }
+  d->lastProgress = t;
+
+  std::atomic_store(&d->progressData, snapshot());
+  if (!d->progressPending.exchange(true))
+  {
+    QMetaObject::invokeMethod(this, "deliverProgress", Qt::QueuedConnection);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void AbstractTool::deliverProgress()
+{
+  QTE_D();
+
+  auto const data =
+    std::atomic_exchange(&d->progressData, std::shared_ptr<ToolData>{});
+  d->progressPending = false;
+
+  if (data)
+  {
+    emit updated(data);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void AbstractTool::acceptWorkerResults(std::shared_ptr<ToolData> data)
+{
+  QTE_D();
+
+  if (data)
+  {
+    d->data = data;
+  }
+
+  d->worker->deleteLater();
+  d->worker = 0;
+
+  emit completed();
+}
+
+//-----------------------------------------------------------------------------
+bool AbstractTool::executeAsStage(QWidget* window)
+{
+  QTE_D();
+
+  d->isStage = true;
+  auto const result = this->execute(window);
+  d->isStage = false;
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+bool AbstractTool::runStage(AbstractTool* stage, QWidget* window)
+{
+  QTE_D();
+
+  if (this->isCanceled())
+  {
+    return false;
+  }
+
+  // Hand our data to the stage; the stage's outputs are written to it in
+  // place
+  auto const sd = stage->d_func();
+  sd->data = d->data;
+
+  // Prepare the stage (checking its inputs and configuration) on its own
+  // thread, as this may interact with the user
+  auto prepared = false;
+  QMetaObject::invokeMethod(stage, "executeAsStage",
+                            Qt::BlockingQueuedConnection,
+                            Q_RETURN_ARG(bool, prepared),
+                            Q_ARG(QWidget*, window));
+  if (!prepared || this->isCanceled())
+  {
+    return false;
+  }
+
+  stage->run();
+  return !stage->isCanceled() && !this->isCanceled();
+}
+
 //-----------------------------------------------------------------------------
 bool AbstractTool::hasImagePaths() const
 {
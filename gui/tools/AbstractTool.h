@@ -39,6 +39,10 @@
 
 #include <QtGui/QAction>
 
+#include <functional>
+
+class QIODevice;
+
 class AbstractToolPrivate;
 
 /// A class to hold data that is modified by the tool
@@ -58,6 +62,17 @@ public:
   /// Deep copy the landmarks into this data class
   void copyLandmarks(landmark_map_sptr const&);
 
+  /// Get the number of bytes #write will write, or -1 on failure.
+  qint64 size() const;
+
+  /// Write the data to \p out, for transfer to another process.
+  bool write(QIODevice& out) const;
+
+  /// Read data written by #write from a buffer.
+  ///
+  /// The data is not modified if reading fails.
+  bool read(uchar const* data, qint64 size);
+
   unsigned int activeFrame;
   std::vector<std::string> imagePaths;
   feature_track_set_sptr tracks;
@@ -116,6 +131,25 @@ public:
   /// Set the landmarks to be used as input to the tool.
   void setLandmarks(landmark_map_sptr const&);
 
+  /// Set the minimum interval between intermediate updates, in milliseconds.
+  ///
+  /// Progress reported more often than this is discarded without building a
+  /// snapshot of the data. The default is 250 ms.
+  ///
+  /// \sa reportProgress
+  void setProgressInterval(int msec);
+
+  /// Set whether the tool should run in a separate worker process.
+  ///
+  /// If enabled, and if the tool supports it, execute() runs the tool in a
+  /// worker process, which exchanges data with this process through shared
+  /// memory. All memory used by the computation is released when the worker
+  /// exits, and a crash of the worker does not affect this process; if the
+  /// worker fails, the tool completes with its input data unchanged.
+  ///
+  /// \sa ToolProcess
+  void setRunInWorker(bool);
+
   /// Execute the tool.
   ///
   /// Tool implementations should override this method to verify that they have
@@ -201,6 +235,19 @@ protected:
   /// Check if the user has requested that tool execution be canceled.
   bool isCanceled() const;
 
+  /// Report intermediate progress.
+  ///
+  /// This calls \p snapshot to build a copy of the data to be shown, which is
+  /// then emitted via #updated on the thread that owns the tool. To avoid
+  /// building copies that would only be discarded, \p snapshot is called only
+  /// if the previous update has been delivered and the progress interval has
+  /// elapsed; otherwise, the report is ignored. This never blocks waiting on
+  /// the receiver, and may be called from any thread.
+  ///
+  /// \sa setProgressInterval
+  void reportProgress(
+    std::function<std::shared_ptr<ToolData>()> const& snapshot);
+
   /// Test if the tool has image path data.
   ///
   /// \return \c true if the tool data has a non-zero number of images,
@@ -243,6 +290,25 @@ protected:
   /// setCameras, this does not make a deep copy of the provided landmarks.
   void updateLandmarks(landmark_map_sptr const&);
 
+  /// Run another tool as a stage of this tool.
+  ///
+  /// This is used by tools which chain other tools. It must be called from
+  /// run(). The stage operates directly on the data of this tool, without
+  /// making a copy, so its outputs become the data of this tool. The stage is
+  /// first prepared by calling its execute() method (with \p window) on the
+  /// thread that owns the stage, which blocks until that has completed; the
+  /// stage is then run on the calling thread. Intermediate updates from the
+  /// stage are emitted by the stage.
+  ///
+  /// \return \c true if the stage was run to completion, or \c false if
+  ///         it could not be prepared or was canceled.
+  bool runStage(AbstractTool* stage, QWidget* window = 0);
+
+private slots:
+  void deliverProgress();
+  void acceptWorkerResults(std::shared_ptr<ToolData>);
+  bool executeAsStage(QWidget* window);
+
 private:
   QTE_DECLARE_PRIVATE_RPTR(AbstractTool)
   QTE_DECLARE_PRIVATE(AbstractTool)
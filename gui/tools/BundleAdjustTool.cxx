@@ -166,11 +166,14 @@ void BundleAdjustTool::run()
 bool BundleAdjustTool::callback_handler(camera_map_sptr cameras,
                                         landmark_map_sptr landmarks)
 {
-  // make a copy of the tool data
-  auto data = std::make_shared<ToolData>();
-  data->copyCameras(cameras);
-  data->copyLandmarks(landmarks);
+  // make a copy of the tool data, if the GUI is ready for an update
+  this->reportProgress([&]{
+    auto data = std::make_shared<ToolData>();
+    data->copyCameras(cameras);
+    data->copyLandmarks(landmarks);
+    data->activeFrame = this->activeFrame();
+    return data;
+  });
 
-  emit updated(data);
   return !this->isCanceled();
 }
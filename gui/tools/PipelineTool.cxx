@@ -0,0 +1,148 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PipelineTool.h"
+
+#include "BundleAdjustTool.h"
+#include "InitCamerasLandmarksTool.h"
+#include "TrackFeaturesTool.h"
+#include "TrackFilterTool.h"
+
+#include <QtCore/QList>
+#include <QtCore/QPointer>
+
+#include <QtGui/QWidget>
+
+//-----------------------------------------------------------------------------
+class PipelineToolPrivate
+{
+public:
+  QList<AbstractTool*> stages;
+  QPointer<QWidget> window;
+};
+
+QTE_IMPLEMENT_D_FUNC(PipelineTool)
+
+//-----------------------------------------------------------------------------
+PipelineTool::PipelineTool(QObject* parent)
+  : AbstractTool(parent), d_ptr(new PipelineToolPrivate)
+{
+}
+
+//-----------------------------------------------------------------------------
+PipelineTool::~PipelineTool()
+{
+}
+
+//-----------------------------------------------------------------------------
+PipelineTool* PipelineTool::createReconstructionPipeline(QObject* parent)
+{
+  auto const pipeline = new PipelineTool(parent);
+
+  pipeline->setText("Run &Pipeline");
+  pipeline->setToolTip(
+    "<nobr>Track features, filter the tracks, initialize cameras and "
+    "</nobr>landmarks, and refine the solution, in a single step");
+
+  pipeline->addStage(new TrackFeaturesTool);
+  pipeline->addStage(new TrackFilterTool);
+  pipeline->addStage(new InitCamerasLandmarksTool);
+  pipeline->addStage(new BundleAdjustTool);
+
+  return pipeline;
+}
+
+//-----------------------------------------------------------------------------
+void PipelineTool::addStage(AbstractTool* stage)
+{
+  QTE_D();
+
+  stage->setParent(this);
+  connect(stage, SIGNAL(updated(std::shared_ptr<ToolData>)),
+          this, SIGNAL(updated(std::shared_ptr<ToolData>)));
+
+  d->stages.append(stage);
+}
+
+//-----------------------------------------------------------------------------
+AbstractTool::Outputs PipelineTool::outputs() const
+{
+  QTE_D();
+
+  auto outputs = Outputs{};
+  foreach (auto const stage, d->stages)
+  {
+    outputs |= stage->outputs();
+  }
+  return outputs;
+}
+
+//-----------------------------------------------------------------------------
+bool PipelineTool::execute(QWidget* window)
+{
+  QTE_D();
+
+  if (d->stages.isEmpty())
+  {
+    return false;
+  }
+
+  // Stages are prepared (and check their inputs) as they are reached, since
+  // their inputs are produced by the preceding stages
+  d->window = window;
+
+  return AbstractTool::execute(window);
+}
+
+//-----------------------------------------------------------------------------
+void PipelineTool::cancel()
+{
+  QTE_D();
+
+  AbstractTool::cancel();
+  foreach (auto const stage, d->stages)
+  {
+    stage->cancel();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PipelineTool::run()
+{
+  QTE_D();
+
+  foreach (auto const stage, d->stages)
+  {
+    if (!this->runStage(stage, d->window))
+    {
+      break;
+    }
+  }
+}
@@ -0,0 +1,84 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_PIPELINETOOL_H_
+#define MAPTK_PIPELINETOOL_H_
+
+#include "AbstractTool.h"
+
+class PipelineToolPrivate;
+
+/// Tool which runs a sequence of other tools.
+///
+/// The stages are run back to back on the tool's thread, each operating
+/// directly on the output of the previous one. Intermediate updates from the
+/// stages are forwarded (throttled, as for any tool), so that the data is
+/// only refreshed as progress is made and when the whole pipeline completes.
+class PipelineTool : public AbstractTool
+{
+  Q_OBJECT
+
+public:
+  explicit PipelineTool(QObject* parent = 0);
+  virtual ~PipelineTool();
+
+  /// Create the standard reconstruction pipeline.
+  ///
+  /// This runs feature tracking, track filtering, camera and landmark
+  /// initialization, and bundle adjustment.
+  static PipelineTool* createReconstructionPipeline(QObject* parent = 0);
+
+  /// Append a stage to the pipeline.
+  ///
+  /// The pipeline takes ownership of the stage.
+  void addStage(AbstractTool* stage);
+
+  virtual Outputs outputs() const QTE_OVERRIDE;
+
+  /// Get if the tool can be canceled.
+  ///
+  /// The pipeline can always be canceled between stages.
+  virtual bool isCancelable() const QTE_OVERRIDE { return true; }
+
+  virtual bool execute(QWidget* window = 0) QTE_OVERRIDE;
+
+public slots:
+  virtual void cancel() QTE_OVERRIDE;
+
+protected:
+  virtual void run() QTE_OVERRIDE;
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(PipelineTool)
+  QTE_DECLARE_PRIVATE(PipelineTool)
+  QTE_DISABLE_COPY(PipelineTool)
+};
+
+#endif
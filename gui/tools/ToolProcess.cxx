@@ -0,0 +1,529 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ToolProcess.h"
+
+#include "AbstractTool.h"
+#include "BundleAdjustTool.h"
+#include "InitCamerasLandmarksTool.h"
+#include "PipelineTool.h"
+#include "TrackFeaturesTool.h"
+
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QIODevice>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QStringList>
+
+#include <cstring>
+#include <limits>
+
+namespace // anonymous
+{
+
+// Time to wait for the worker to exit after being asked to cancel, in
+// milliseconds, before it is killed
+static auto const WorkerExitTimeout = 5000;
+
+//-----------------------------------------------------------------------------
+// Write-only device over a fixed block of memory, such as a shared memory
+// segment; unlike a QBuffer, it does not need the data in a QByteArray
+class MemoryWriter : public QIODevice
+{
+public:
+  MemoryWriter(void* data, qint64 size)
+    : data(static_cast<char*>(data)), capacity(size), offset(0) {}
+
+  virtual bool isSequential() const QTE_OVERRIDE { return true; }
+
+protected:
+  virtual qint64 readData(char*, qint64) QTE_OVERRIDE { return -1; }
+
+  virtual qint64 writeData(char const* src, qint64 len) QTE_OVERRIDE
+  {
+    if (len > this->capacity - this->offset)
+    {
+      return -1;
+    }
+
+    memcpy(this->data + this->offset, src, static_cast<size_t>(len));
+    this->offset += len;
+    return len;
+  }
+
+  char* const data;
+  qint64 const capacity;
+  qint64 offset;
+};
+
+//-----------------------------------------------------------------------------
+// Temporary file holding data too large for a shared memory segment, whose
+// size is limited to an int; the file is removed when this is destroyed
+class SharedFile : public QObject
+{
+public:
+  SharedFile(QString const& path, QObject* parent)
+    : QObject(parent), file(path) {}
+
+  virtual ~SharedFile() { this->file.remove(); }
+
+  QFile file;
+};
+
+//-----------------------------------------------------------------------------
+QString sharedFilePath(QString const& key)
+{
+  return QDir(QDir::tempPath()).filePath(key + ".tooldata");
+}
+
+//-----------------------------------------------------------------------------
+QObject* shareFile(QString const& key, ToolData const& data, QObject* parent)
+{
+  auto const shared = new SharedFile(sharedFilePath(key), parent);
+  auto& file = shared->file;
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qWarning() << "Failed to create tool data file" << file.fileName()
+               << ":" << file.errorString();
+    delete shared;
+    return 0;
+  }
+
+  if (!data.write(file) || !file.flush())
+  {
+    qWarning() << "Failed to write tool data file" << file.fileName()
+               << ":" << file.errorString();
+    delete shared;
+    return 0;
+  }
+
+  file.close();
+  return shared;
+}
+
+//-----------------------------------------------------------------------------
+std::shared_ptr<ToolData> fetchFile(QString const& path)
+{
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << "Failed to open tool data file" << path << ":"
+               << file.errorString();
+    return nullptr;
+  }
+
+  auto const size = file.size();
+  auto const map = file.map(0, size);
+  if (!map)
+  {
+    qWarning() << "Failed to map tool data file" << path << ":"
+               << file.errorString();
+    return nullptr;
+  }
+
+  auto data = std::make_shared<ToolData>();
+  auto const ok = data->read(map, size);
+  file.unmap(map);
+
+  if (!ok)
+  {
+    qWarning() << "Failed to read tool data from file" << path;
+    return nullptr;
+  }
+
+  return data;
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class ToolProcessPrivate
+{
+public:
+  ToolProcessPrivate() : socket(0), input(0), finished(false) {}
+
+  void send(QByteArray const& message);
+  void releaseSegments();
+
+  QProcess process;
+  QLocalServer server;
+  QLocalSocket* socket;
+  QObject* input;
+
+  // Name of the control channel, from which the worker derives segment keys,
+  // and the key of the last segment it announced
+  QString serverName;
+  QString lastKey;
+
+  bool finished;
+};
+
+QTE_IMPLEMENT_D_FUNC(ToolProcess)
+
+//-----------------------------------------------------------------------------
+void ToolProcessPrivate::send(QByteArray const& message)
+{
+  if (this->socket)
+  {
+    this->socket->write(message + '\n');
+    this->socket->flush();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcessPrivate::releaseSegments()
+{
+  // Segments of a worker which crashed are never detached by the worker;
+  // where segments outlive their creator (System V shared memory), they are
+  // only removed once the last process attached to them detaches
+  auto keys = QStringList{};
+  auto next = 1;
+  if (!this->lastKey.isEmpty())
+  {
+    keys.append(this->lastKey);
+    next = this->lastKey.section('-', -1).toInt() + 1;
+  }
+
+  // The worker may also have created its next segment without announcing it
+  // (see ToolWorkerPrivate::publish for the key format)
+  keys.append(QString("%1-update-%2").arg(this->serverName).arg(next));
+  keys.append(QString("%1-result-%2").arg(this->serverName).arg(next));
+
+  foreach (auto const& key, keys)
+  {
+    QSharedMemory segment(key);
+    if (segment.attach(QSharedMemory::ReadOnly))
+    {
+      segment.detach();
+    }
+    QFile::remove(sharedFilePath(key));
+  }
+}
+
+//-----------------------------------------------------------------------------
+ToolProcess::ToolProcess(QObject* parent)
+  : QObject(parent), d_ptr(new ToolProcessPrivate)
+{
+  QTE_D();
+
+  // Let the worker write diagnostics to our console
+  d->process.setProcessChannelMode(QProcess::ForwardedChannels);
+
+  connect(&d->server, SIGNAL(newConnection()),
+          this, SLOT(acceptConnection()));
+  connect(&d->process, SIGNAL(finished(int, QProcess::ExitStatus)),
+          this, SLOT(processFinished(int, QProcess::ExitStatus)));
+  connect(&d->process, SIGNAL(error(QProcess::ProcessError)),
+          this, SLOT(processError(QProcess::ProcessError)));
+}
+
+//-----------------------------------------------------------------------------
+ToolProcess::~ToolProcess()
+{
+  QTE_D();
+
+  if (d->process.state() != QProcess::NotRunning)
+  {
+    d->process.disconnect(this);
+
+    d->send("cancel");
+    if (!d->process.waitForFinished(WorkerExitTimeout))
+    {
+      d->process.kill();
+      d->process.waitForFinished();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool ToolProcess::supports(QString const& toolName)
+{
+  return toolName == "TrackFeaturesTool" ||
+         toolName == "InitCamerasLandmarksTool" ||
+         toolName == "BundleAdjustTool" ||
+         toolName == "PipelineTool";
+}
+
+//-----------------------------------------------------------------------------
+AbstractTool* ToolProcess::createTool(
+  QString const& toolName, QObject* parent)
+{
+  if (toolName == "TrackFeaturesTool")
+  {
+    return new TrackFeaturesTool(parent);
+  }
+  if (toolName == "InitCamerasLandmarksTool")
+  {
+    return new InitCamerasLandmarksTool(parent);
+  }
+  if (toolName == "BundleAdjustTool")
+  {
+    return new BundleAdjustTool(parent);
+  }
+  if (toolName == "PipelineTool")
+  {
+    // Only the standard pipeline is ever created by the GUI
+    return PipelineTool::createReconstructionPipeline(parent);
+  }
+
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+QObject* ToolProcess::share(
+  QString const& key, ToolData const& data, QObject* parent)
+{
+  // Size the segment first, so the data can be written straight into it
+  auto const size = data.size();
+  if (size < 0)
+  {
+    qWarning() << "Failed to serialize tool data";
+    return 0;
+  }
+  if (size > std::numeric_limits<int>::max())
+  {
+    return shareFile(key, data, parent);
+  }
+
+  auto segment = new QSharedMemory(key, parent);
+  if (!segment->create(static_cast<int>(size)))
+  {
+    qWarning() << "Failed to create shared memory segment" << key << ":"
+               << segment->errorString();
+    delete segment;
+    return 0;
+  }
+
+  segment->lock();
+  MemoryWriter out(segment->data(), size);
+  out.open(QIODevice::WriteOnly);
+  auto const ok = data.write(out);
+  segment->unlock();
+
+  if (!ok)
+  {
+    qWarning() << "Failed to serialize tool data";
+    delete segment;
+    return 0;
+  }
+
+  return segment;
+}
+
+//-----------------------------------------------------------------------------
+std::shared_ptr<ToolData> ToolProcess::fetch(QString const& key)
+{
+  auto const& path = sharedFilePath(key);
+  if (QFile::exists(path))
+  {
+    return fetchFile(path);
+  }
+
+  QSharedMemory segment(key);
+  if (!segment.attach(QSharedMemory::ReadOnly))
+  {
+    qWarning() << "Failed to attach to shared memory segment" << key << ":"
+               << segment.errorString();
+    return nullptr;
+  }
+
+  auto data = std::make_shared<ToolData>();
+
+  segment.lock();
+  auto const ok = data->read(static_cast<uchar const*>(segment.constData()),
+                             segment.size());
+  segment.unlock();
+
+  if (!ok)
+  {
+    qWarning() << "Failed to read tool data from shared memory segment"
+               << key;
+    return nullptr;
+  }
+
+  return data;
+}
+
+//-----------------------------------------------------------------------------
+bool ToolProcess::start(QString const& toolName, ToolData const& input)
+{
+  QTE_D();
+
+  static auto counter = 0;
+  auto const name = QString("maptk-tool-%1-%2")
+                      .arg(QCoreApplication::applicationPid())
+                      .arg(++counter);
+
+  // Set up the control channel
+  QLocalServer::removeServer(name);
+  if (!d->server.listen(name))
+  {
+    qWarning() << "Failed to create tool server" << name << ":"
+               << d->server.errorString();
+    return false;
+  }
+
+  d->serverName = name;
+  d->lastKey.clear();
+
+  // Share input data; this is released once the worker has read it
+  d->input = share(name + "-input", input, this);
+  if (!d->input)
+  {
+    d->server.close();
+    return false;
+  }
+
+  // Start worker
+  auto args = QStringList{};
+  args << "--tool-worker" << toolName << "--tool-server" << name;
+  d->process.start(QCoreApplication::applicationFilePath(), args);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcess::cancel()
+{
+  QTE_D();
+  d->send("cancel");
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcess::acceptConnection()
+{
+  QTE_D();
+
+  auto const socket = d->server.nextPendingConnection();
+  if (d->socket || !socket)
+  {
+    delete socket;
+    return;
+  }
+
+  d->socket = socket;
+  d->server.close();
+
+  connect(socket, SIGNAL(readyRead()), this, SLOT(readMessages()));
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcess::readMessages()
+{
+  QTE_D();
+
+  while (d->socket && d->socket->canReadLine())
+  {
+    auto const& message = QString::fromUtf8(d->socket->readLine()).trimmed();
+    auto const split = message.indexOf(' ');
+    auto const& command = message.left(split);
+    auto const& argument = (split < 0 ? QString{} : message.mid(split + 1));
+
+    if (command == "loaded")
+    {
+      // The worker has its own copy of the input now
+      delete d->input;
+      d->input = 0;
+    }
+    else if (command == "update" || command == "result")
+    {
+      d->lastKey = argument;
+      auto const& data = fetch(argument);
+      d->send("ack");
+
+      if (command == "result")
+      {
+        d->finished = true;
+        emit completed(data);
+        return;
+      }
+      else if (data)
+      {
+        emit updated(data);
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcess::processFinished(
+  int exitCode, QProcess::ExitStatus exitStatus)
+{
+  QTE_D();
+
+  delete d->input;
+  d->input = 0;
+
+  if (!d->finished)
+  {
+    // Pick up a result which was sent just before the worker exited
+    this->readMessages();
+  }
+
+  if (!d->finished)
+  {
+    if (exitStatus == QProcess::CrashExit)
+    {
+      qWarning() << "Tool worker crashed";
+      d->releaseSegments();
+    }
+    else
+    {
+      qWarning() << "Tool worker exited with code" << exitCode
+                 << "without producing a result";
+    }
+
+    d->finished = true;
+    emit completed(nullptr);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolProcess::processError(QProcess::ProcessError error)
+{
+  QTE_D();
+
+  // Other errors are followed by finished(), or are not fatal
+  if (error == QProcess::FailedToStart && !d->finished)
+  {
+    qWarning() << "Failed to start tool worker:" << d->process.errorString();
+
+    delete d->input;
+    d->input = 0;
+
+    d->finished = true;
+    emit completed(nullptr);
+  }
+}
@@ -0,0 +1,113 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_TOOLPROCESS_H_
+#define MAPTK_TOOLPROCESS_H_
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+
+#include <memory>
+
+class AbstractTool;
+class ToolData;
+
+class ToolProcessPrivate;
+
+/// Runs a tool in a worker process.
+///
+/// The worker is a second instance of the application, started with the
+/// \c --tool-worker option (see ToolWorker). The input data is written to a
+/// shared memory segment, which the worker reads before running the tool.
+/// Intermediate and final results are passed back the same way, in segments
+/// created by the worker, while control messages are exchanged over a local
+/// socket. Data too large for a shared memory segment (over 2 GiB) is passed
+/// in a temporary file instead, which is memory-mapped by the reader.
+class ToolProcess : public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit ToolProcess(QObject* parent = 0);
+  virtual ~ToolProcess();
+
+  /// Test if the tool with class name \p toolName can be run in a worker.
+  static bool supports(QString const& toolName);
+
+  /// Create the tool with class name \p toolName.
+  ///
+  /// This returns \c null if the tool is not supported.
+  static AbstractTool* createTool(QString const& toolName, QObject* parent);
+
+  /// Write \p data to a new shared memory segment with the key \p key.
+  ///
+  /// If the data is too large for a segment, it is written to a temporary
+  /// file named after \p key instead. The segment or file exists until the
+  /// returned object is destroyed (and, if another process has attached to a
+  /// segment, until that process detaches). This returns \c null on failure.
+  static QObject* share(QString const& key, ToolData const& data,
+                        QObject* parent = 0);
+
+  /// Read data shared by #share with the key \p key.
+  ///
+  /// This returns \c null on failure.
+  static std::shared_ptr<ToolData> fetch(QString const& key);
+
+  /// Start the worker, running the tool \p toolName on \p input.
+  bool start(QString const& toolName, ToolData const& input);
+
+  /// Ask the worker to cancel execution.
+  void cancel();
+
+signals:
+  /// Emitted when an intermediate update of the data is available.
+  void updated(std::shared_ptr<ToolData>);
+
+  /// Emitted when the worker has finished.
+  ///
+  /// The data is \c null if the worker failed.
+  void completed(std::shared_ptr<ToolData>);
+
+protected slots:
+  void acceptConnection();
+  void readMessages();
+  void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+  void processError(QProcess::ProcessError error);
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(ToolProcess)
+  QTE_DECLARE_PRIVATE(ToolProcess)
+
+  QTE_DISABLE_COPY(ToolProcess)
+};
+
+#endif
@@ -0,0 +1,282 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ToolWorker.h"
+
+#include "AbstractTool.h"
+#include "ToolProcess.h"
+
+#include <QtNetwork/QLocalSocket>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+
+namespace // anonymous
+{
+
+// Time to wait for the connection to the server, in milliseconds
+static auto const ConnectTimeout = 30000;
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class ToolWorkerPrivate
+{
+public:
+  ToolWorkerPrivate(ToolWorker* q)
+    : tool(0), segment(0), resultPending(false), resultSent(false),
+      orphaned(false), counter(0), q_ptr(q) {}
+
+  void send(QByteArray const& message);
+  bool publish(std::shared_ptr<ToolData> const& data, char const* kind);
+  void publishResult();
+
+  QString toolName;
+  QString serverName;
+
+  QLocalSocket socket;
+  AbstractTool* tool;
+
+  // Segment (or file) holding the data most recently sent, until
+  // acknowledged
+  QObject* segment;
+
+  std::shared_ptr<ToolData> pendingUpdate;
+  bool resultPending;
+  bool resultSent;
+  bool orphaned;
+
+  int counter;
+
+protected:
+  QTE_DECLARE_PUBLIC_PTR(ToolWorker)
+  QTE_DECLARE_PUBLIC(ToolWorker)
+};
+
+QTE_IMPLEMENT_D_FUNC(ToolWorker)
+
+//-----------------------------------------------------------------------------
+void ToolWorkerPrivate::send(QByteArray const& message)
+{
+  this->socket.write(message + '\n');
+  this->socket.flush();
+}
+
+//-----------------------------------------------------------------------------
+bool ToolWorkerPrivate::publish(
+  std::shared_ptr<ToolData> const& data, char const* kind)
+{
+  QTE_Q();
+
+  auto const key = QString("%1-%2-%3").arg(this->serverName, kind)
+                                      .arg(++this->counter);
+
+  this->segment = ToolProcess::share(key, *data, q);
+  if (!this->segment)
+  {
+    return false;
+  }
+
+  this->send(QByteArray(kind) + ' ' + key.toUtf8());
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void ToolWorkerPrivate::publishResult()
+{
+  this->resultPending = false;
+  this->resultSent = true;
+
+  if (!this->publish(this->tool->data(), "result"))
+  {
+    // Exit without a result; the tool process will report the failure
+    QCoreApplication::exit(1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+ToolWorker::ToolWorker(
+  QString const& toolName, QString const& serverName, QObject* parent)
+  : QObject(parent), d_ptr(new ToolWorkerPrivate(this))
+{
+  QTE_D();
+
+  d->toolName = toolName;
+  d->serverName = serverName;
+
+  connect(&d->socket, SIGNAL(readyRead()), this, SLOT(readMessages()));
+  connect(&d->socket, SIGNAL(disconnected()), this, SLOT(disconnected()));
+}
+
+//-----------------------------------------------------------------------------
+ToolWorker::~ToolWorker()
+{
+  QTE_D();
+
+  // Make sure the tool has stopped before its data goes away
+  delete d->tool;
+  delete d->segment;
+}
+
+//-----------------------------------------------------------------------------
+bool ToolWorker::start()
+{
+  QTE_D();
+
+  // Connect to the process which started us
+  d->socket.connectToServer(d->serverName);
+  if (!d->socket.waitForConnected(ConnectTimeout))
+  {
+    qWarning() << "Failed to connect to tool server" << d->serverName << ":"
+               << d->socket.errorString();
+    return false;
+  }
+
+  // Create tool
+  d->tool = ToolProcess::createTool(d->toolName, 0);
+  if (!d->tool)
+  {
+    qWarning() << "Tool" << d->toolName << "cannot be run in a worker";
+    return false;
+  }
+
+  // Read input
+  auto const& data = ToolProcess::fetch(d->serverName + "-input");
+  if (!data)
+  {
+    return false;
+  }
+
+  d->tool->setActiveFrame(data->activeFrame);
+  d->tool->setImagePaths(data->imagePaths);
+  d->tool->setTracks(data->tracks);
+  d->tool->setCameras(data->cameras);
+  d->tool->setLandmarks(data->landmarks);
+  d->send("loaded");
+
+  // Run tool
+  connect(d->tool, SIGNAL(updated(std::shared_ptr<ToolData>)),
+          this, SLOT(sendUpdate(std::shared_ptr<ToolData>)));
+  connect(d->tool, SIGNAL(completed()), this, SLOT(sendResult()));
+
+  return d->tool->execute();
+}
+
+//-----------------------------------------------------------------------------
+void ToolWorker::readMessages()
+{
+  QTE_D();
+
+  while (d->socket.canReadLine())
+  {
+    auto const& message = d->socket.readLine().trimmed();
+    if (message == "ack")
+    {
+      delete d->segment;
+      d->segment = 0;
+
+      if (d->resultSent)
+      {
+        QCoreApplication::exit(0);
+      }
+      else if (d->resultPending)
+      {
+        d->publishResult();
+      }
+      else if (d->pendingUpdate)
+      {
+        d->publish(d->pendingUpdate, "update");
+        d->pendingUpdate.reset();
+      }
+    }
+    else if (message == "cancel" && d->tool)
+    {
+      d->tool->cancel();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolWorker::disconnected()
+{
+  QTE_D();
+
+  // The process which started us has gone away; stop as soon as possible
+  d->orphaned = true;
+  if (d->tool)
+  {
+    d->tool->cancel();
+  }
+  if (d->resultSent)
+  {
+    QCoreApplication::exit(1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolWorker::sendUpdate(std::shared_ptr<ToolData> data)
+{
+  QTE_D();
+
+  if (d->orphaned || d->resultPending || d->resultSent)
+  {
+    return;
+  }
+
+  if (d->segment)
+  {
+    // Previous update has not been consumed yet; replace any update already
+    // waiting to be sent
+    d->pendingUpdate = data;
+  }
+  else
+  {
+    d->publish(data, "update");
+  }
+}
+
+//-----------------------------------------------------------------------------
+void ToolWorker::sendResult()
+{
+  QTE_D();
+
+  if (d->orphaned)
+  {
+    QCoreApplication::exit(1);
+    return;
+  }
+
+  d->pendingUpdate.reset();
+  d->resultPending = true;
+  if (!d->segment)
+  {
+    d->publishResult();
+  }
+}
@@ -0,0 +1,77 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_TOOLWORKER_H_
+#define MAPTK_TOOLWORKER_H_
+
+#include <qtGlobal.h>
+
+#include <QtCore/QObject>
+
+#include <memory>
+
+class ToolData;
+
+class ToolWorkerPrivate;
+
+/// Worker process side of ToolProcess.
+///
+/// The worker connects to the local server named by the process which started
+/// it, reads the tool input from shared memory, runs the tool, and sends
+/// updates and the final result back. Only one update is in flight at a time;
+/// updates produced while waiting for the previous one to be acknowledged are
+/// coalesced, keeping only the most recent.
+class ToolWorker : public QObject
+{
+  Q_OBJECT
+
+public:
+  ToolWorker(QString const& toolName, QString const& serverName,
+             QObject* parent = 0);
+  virtual ~ToolWorker();
+
+  /// Connect to the server, read the input, and start the tool.
+  bool start();
+
+protected slots:
+  void readMessages();
+  void disconnected();
+
+  void sendUpdate(std::shared_ptr<ToolData>);
+  void sendResult();
+
+private:
+  QTE_DECLARE_PRIVATE_RPTR(ToolWorker)
+  QTE_DECLARE_PRIVATE(ToolWorker)
+
+  QTE_DISABLE_COPY(ToolWorker)
+};
+
+#endif
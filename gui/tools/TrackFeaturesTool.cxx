@@ -38,6 +38,7 @@
 #include <vital/algo/track_features.h>
 
 #include <vital/config/config_block_io.h>
+#include <vital/util/thread_pool.h>
 #include <vital/video_metadata/video_metadata.h>
 #include <vital/video_metadata/video_metadata_traits.h>
 
@@ -48,6 +49,12 @@
 
 #include <QtCore/QDir>
 
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <thread>
+#include <vector>
+
 using kwiver::vital::algo::image_io;
 using kwiver::vital::algo::image_io_sptr;
 using kwiver::vital::algo::convert_image;
@@ -61,6 +68,16 @@ static char const* const BLOCK_IR = "image_reader";
 static char const* const BLOCK_CI = "image_converter";
 static char const* const BLOCK_TF = "feature_tracker";
 
+// Maximum memory used by frames which have been read ahead, in bytes
+static size_t const MaxReadAheadMemory = size_t{512} * 1024 * 1024;
+
+//-----------------------------------------------------------------------------
+struct Frame
+{
+  kwiver::vital::image_container_sptr image;
+  kwiver::vital::image_container_sptr converted;
+};
+
 //-----------------------------------------------------------------------------
 kwiver::vital::config_block_sptr readConfig(std::string const& name)
 {
@@ -84,8 +101,10 @@ kwiver::vital::config_block_sptr readConfig(std::string const& name)
 class TrackFeaturesToolPrivate
 {
 public:
-  image_io_sptr image_reader;
-  convert_image_sptr image_converter;
+  // One reader and converter per read-ahead slot, since the algorithms are
+  // not required to be safe to call from several threads at once
+  std::vector<image_io_sptr> image_readers;
+  std::vector<convert_image_sptr> image_converters;
   track_features_sptr feature_tracker;
 };
 
@@ -149,8 +168,16 @@ bool TrackFeaturesTool::execute(QWidget* window)
   }
 
   // Create algorithm from configuration
-  image_io::set_nested_algo_configuration(BLOCK_IR, config, d->image_reader);
-  convert_image::set_nested_algo_configuration(BLOCK_CI, config, d->image_converter);
+  auto const readerCount = std::max(1u, std::thread::hardware_concurrency());
+  d->image_readers.resize(readerCount);
+  d->image_converters.resize(readerCount);
+  for (unsigned k = 0; k < readerCount; ++k)
+  {
+    image_io::set_nested_algo_configuration(
+      BLOCK_IR, config, d->image_readers[k]);
+    convert_image::set_nested_algo_configuration(
+      BLOCK_CI, config, d->image_converters[k]);
+  }
   track_features::set_nested_algo_configuration(BLOCK_TF, config, d->feature_tracker);
 
   return AbstractTool::execute(window);
@@ -165,35 +192,96 @@ void TrackFeaturesTool::run()
   auto const& paths = this->imagePaths();
   auto tracks = this->tracks();
 
+  // Read ahead: load and convert upcoming images in the background while the
+  // current image is being tracked; the number of images in flight is
+  // limited by the memory used by the most recently loaded image
+  //
+  // Images are dealt to the readers (and converters) in turn, and no more
+  // images than readers are in flight at once, so no two reads in flight
+  // share a reader or converter
+  auto const maxReadAhead = d->image_readers.size();
+
+  std::deque<std::future<Frame>> pending;
+  auto next = frame;
+  size_t frameSize = 0;
+
+  auto const readAhead = [&]{
+    auto const limit =
+      (frameSize ? std::max(size_t{1}, std::min(maxReadAhead,
+                                                MaxReadAheadMemory / frameSize))
+                 : size_t{1});
+    while (next < paths.size() && pending.size() < limit)
+    {
+      auto const slot = next % maxReadAhead;
+      auto const reader = d->image_readers[slot];
+      auto const converter = d->image_converters[slot];
+      auto const path = paths[next++];
+      pending.push_back(kwiver::vital::thread_pool::instance().enqueue(
+        [reader, converter, path]{
+          auto const image = reader->load(path);
+          return Frame{image, converter->convert(image)};
+        }));
+    }
+  };
+
   unsigned int i=frame;
-  for(; i<paths.size(); ++i)
+  try
   {
-    auto const image = d->image_reader->load(paths[i]);
-    auto const converted_image = d->image_converter->convert(image);
-
-    // Set the metadata on the image.
-    // For now, the only metadata is the filename of the image.
-    auto md = std::make_shared<kwiver::vital::video_metadata>();
-    md->add( NEW_METADATA_ITEM( kwiver::vital::VITAL_META_IMAGE_FILENAME, paths[i] ) );
-    converted_image->set_metadata(md);
-
-    tracks = d->feature_tracker->track(tracks, i, converted_image);
-    if (tracks)
+    for(; i<paths.size(); ++i)
     {
-      tracks = kwiver::maptk::extract_feature_colors(tracks, *image, i);
+      readAhead();
+      auto const loaded = pending.front().get();
+      pending.pop_front();
+
+      auto const& image = loaded.image;
+      auto const& converted_image = loaded.converted;
+      frameSize = image->size() +
+                  (converted_image != image ? converted_image->size() : 0);
+
+      // Start reading the following images before tracking this one
+      readAhead();
+
+      // Set the metadata on the image.
+      // For now, the only metadata is the filename of the image.
+      auto md = std::make_shared<kwiver::vital::video_metadata>();
+      md->add( NEW_METADATA_ITEM( kwiver::vital::VITAL_META_IMAGE_FILENAME, paths[i] ) );
+      converted_image->set_metadata(md);
+
+      tracks = d->feature_tracker->track(tracks, i, converted_image);
+      if (tracks)
+      {
+        tracks = kwiver::maptk::extract_feature_colors(tracks, *image, i);
+      }
+
+      // make a copy of the tool data, if the GUI is ready for an update
+      this->reportProgress([&]{
+        auto data = std::make_shared<ToolData>();
+        data->copyTracks(tracks);
+        data->activeFrame = i;
+        return data;
+      });
+      if( this->isCanceled() )
+      {
+        break;
+      }
     }
-
-    // make a copy of the tool data
-    auto data = std::make_shared<ToolData>();
-    data->copyTracks(tracks);
-    data->activeFrame = i;
-
-    emit updated(data);
-    if( this->isCanceled() )
+  }
+  catch (...)
+  {
+    // Don't leave reads running when unwinding
+    for (auto& f : pending)
     {
-      break;
+      f.wait();
     }
+    throw;
   }
+
+  // Wait for any reads still in flight (e.g. if canceled)
+  for (auto& f : pending)
+  {
+    f.wait();
+  }
+
   this->updateTracks(tracks);
   this->setActiveFrame(i);
 }
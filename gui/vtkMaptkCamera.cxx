@@ -38,11 +38,20 @@
 
 #include <vtksys/SystemTools.hxx>
 
+#include <algorithm>
+
 vtkStandardNewMacro(vtkMaptkCamera);
 
 namespace // anonymous
 {
 
+// Number of points transformed at once by ProjectPoints
+static vtkIdType const ProjectionBlockSize = 1024;
+
+// Fraction of the image size by which the culling frustum is enlarged, to
+// allow for lens distortion
+static double const CullingMargin = 0.25;
+
 //-----------------------------------------------------------------------------
 void BuildCamera(vtkMaptkCamera* out, kwiver::vital::camera_sptr const& in,
                  kwiver::vital::camera_intrinsics_sptr const& ci)
@@ -114,6 +123,89 @@ bool vtkMaptkCamera::ProjectPoint(kwiver::vital::vector_3d const& in,
   out[1] = ppos[1];
   return true;
 }
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkMaptkCamera::ProjectPoints(
+  vtkIdType count, double const* points, double* projPoints,
+  vtkIdType* indices)
+{
+  using kwiver::vital::matrix_3x3d;
+  using kwiver::vital::vector_3d;
+
+  typedef Eigen::Matrix<double, 3, Eigen::Dynamic> Matrix3Xd;
+  typedef Eigen::Map<Matrix3Xd const> ConstMap3Xd;
+
+  auto const& ci = this->MaptkCamera->intrinsics();
+
+  double w = this->ImageDimensions[0], h = this->ImageDimensions[1];
+  if (w < 0.0 || h < 0.0)
+  {
+    // Guess image size
+    auto const& s = ci->principal_point() * 2.0;
+    w = s[0];
+    h = s[1];
+  }
+
+  // Cull against the side planes of the camera frustum, enlarged to allow for
+  // distortion; the planes are tested in homogeneous image space, where they
+  // are u >= umin * z, etc., rather than using the VTK view frustum (which is
+  // symmetric about the view direction and has a far clipping plane)
+  auto const mw = CullingMargin * w, mh = CullingMargin * h;
+  auto const umin = -mw, umax = w + mw;
+  auto const vmin = -mh, vmax = h + mh;
+
+  auto const& k = ci->as_matrix();
+  auto const& r = this->MaptkCamera->rotation().matrix();
+  auto const kr = matrix_3x3d(k * r);
+  auto const kt = vector_3d(k * this->MaptkCamera->translation());
+
+  auto const& d = ci->dist_coeffs();
+  auto const distorted =
+    std::any_of(d.begin(), d.end(), [](double c){ return c != 0.0; });
+
+  vtkIdType out = 0;
+  Matrix3Xd homogeneous;
+  for (vtkIdType first = 0; first < count; first += ProjectionBlockSize)
+  {
+    // Transform a block of points to homogeneous image coordinates
+    auto const n = std::min(ProjectionBlockSize, count - first);
+    auto const block = ConstMap3Xd(points + 3 * first, 3, n);
+    homogeneous.noalias() = kr * block;
+    homogeneous.colwise() += kt;
+
+    for (vtkIdType i = 0; i < n; ++i)
+    {
+      auto const& p = homogeneous.col(i);
+      auto const z = p[2];
+      if (z <= 0.0 ||
+          p[0] < umin * z || p[0] > umax * z ||
+          p[1] < vmin * z || p[1] > vmax * z)
+      {
+        continue;
+      }
+
+      // Project the survivors exactly
+      auto u = p[0] / z, v = p[1] / z;
+      if (distorted)
+      {
+        auto const& pp = this->MaptkCamera->project(vector_3d(block.col(i)));
+        u = pp[0];
+        v = pp[1];
+      }
+
+      if (u >= 0.0 && u <= w && v >= 0.0 && v <= h)
+      {
+        projPoints[2 * out + 0] = u;
+        projPoints[2 * out + 1] = v;
+        indices[out] = first + i;
+        ++out;
+      }
+    }
+  }
+
+  return out;
+}
+
 /**
   *
   * WARNING: The convention here is that depth is NOT the distance between the
@@ -54,6 +54,15 @@ public:
   bool ProjectPoint(kwiver::vital::vector_3d const& point,
                     double (&projPoint)[2]);
 
+  // Description:
+  // Project packed 3D points (x, y, z) to 2D using the internal maptk camera,
+  // discarding points which are behind the camera or outside the image. The
+  // projected points (x, y) and the indices of the corresponding input points
+  // are written to projPoints and indices, which must have room for count
+  // points. Returns the number of points projected.
+  vtkIdType ProjectPoints(vtkIdType count, double const* points,
+                          double* projPoints, vtkIdType* indices);
+
   // Description:
   // Reverse project 2D point to 3D using the internal maptk camera and
   // specified depth
@@ -36,20 +36,27 @@
 
 
 #include <vtkActor.h>
-#include <vtkAppendPolyData.h>
+#include <vtkBitArray.h>
 #include <vtkCellArray.h>
 #include <vtkCollection.h>
+#include <vtkFloatArray.h>
 #include <vtkFrustumSource.h>
+#include <vtkGlyph3DMapper.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPlanes.h>
+#include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataMapper.h>
 #include <vtkProperty.h>
+#include <vtkTimeStamp.h>
+#include <vtkTransform.h>
 
+#include <algorithm>
+#include <cmath>
 #include <map>
-#include <unordered_map>
-#include <unordered_set>
 
 vtkStandardNewMacro(vtkMaptkCameraRepresentation);
 
@@ -58,7 +65,9 @@ using kwiver::vital::vector_3d;
 namespace // anonymous
 {
 
-typedef vtkSmartPointer<vtkPolyData> PolyDataPointer;
+char const* const OrientationArrayName = "Orientation";
+char const* const ScaleArrayName = "Scale";
+char const* const MaskArrayName = "Mask";
 
 //-----------------------------------------------------------------------------
 void BuildCameraFrustum(
@@ -121,30 +130,68 @@ void BuildCameraFrustum(
 }
 
 //-----------------------------------------------------------------------------
-void SetInputs(vtkAppendPolyData* apd, std::unordered_set<vtkPolyData*> inputs)
+void BuildFrustumTemplate(vtkPolyData* polyData)
 {
-  // Walk the list of existing inputs, removing any that aren't in the new list
-  auto i = apd->GetNumberOfInputConnections(0);
-  while (i--)
+  // Build a unit frustum in the camera's local frame (looking down -Z, with +Y
+  // up); this is scaled in X and Y by each camera's field of view and in Z by
+  // the representation length to produce the frustum of an individual camera
+  vtkNew<vtkPoints> points;
+  points->InsertNextPoint( 0.0,  0.0,  0.0); // apex (camera center)
+  points->InsertNextPoint(-1.0, -1.0, -1.0);
+  points->InsertNextPoint(+1.0, -1.0, -1.0);
+  points->InsertNextPoint(+1.0, +1.0, -1.0);
+  points->InsertNextPoint(-1.0, +1.0, -1.0);
+  points->InsertNextPoint( 0.0, +2.0, -1.0); // "roof" indicating up
+
+  vtkNew<vtkCellArray> polys;
+  vtkIdType const sides[4][3] = {{0, 1, 2}, {0, 2, 3}, {0, 3, 4}, {0, 4, 1}};
+  for (auto const& side : sides)
   {
-    auto const input = apd->GetInput(i);
-    auto const ii = inputs.find(input);
-    if (ii != inputs.end())
-    {
-      inputs.erase(ii);
-    }
-    else
-    {
-      apd->RemoveInputConnection(0, apd->GetInputConnection(0, i));
-    }
+    polys->InsertNextCell(3, side);
   }
+  vtkIdType const base[4] = {1, 2, 3, 4};
+  polys->InsertNextCell(4, base);
+  vtkIdType const roof[3] = {3, 4, 5};
+  polys->InsertNextCell(3, roof);
+
+  polyData->SetPoints(points.GetPointer());
+  polyData->SetPolys(polys.GetPointer());
+}
+
+//-----------------------------------------------------------------------------
+void ComputeFrustumTransform(vtkCamera* camera, double position[3],
+                             double orientation[3], double scale[3])
+{
+  camera->GetPosition(position);
+
+  // Compute orthonormal camera frame
+  vector_3d direction, up;
+  camera->GetDirectionOfProjection(direction.data());
+  camera->GetViewUp(up.data());
+
+  direction.normalize();
+  up = (up - (up.dot(direction) * direction)).normalized();
+  auto const right = vector_3d(direction.cross(up));
 
-  // Anything still in the new inputs list is missing from the existing inputs,
-  // so now we can add those
-  for (auto const input : inputs)
+  // Convert frame to orientation angles
+  vtkNew<vtkMatrix4x4> rotation;
+  for (int i = 0; i < 3; ++i)
   {
-    apd->AddInputData(input);
+    rotation->SetElement(i, 0, right[i]);
+    rotation->SetElement(i, 1, up[i]);
+    rotation->SetElement(i, 2, -direction[i]);
   }
+  vtkTransform::GetOrientation(orientation, rotation.GetPointer());
+
+  // Compute extents of the far plane at unit distance
+  auto const maptkCamera = vtkMaptkCamera::SafeDownCast(camera);
+  auto const aspect = (maptkCamera ? maptkCamera->GetAspectRatio() : 1.0);
+  auto const halfAngle =
+    vtkMath::RadiansFromDegrees(0.5 * camera->GetViewAngle());
+
+  scale[1] = tan(halfAngle);
+  scale[0] = scale[1] * aspect;
+  scale[2] = 1.0;
 }
 
 } // namespace <anonymous>
@@ -153,25 +200,87 @@ void SetInputs(vtkAppendPolyData* apd, std::unordered_set<vtkPolyData*> inputs)
 class vtkMaptkCameraRepresentation::vtkInternal
 {
 public:
-  vtkCamera* NextCamera();
+  void UpdateInstances();
+  void UpdateMask(vtkCamera* activeCamera, int displayDensity);
 
   std::map<int, vtkCamera*> Cameras;
 
   vtkNew<vtkPolyData> ActivePolyData;
-  vtkNew<vtkAppendPolyData> NonActiveAppendPolyData;
 
-  vtkNew<vtkPolyData> DummyPolyData;
+  vtkNew<vtkPolyData> FrustumTemplate;
+  vtkNew<vtkPolyData> Instances;
+  vtkNew<vtkFloatArray> Orientations;
+  vtkNew<vtkFloatArray> Scales;
+  vtkNew<vtkBitArray> Mask;
+  vtkNew<vtkGlyph3DMapper> NonActiveMapper;
 
   vtkNew<vtkPolyData> PathPolyData;
 
-  std::unordered_map<vtkCamera*, PolyDataPointer> CameraNonActivePolyData;
+  vtkTimeStamp InstancesBuildTime;
 
   vtkCamera* LastActiveCamera;
-  double LastNonActiveCameraRepLength;
+  vtkCamera* LastMaskedCamera;
+  int LastDisplayDensity;
 
+  bool InstancesNeedUpdate;
   bool PathNeedsUpdate;
 };
 
+//-----------------------------------------------------------------------------
+void vtkMaptkCameraRepresentation::vtkInternal::UpdateInstances()
+{
+  auto const count = static_cast<vtkIdType>(this->Cameras.size());
+
+  auto const points = this->Instances->GetPoints();
+  points->SetNumberOfPoints(count);
+  this->Orientations->SetNumberOfTuples(count);
+  this->Scales->SetNumberOfTuples(count);
+
+  auto const orientations = this->Orientations->GetPointer(0);
+  auto const scales = this->Scales->GetPointer(0);
+
+  vtkIdType i = 0;
+  for (auto const& camData : this->Cameras)
+  {
+    double position[3], orientation[3], scale[3];
+    ComputeFrustumTransform(camData.second, position, orientation, scale);
+
+    points->SetPoint(i, position);
+    std::copy(orientation, orientation + 3, orientations + (3 * i));
+    std::copy(scale, scale + 3, scales + (3 * i));
+    ++i;
+  }
+
+  points->Modified();
+  this->Orientations->Modified();
+  this->Scales->Modified();
+  this->Instances->Modified();
+
+  this->InstancesBuildTime.Modified();
+  this->InstancesNeedUpdate = false;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkCameraRepresentation::vtkInternal::UpdateMask(
+  vtkCamera* activeCamera, int displayDensity)
+{
+  auto const density = std::max(1, displayDensity);
+
+  this->Mask->SetNumberOfTuples(static_cast<vtkIdType>(this->Cameras.size()));
+
+  vtkIdType i = 0;
+  for (auto const& camData : this->Cameras)
+  {
+    auto const show = !(i % density) && camData.second != activeCamera;
+    this->Mask->SetValue(i++, show ? 1 : 0);
+  }
+
+  this->Mask->Modified();
+  this->Instances->Modified();
+
+  this->LastMaskedCamera = activeCamera;
+  this->LastDisplayDensity = displayDensity;
+}
 
 //-----------------------------------------------------------------------------
 vtkMaptkCameraRepresentation::vtkMaptkCameraRepresentation()
@@ -184,7 +293,9 @@ vtkMaptkCameraRepresentation::vtkMaptkCameraRepresentation()
   this->ActiveCamera = 0;
 
   this->Internal->LastActiveCamera = 0;
-  this->Internal->LastNonActiveCameraRepLength = -1.0;
+  this->Internal->LastMaskedCamera = 0;
+  this->Internal->LastDisplayDensity = -1;
+  this->Internal->InstancesNeedUpdate = false;
   this->Internal->PathNeedsUpdate = false;
 
   // Set up camera actors and data
@@ -196,15 +307,40 @@ vtkMaptkCameraRepresentation::vtkMaptkCameraRepresentation()
   this->ActiveActor->GetProperty()->SetRepresentationToWireframe();
   this->ActiveActor->GetProperty()->SetLighting(false);
 
-  this->Internal->NonActiveAppendPolyData->AddInputData(
-    this->Internal->DummyPolyData.GetPointer());
-
-  vtkNew<vtkPolyDataMapper> nonActiveMapper;
-  nonActiveMapper->SetInputConnection(
-    this->Internal->NonActiveAppendPolyData->GetOutputPort());
+  // Set up non-active cameras as instances of a single frustum glyph; each
+  // camera contributes only a position, orientation and (field of view) scale,
+  // while the representation length is applied as the glyph scale factor
+  vtkNew<vtkPoints> instancePoints;
+  this->Internal->Orientations->SetName(OrientationArrayName);
+  this->Internal->Orientations->SetNumberOfComponents(3);
+  this->Internal->Scales->SetName(ScaleArrayName);
+  this->Internal->Scales->SetNumberOfComponents(3);
+  this->Internal->Mask->SetName(MaskArrayName);
+  this->Internal->Mask->SetNumberOfComponents(1);
+
+  auto const instanceData = this->Internal->Instances->GetPointData();
+  this->Internal->Instances->SetPoints(instancePoints.GetPointer());
+  instanceData->AddArray(this->Internal->Orientations.GetPointer());
+  instanceData->AddArray(this->Internal->Scales.GetPointer());
+  instanceData->AddArray(this->Internal->Mask.GetPointer());
+
+  BuildFrustumTemplate(this->Internal->FrustumTemplate.GetPointer());
+
+  auto const nonActiveMapper = this->Internal->NonActiveMapper.GetPointer();
+  nonActiveMapper->SetInputData(this->Internal->Instances.GetPointer());
+  nonActiveMapper->SetSourceData(this->Internal->FrustumTemplate.GetPointer());
+  nonActiveMapper->SetOrientationArray(OrientationArrayName);
+  nonActiveMapper->SetOrientationModeToRotation();
+  nonActiveMapper->SetScaleArray(ScaleArrayName);
+  nonActiveMapper->SetScaleModeToScaleByVectorComponents();
+  nonActiveMapper->SetScaleFactor(this->NonActiveCameraRepLength);
+  nonActiveMapper->SetScaling(true);
+  nonActiveMapper->SetMaskArray(MaskArrayName);
+  nonActiveMapper->SetMasking(true);
+  nonActiveMapper->ScalarVisibilityOff();
 
   this->NonActiveActor = vtkActor::New();
-  this->NonActiveActor->SetMapper(nonActiveMapper.GetPointer());
+  this->NonActiveActor->SetMapper(nonActiveMapper);
   this->NonActiveActor->GetProperty()->SetRepresentationToWireframe();
 
   // Set up path actor and data
@@ -244,6 +380,7 @@ void vtkMaptkCameraRepresentation::AddCamera(int id, vtkCamera* camera)
 
   this->Internal->Cameras[id] = camera;
   camera->Register(this);
+  this->Internal->InstancesNeedUpdate = true;
   this->Internal->PathNeedsUpdate = true;
   this->Modified();
 }
@@ -258,14 +395,6 @@ void vtkMaptkCameraRepresentation::RemoveCamera(int id)
     return;
   }
 
-  // Remove camera from non-active polydata collection
-  auto const pd = this->Internal->CameraNonActivePolyData.find(camIter->second);
-  if (pd != this->Internal->CameraNonActivePolyData.end())
-  {
-    this->Internal->NonActiveAppendPolyData->RemoveInputData(pd->second);
-    this->Internal->CameraNonActivePolyData.erase(pd);
-  }
-
   if (this->ActiveCamera == camIter->second)
   {
     this->ActiveCamera = 0;
@@ -273,6 +402,7 @@ void vtkMaptkCameraRepresentation::RemoveCamera(int id)
 
   camIter->second->UnRegister(this);
   this->Internal->Cameras.erase(camIter);
+  this->Internal->InstancesNeedUpdate = true;
   this->Internal->PathNeedsUpdate = true;
   this->Modified();
 }
@@ -294,47 +424,39 @@ void vtkMaptkCameraRepresentation::SetActiveCamera(int id)
 //-----------------------------------------------------------------------------
 void vtkMaptkCameraRepresentation::Update()
 {
-  if (this->Internal->LastNonActiveCameraRepLength !=
-      this->NonActiveCameraRepLength)
+  // The non-active camera length is just the glyph scale factor, so changing
+  // it does not require rebuilding anything
+  this->Internal->NonActiveMapper->SetScaleFactor(
+    this->NonActiveCameraRepLength);
+
+  // Rebuild the per-camera transforms if cameras were added or removed, or if
+  // any camera was modified since they were last built
+  auto instancesNeedUpdate = this->Internal->InstancesNeedUpdate;
+  if (!instancesNeedUpdate)
   {
-    // If the non-active camera length has changed, the old polydata's are not
-    // useful, and every camera needs to be updated
-    this->Internal->CameraNonActivePolyData.clear();
-  }
-  this->Internal->LastNonActiveCameraRepLength = this->NonActiveCameraRepLength;
-
-  // (Re)build non-active cameras representation and build polydata for any
-  // cameras that are missing
-  std::unordered_set<vtkPolyData*> nonActivePolyData;
-  int skipCount = 0;
-  for(auto const camData : this->Internal->Cameras)
-  {
-    if (!((skipCount++) % this->DisplayDensity))
+    auto const buildTime = this->Internal->InstancesBuildTime.GetMTime();
+    for (auto const& camData : this->Internal->Cameras)
     {
-      if (camData.second != this->ActiveCamera)
+      if (camData.second->GetMTime() > buildTime)
       {
-        auto& pd = this->Internal->CameraNonActivePolyData[camData.second];
-        if (!pd)
-        {
-          // If we don't already have polydata for this non-active camera,
-          // build it now
-          pd = PolyDataPointer::New();
-          BuildCameraFrustum(camData.second, this->NonActiveCameraRepLength, pd);
-        }
-        nonActivePolyData.insert(pd);
+        instancesNeedUpdate = true;
+        break;
       }
     }
   }
 
-  if (nonActivePolyData.empty())
+  if (instancesNeedUpdate)
   {
-    // vtkAppendPolyData complains if it has no inputs, so if there aren't any
-    // non-active cameras, add the dummy polydata
-    nonActivePolyData.insert(this->Internal->DummyPolyData.GetPointer());
+    this->Internal->UpdateInstances();
   }
 
-  SetInputs(this->Internal->NonActiveAppendPolyData.GetPointer(),
-            nonActivePolyData);
+  // Update which cameras are shown as non-active
+  if (instancesNeedUpdate ||
+      this->Internal->LastMaskedCamera != this->ActiveCamera ||
+      this->Internal->LastDisplayDensity != this->DisplayDensity)
+  {
+    this->Internal->UpdateMask(this->ActiveCamera, this->DisplayDensity);
+  }
 
   // (Re)build active camera representation if needed
   if (!this->ActiveCamera)
@@ -63,7 +63,8 @@ public:
 
   // Description:
   // Get/Set the distance to the far clipping plane of the non-active cameras
-  // actor. (default == 4)
+  // actor. The non-active cameras are drawn as instances of a single frustum,
+  // so changing this only changes the instance scale. (default == 4)
   vtkGetMacro(NonActiveCameraRepLength, double);
   vtkSetMacro(NonActiveCameraRepLength, double);
 
@@ -0,0 +1,357 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "vtkMaptkOctreePointLOD.h"
+
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
+#include <vtkObjectFactory.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+vtkStandardNewMacro(vtkMaptkOctreePointLOD);
+
+namespace // anonymous
+{
+
+// Maximum subdivision depth; guards against unbounded recursion when many
+// points are coincident
+static auto const MaxDepth = 20;
+
+//-----------------------------------------------------------------------------
+struct Leaf
+{
+  vtkIdType Begin;
+  vtkIdType End;
+  double Center[3];
+  double Radius;
+};
+
+//-----------------------------------------------------------------------------
+bool InView(Leaf const& leaf, double const (&planes)[24])
+{
+  // Only the side planes are tested; the near and far planes depend on the
+  // clipping range, which is itself computed from what is currently shown
+  for (int i = 0; i < 4; ++i)
+  {
+    auto const* const p = planes + (4 * i);
+    auto const d = (p[0] * leaf.Center[0]) + (p[1] * leaf.Center[1]) +
+                   (p[2] * leaf.Center[2]) + p[3];
+    if (d < -leaf.Radius)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace <anonymous>
+
+//-----------------------------------------------------------------------------
+class vtkMaptkOctreePointLOD::vtkInternal
+{
+public:
+  void Subdivide(vtkMaptkOctreePointLOD* self, double const* points,
+                 vtkIdType* first, vtkIdType* last,
+                 double const (&bounds)[6], int depth);
+  void AddLeaf(double const* points, vtkIdType* first, vtkIdType* last);
+
+  std::vector<vtkIdType> Order;
+  std::vector<Leaf> Leaves;
+
+  std::mt19937 Random;
+
+  // Scratch space for SelectPoints
+  std::vector<double> Desired;
+  std::vector<vtkIdType> Selected;
+};
+
+//-----------------------------------------------------------------------------
+void vtkMaptkOctreePointLOD::vtkInternal::Subdivide(
+  vtkMaptkOctreePointLOD* self, double const* points,
+  vtkIdType* first, vtkIdType* last, double const (&bounds)[6], int depth)
+{
+  if (last - first <= self->LeafCapacity || depth >= MaxDepth)
+  {
+    this->AddLeaf(points, first, last);
+    return;
+  }
+
+  double const mid[3] = {
+    0.5 * (bounds[0] + bounds[1]),
+    0.5 * (bounds[2] + bounds[3]),
+    0.5 * (bounds[4] + bounds[5]),
+  };
+
+  auto const below = [points, &mid](int axis){
+    return [points, &mid, axis](vtkIdType i){
+      return points[(3 * i) + axis] < mid[axis];
+    };
+  };
+
+  // Partition in place along z, then y, then x; the index of each octant is
+  // then (z << 2) | (y << 1) | x, and split[n]..split[n + 1] is its range
+  vtkIdType* split[9];
+  split[0] = first;
+  split[8] = last;
+  split[4] = std::partition(split[0], split[8], below(2));
+  split[2] = std::partition(split[0], split[4], below(1));
+  split[6] = std::partition(split[4], split[8], below(1));
+  for (int n = 0; n < 8; n += 2)
+  {
+    split[n + 1] = std::partition(split[n], split[n + 2], below(0));
+  }
+
+  for (int n = 0; n < 8; ++n)
+  {
+    if (split[n] == split[n + 1])
+    {
+      continue;
+    }
+
+    double childBounds[6];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      auto const upper = (n >> axis) & 1;
+      childBounds[(2 * axis) + 0] = (upper ? mid[axis] : bounds[2 * axis]);
+      childBounds[(2 * axis) + 1] = (upper ? bounds[(2 * axis) + 1] : mid[axis]);
+    }
+
+    this->Subdivide(self, points, split[n], split[n + 1],
+                    childBounds, depth + 1);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkOctreePointLOD::vtkInternal::AddLeaf(
+  double const* points, vtkIdType* first, vtkIdType* last)
+{
+  // Shuffle the points of the leaf so that any prefix of them is a uniform
+  // subsample of the leaf
+  std::shuffle(first, last, this->Random);
+
+  // Compute tight bounding sphere (approximated from the bounding box)
+  double bounds[6] = {
+    VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+    VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+    VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+  };
+  for (auto i = first; i != last; ++i)
+  {
+    auto const* const p = points + (3 * (*i));
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      bounds[(2 * axis) + 0] = std::min(bounds[(2 * axis) + 0], p[axis]);
+      bounds[(2 * axis) + 1] = std::max(bounds[(2 * axis) + 1], p[axis]);
+    }
+  }
+
+  Leaf leaf;
+  leaf.Begin = first - this->Order.data();
+  leaf.End = last - this->Order.data();
+
+  auto r2 = 0.0;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    auto const extent = bounds[(2 * axis) + 1] - bounds[(2 * axis) + 0];
+    leaf.Center[axis] = bounds[(2 * axis) + 0] + (0.5 * extent);
+    r2 += 0.25 * extent * extent;
+  }
+  leaf.Radius = std::sqrt(r2);
+
+  this->Leaves.push_back(leaf);
+}
+
+//-----------------------------------------------------------------------------
+vtkMaptkOctreePointLOD::vtkMaptkOctreePointLOD()
+  : Internal(new vtkInternal)
+{
+  this->LeafCapacity = 1024;
+  this->FullDetailSize = 0.05;
+}
+
+//-----------------------------------------------------------------------------
+vtkMaptkOctreePointLOD::~vtkMaptkOctreePointLOD()
+{
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkOctreePointLOD::Build(double const* points, vtkIdType count)
+{
+  auto& order = this->Internal->Order;
+
+  this->Internal->Leaves.clear();
+  this->Internal->Random.seed(5489u);
+
+  order.resize(static_cast<size_t>(count));
+  std::iota(order.begin(), order.end(), vtkIdType{0});
+
+  if (count > 0)
+  {
+    double bounds[6] = {
+      VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+      VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+      VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+    };
+    for (vtkIdType i = 0; i < count; ++i)
+    {
+      auto const* const p = points + (3 * i);
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        bounds[(2 * axis) + 0] = std::min(bounds[(2 * axis) + 0], p[axis]);
+        bounds[(2 * axis) + 1] = std::max(bounds[(2 * axis) + 1], p[axis]);
+      }
+    }
+
+    this->Internal->Subdivide(this, points, order.data(),
+                              order.data() + count, bounds, 0);
+  }
+
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkMaptkOctreePointLOD::GetNumberOfPoints() const
+{
+  return static_cast<vtkIdType>(this->Internal->Order.size());
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType const* vtkMaptkOctreePointLOD::GetPointOrder() const
+{
+  return this->Internal->Order.data();
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkMaptkOctreePointLOD::SelectPoints(
+  vtkCamera* camera, double aspect, vtkIdType budget, vtkCellArray* verts)
+{
+  auto const& leaves = this->Internal->Leaves;
+  auto& desired = this->Internal->Desired;
+  auto& selected = this->Internal->Selected;
+
+  desired.assign(leaves.size(), 0.0);
+  selected.assign(leaves.size(), 1);
+
+  double planes[24];
+  camera->GetFrustumPlanes(aspect, planes);
+
+  double position[3];
+  camera->GetPosition(position);
+
+  auto const parallel = !!camera->GetParallelProjection();
+  auto const parallelScale = camera->GetParallelScale();
+
+  // Determine which leaves are in view, and how much detail each should get
+  // based on its apparent size
+  auto visiblePoints = vtkIdType{0};
+  auto totalDesired = 0.0;
+  for (size_t n = 0; n < leaves.size(); ++n)
+  {
+    auto const& leaf = leaves[n];
+    if (!InView(leaf, planes))
+    {
+      continue;
+    }
+
+    auto const count = leaf.End - leaf.Begin;
+    visiblePoints += count;
+
+    auto distance = parallelScale;
+    if (!parallel)
+    {
+      auto const dx = leaf.Center[0] - position[0];
+      auto const dy = leaf.Center[1] - position[1];
+      auto const dz = leaf.Center[2] - position[2];
+      auto const centerDistance = std::sqrt((dx * dx) + (dy * dy) + (dz * dz));
+      distance = std::max(centerDistance - leaf.Radius, 1e-3 * leaf.Radius);
+    }
+
+    auto const size = (distance > 0.0 ? leaf.Radius / distance : 1.0);
+    auto const weight = std::min(1.0, size / this->FullDetailSize);
+    desired[n] = weight * static_cast<double>(count);
+    totalDesired += desired[n];
+  }
+
+  // Allocate points to visible leaves; if everything fits, show all of it
+  auto const showAll = (visiblePoints <= budget);
+  auto const scale =
+    (totalDesired > static_cast<double>(budget)
+     ? static_cast<double>(budget) / totalDesired : 1.0);
+
+  auto totalSelected = vtkIdType{0};
+  for (size_t n = 0; n < leaves.size(); ++n)
+  {
+    if (desired[n] > 0.0)
+    {
+      auto const count = leaves[n].End - leaves[n].Begin;
+      auto const wanted =
+        static_cast<vtkIdType>(std::ceil(desired[n] * scale));
+      selected[n] = (showAll ? count : std::max(vtkIdType{1},
+                                                std::min(count, wanted)));
+    }
+    totalSelected += selected[n];
+  }
+
+  // Write vertex cells for the selected points
+  auto* cells = verts->WritePointer(totalSelected, 2 * totalSelected);
+  for (size_t n = 0; n < leaves.size(); ++n)
+  {
+    auto const begin = leaves[n].Begin;
+    auto const end = begin + selected[n];
+    for (auto i = begin; i < end; ++i)
+    {
+      *(cells++) = 1;
+      *(cells++) = i;
+    }
+  }
+  verts->Modified();
+
+  return visiblePoints;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMaptkOctreePointLOD::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Number Of Points: "
+     << this->Internal->Order.size() << endl;
+  os << indent << "Number Of Leaves: "
+     << this->Internal->Leaves.size() << endl;
+  os << indent << "LeafCapacity: "
+     << this->LeafCapacity << endl;
+  os << indent << "FullDetailSize: "
+     << this->FullDetailSize << endl;
+}
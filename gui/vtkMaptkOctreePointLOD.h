@@ -0,0 +1,107 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPTK_VTKMAPTKOCTREEPOINTLOD_H_
+#define MAPTK_VTKMAPTKOCTREEPOINTLOD_H_
+
+#include <vtkObject.h>
+
+#include <memory>
+
+class vtkCamera;
+class vtkCellArray;
+
+class vtkMaptkOctreePointLOD : public vtkObject
+{
+public:
+  vtkTypeMacro(vtkMaptkOctreePointLOD, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  static vtkMaptkOctreePointLOD* New();
+
+  // Description:
+  // Get/Set the maximum number of points held by a leaf of the octree. Takes
+  // effect at the next call to Build. (default == 1024)
+  vtkGetMacro(LeafCapacity, vtkIdType);
+  vtkSetMacro(LeafCapacity, vtkIdType);
+
+  // Description:
+  // Get/Set the projected leaf size (leaf radius over distance to the camera)
+  // at and above which a leaf is drawn at full density when the point budget
+  // does not allow every visible point to be drawn. (default == 0.05)
+  vtkGetMacro(FullDetailSize, double);
+  vtkSetMacro(FullDetailSize, double);
+
+  // Description:
+  // Build the octree over \p count points, given as packed (x, y, z) triples.
+  // The points are not retained; instead, the octree computes an ordering of
+  // the points (see GetPointOrder) in which the points of each leaf are
+  // contiguous and randomly shuffled, so that any prefix of a leaf is a
+  // uniform subsample of it. Point ids used by SelectPoints refer to
+  // positions in this ordering.
+  void Build(double const* points, vtkIdType count);
+
+  // Description:
+  // Get the number of points in the octree.
+  vtkIdType GetNumberOfPoints() const;
+
+  // Description:
+  // Get the point ordering computed by Build. Element \c i is the index, in
+  // the input to Build, of the point that should be stored at index \c i.
+  vtkIdType const* GetPointOrder() const;
+
+  // Description:
+  // Select the points to draw for the view of \p camera, and write a vertex
+  // cell for each to \p verts. If the number of points in the view does not
+  // exceed \p budget, all of them are selected; otherwise, points are
+  // distributed among the leaves in the view according to their distance from
+  // the camera, such that approximately \p budget points are selected. Each
+  // leaf outside the view contributes a single point, which keeps the bounds
+  // of the selection close to those of the full set. Returns the number of
+  // points in the view.
+  vtkIdType SelectPoints(vtkCamera* camera, double aspect, vtkIdType budget,
+                         vtkCellArray* verts);
+
+protected:
+  vtkMaptkOctreePointLOD();
+  ~vtkMaptkOctreePointLOD();
+
+private:
+  vtkMaptkOctreePointLOD(vtkMaptkOctreePointLOD const&) = delete;
+  void operator=(vtkMaptkOctreePointLOD const&) = delete;
+
+  vtkIdType LeafCapacity;
+  double FullDetailSize;
+
+  class vtkInternal;
+  std::unique_ptr<vtkInternal> const Internal;
+};
+
+#endif
@@ -31,6 +31,7 @@
 #include "vtkMaptkScalarsToGradient.h"
 
 #include <vtkObjectFactory.h>
+#include <vtkSMPTools.h>
 #include <vtkTemplateAliasMacro.h>
 
 #include <qtGradient.h>
@@ -47,24 +48,60 @@ QTE_IMPLEMENT_D_FUNC(vtkMaptkScalarsToGradient)
 namespace // anonymous
 {
 
-typedef double (*GetValue)(void const*, int);
+// Number of entries in the color lookup table
+static auto const TableSize = 1024;
 
 //-----------------------------------------------------------------------------
-template <typename T>
-double getValue(void const* data, int offset)
+template <int Components, typename T>
+void mapThroughTable(
+  T const* input, int inputIncrement, unsigned char* output,
+  vtkIdType count, unsigned char const* table, double lower, double scale)
 {
-  auto const realData = static_cast<T const*>(data);
-  return static_cast<double>(realData[offset]);
+  auto const last = static_cast<double>(TableSize - 1);
+
+  auto map = [=](vtkIdType begin, vtkIdType end){
+    auto in = input + begin * inputIncrement;
+    auto out = output + begin * Components;
+    for (auto i = begin; i < end; ++i)
+    {
+      auto const k = (static_cast<double>(*in) - lower) * scale;
+
+      // Comparisons are ordered so that NaN maps to the first entry
+      auto const index =
+        (k > 0.0 ? (k < 1.0 ? static_cast<int>(k * last + 0.5)
+                            : TableSize - 1)
+                 : 0);
+
+      auto const entry = table + (4 * index);
+      for (int c = 0; c < Components; ++c)
+      {
+        out[c] = entry[c];
+      }
+
+      in += inputIncrement;
+      out += Components;
+    }
+  };
+
+  vtkSMPTools::For(0, count, map);
 }
 
 //-----------------------------------------------------------------------------
-GetValue typedGetValue(int type)
+template <int Components>
+bool mapThroughTable(
+  void const* input, int inputDataType, int inputIncrement,
+  unsigned char* output, vtkIdType count, unsigned char const* table,
+  double lower, double scale)
 {
-  switch (type)
+  switch (inputDataType)
   {
-    vtkTemplateAliasMacro(return &getValue<VTK_TT>);
+    vtkTemplateAliasMacro(
+      mapThroughTable<Components>(
+        static_cast<VTK_TT const*>(input), inputIncrement, output, count,
+        table, lower, scale);
+      return true);
     default:
-      return 0;
+      return false;
   }
 }
 
@@ -78,6 +115,9 @@ public:
   double scale;
 
   qtGradient gradient;
+
+  // Gradient sampled at TableSize evenly spaced points, as RGBA
+  unsigned char table[4 * TableSize];
 };
 
 //-----------------------------------------------------------------------------
@@ -88,6 +128,7 @@ vtkMaptkScalarsToGradient::vtkMaptkScalarsToGradient()
   d->lower = 0.0;
   d->scale = 1.0;
 
+  this->SetGradient(d->gradient);
   this->vtkScalarsToColors::SetRange(0.0, 1.0);
 }
 
@@ -104,6 +145,17 @@ void vtkMaptkScalarsToGradient::SetGradient(qtGradient const& gradient)
 
   d->gradient = gradient;
 
+  foreach (auto const i, qtIndexRange(TableSize))
+  {
+    auto const c = gradient.at(static_cast<double>(i) / (TableSize - 1));
+
+    auto const entry = d->table + (4 * i);
+    entry[0] = static_cast<unsigned char>(c.red());
+    entry[1] = static_cast<unsigned char>(c.green());
+    entry[2] = static_cast<unsigned char>(c.blue());
+    entry[3] = static_cast<unsigned char>(c.alpha());
+  }
+
   this->Modified();
 }
 
@@ -138,48 +190,32 @@ void vtkMaptkScalarsToGradient::MapScalarsThroughTable2(
 {
   QTE_D();
 
-  auto const get = typedGetValue(inputDataType);
-  if (!get)
-  {
-    vtkErrorMacro(<< __func__ << ": Unknown input data type");
-    return;
-  }
-
+  // Map through the precomputed table; this quantizes the gradient, but is
+  // much faster than evaluating the gradient for each value
+  auto mapped = false;
   switch (outputFormat)
   {
     case VTK_RGBA:
-      foreach (auto const i, qtIndexRange(numberOfValues))
-      {
-        auto const value = (*get)(input, i);
-        auto const k = (value - d->lower) * d->scale;
-        auto const c = d->gradient.at(k);
-
-        auto const out = output + (4 * i);
-        out[0] = c.red();
-        out[1] = c.green();
-        out[2] = c.blue();
-        out[3] = c.alpha();
-      }
+      mapped = mapThroughTable<4>(input, inputDataType, inputIncrement,
+                                  output, numberOfValues, d->table,
+                                  d->lower, d->scale);
       break;
 
     case VTK_RGB:
-      foreach (auto const i, qtIndexRange(numberOfValues))
-      {
-        auto const value = (*get)(input, i);
-        auto const k = (value - d->lower) * d->scale;
-        auto const c = d->gradient.at(k);
-
-        auto const out = output + (3 * i);
-        out[0] = c.red();
-        out[1] = c.green();
-        out[2] = c.blue();
-      }
+      mapped = mapThroughTable<3>(input, inputDataType, inputIncrement,
+                                  output, numberOfValues, d->table,
+                                  d->lower, d->scale);
       break;
 
     default:
       this->vtkScalarsToColors::MapScalarsThroughTable2(
         input, output, inputDataType, numberOfValues,
         inputIncrement, outputFormat);
-      break;
+      return;
+  }
+
+  if (!mapped)
+  {
+    vtkErrorMacro(<< __func__ << ": Unknown input data type");
   }
 }
@@ -0,0 +1,865 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::close_loops_vocabulary_tree
+ */
+
+#include "close_loops_vocabulary_tree.h"
+
+#include <maptk/parallel.h>
+
+#include <vital/algo/match_features.h>
+#include <vital/logger/logger.h>
+#include <vital/types/descriptor_set.h>
+#include <vital/types/feature_set.h>
+#include <vital/types/match_set.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Compute the squared Euclidean distance between two descriptors
+inline float
+distance_sq(float const* a, float const* b, size_t dim)
+{
+  float sum = 0.0f;
+  for (size_t i = 0; i < dim; ++i)
+  {
+    float const d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+
+/// Hierarchical k-means tree quantizing descriptors into visual words
+class vocabulary_tree
+{
+public:
+  vocabulary_tree() : dim_(0), num_words_(0), branching_(0), depth_(0),
+                      iterations_(0) {}
+
+  /// Learn the vocabulary from a set of row-major descriptors
+  void train(std::vector<float> const& data, size_t dim,
+             unsigned branching, unsigned depth, unsigned iterations);
+
+  /// Discard the vocabulary
+  void clear()
+  {
+    nodes_.clear();
+    centers_.clear();
+    num_words_ = 0;
+  }
+
+  bool empty() const { return nodes_.empty(); }
+  size_t dimension() const { return dim_; }
+  unsigned num_words() const { return num_words_; }
+
+  /// Find the visual word of a descriptor
+  unsigned quantize(float const* desc) const;
+
+private:
+  struct node
+  {
+    unsigned first_child;
+    unsigned num_children;
+    unsigned word;
+  };
+
+  void build(float const* data, unsigned n,
+             std::vector<unsigned> members, unsigned level);
+  std::vector<float> cluster(float const* data,
+                             std::vector<unsigned> const& members,
+                             std::vector<unsigned>& labels);
+
+  std::vector<node> nodes_;
+  std::vector<float> centers_;
+  size_t dim_;
+  unsigned num_words_;
+  unsigned branching_;
+  unsigned depth_;
+  unsigned iterations_;
+  std::mt19937 rng_;
+};
+
+
+// ----------------------------------------------------------------------------
+void
+vocabulary_tree
+::train(std::vector<float> const& data, size_t dim,
+        unsigned branching, unsigned depth, unsigned iterations)
+{
+  this->clear();
+  dim_ = dim;
+  branching_ = branching;
+  depth_ = depth;
+  iterations_ = iterations;
+  rng_.seed();
+
+  std::vector<unsigned> members(data.size() / dim);
+  for (unsigned i = 0; i < members.size(); ++i)
+  {
+    members[i] = i;
+  }
+
+  // The root's center is never used, but keeps node and center indices equal
+  nodes_.push_back(node{0, 0, 0});
+  centers_.resize(dim, 0.0f);
+  build(data.data(), 0, std::move(members), 0);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+vocabulary_tree
+::build(float const* data, unsigned n,
+        std::vector<unsigned> members, unsigned level)
+{
+  if (level >= depth_ || members.size() <= branching_)
+  {
+    nodes_[n].word = num_words_++;
+    return;
+  }
+
+  std::vector<unsigned> labels;
+  auto const centers = cluster(data, members, labels);
+  auto const k = centers.size() / dim_;
+
+  std::vector<std::vector<unsigned>> groups(k);
+  for (size_t i = 0; i < members.size(); ++i)
+  {
+    groups[labels[i]].push_back(members[i]);
+  }
+  members.clear();
+  members.shrink_to_fit();
+
+  // Children of a node are stored contiguously; empty clusters are dropped
+  auto const first = static_cast<unsigned>(nodes_.size());
+  for (size_t c = 0; c < k; ++c)
+  {
+    if (!groups[c].empty())
+    {
+      nodes_.push_back(node{0, 0, 0});
+      centers_.insert(centers_.end(), centers.begin() + c * dim_,
+                      centers.begin() + (c + 1) * dim_);
+    }
+  }
+  nodes_[n].first_child = first;
+  nodes_[n].num_children = static_cast<unsigned>(nodes_.size()) - first;
+
+  auto child = first;
+  for (auto& group : groups)
+  {
+    if (!group.empty())
+    {
+      build(data, child++, std::move(group), level + 1);
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<float>
+vocabulary_tree
+::cluster(float const* data, std::vector<unsigned> const& members,
+          std::vector<unsigned>& labels)
+{
+  auto const count = members.size();
+  auto const point = [&](size_t i){ return data + members[i] * dim_; };
+
+  // Seed the clusters using k-means++
+  auto const first = std::uniform_int_distribution<size_t>(0, count - 1)(rng_);
+  std::vector<float> centers(point(first), point(first) + dim_);
+  std::vector<float> nearest(count);
+  for (unsigned c = 1; c < branching_; ++c)
+  {
+    auto const* const last = centers.data() + (c - 1) * dim_;
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto const d = distance_sq(point(i), last, dim_);
+      nearest[i] = (c == 1 ? d : std::min(nearest[i], d));
+      total += nearest[i];
+    }
+    if (total <= 0.0)
+    {
+      // Fewer distinct descriptors than clusters
+      break;
+    }
+
+    auto target = std::uniform_real_distribution<double>(0.0, total)(rng_);
+    size_t next = 0;
+    for (; next + 1 < count; ++next)
+    {
+      target -= nearest[next];
+      if (target <= 0.0)
+      {
+        break;
+      }
+    }
+    centers.insert(centers.end(), point(next), point(next) + dim_);
+  }
+
+  // Lloyd iterations
+  auto const k = centers.size() / dim_;
+  labels.assign(count, 0);
+  std::vector<double> sums(k * dim_);
+  std::vector<size_t> sizes(k);
+  for (unsigned iter = 0; iter < iterations_; ++iter)
+  {
+    std::atomic<bool> changed(false);
+    parallel_for(count, [&](size_t begin, size_t end){
+      auto local_changed = false;
+      for (size_t i = begin; i < end; ++i)
+      {
+        unsigned best = 0;
+        auto best_dist = distance_sq(point(i), centers.data(), dim_);
+        for (unsigned c = 1; c < k; ++c)
+        {
+          auto const d = distance_sq(point(i), centers.data() + c * dim_, dim_);
+          if (d < best_dist)
+          {
+            best_dist = d;
+            best = c;
+          }
+        }
+        local_changed = local_changed || (labels[i] != best);
+        labels[i] = best;
+      }
+      if (local_changed)
+      {
+        changed = true;
+      }
+    });
+
+    if (iter > 0 && !changed)
+    {
+      break;
+    }
+
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(sizes.begin(), sizes.end(), size_t{0});
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto* const s = sums.data() + labels[i] * dim_;
+      auto const* const p = point(i);
+      for (size_t j = 0; j < dim_; ++j)
+      {
+        s[j] += p[j];
+      }
+      ++sizes[labels[i]];
+    }
+    for (size_t c = 0; c < k; ++c)
+    {
+      // An empty cluster keeps its previous center
+      if (sizes[c])
+      {
+        for (size_t j = 0; j < dim_; ++j)
+        {
+          centers[c * dim_ + j] =
+            static_cast<float>(sums[c * dim_ + j] / sizes[c]);
+        }
+      }
+    }
+  }
+
+  return centers;
+}
+
+
+// ----------------------------------------------------------------------------
+unsigned
+vocabulary_tree
+::quantize(float const* desc) const
+{
+  unsigned n = 0;
+  while (nodes_[n].num_children)
+  {
+    auto const first = nodes_[n].first_child;
+    auto const last = first + nodes_[n].num_children;
+    auto best = first;
+    auto best_dist = distance_sq(desc, centers_.data() + first * dim_, dim_);
+    for (auto c = first + 1; c < last; ++c)
+    {
+      auto const d = distance_sq(desc, centers_.data() + c * dim_, dim_);
+      if (d < best_dist)
+      {
+        best_dist = d;
+        best = c;
+      }
+    }
+    n = best;
+  }
+  return nodes_[n].word;
+}
+
+
+/// A sparse, L2 normalized bag-of-words vector
+typedef std::vector<std::pair<unsigned, float>> bow_vector;
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class close_loops_vocabulary_tree::priv
+{
+public:
+  /// Constructor
+  priv()
+    : branching_factor(10),
+      depth(5),
+      kmeans_iterations(10),
+      training_frames(20),
+      max_training_descriptors(200000),
+      num_candidates(5),
+      exclude_window(20),
+      match_req(25),
+      training_dim(0)
+  {
+  }
+
+  /// Drop the vocabulary and all indexed frames
+  void reset()
+  {
+    tree.clear();
+    idf.clear();
+    inverted.clear();
+    documents.clear();
+    training.clear();
+  }
+
+  /// Convert a descriptor set to a row-major array of floats
+  std::vector<float> extract(descriptor_set const& descriptors,
+                             size_t& dim) const;
+
+  /// Learn the vocabulary and index the frames accumulated so far
+  void train();
+
+  /// Compute the weighted bag-of-words vector for a frame's descriptors
+  bow_vector bag_of_words(std::vector<float> const& data) const;
+
+  /// Add a frame to the inverted file
+  void add(frame_id_t frame, bow_vector const& words);
+
+  /// Find the indexed frames most similar to a bag-of-words vector
+  std::vector<frame_id_t> query(bow_vector const& words,
+                                frame_id_t frame) const;
+
+  /// Match a frame to candidate frames and stitch the matched tracks
+  feature_track_set_sptr stitch(frame_id_t frame,
+                                feature_track_set_sptr input,
+                                std::vector<frame_id_t> const& candidates)
+                                const;
+
+  /// number of children of each vocabulary tree node
+  unsigned branching_factor;
+  /// number of levels of the vocabulary tree
+  unsigned depth;
+  /// maximum number of k-means iterations at each tree node
+  unsigned kmeans_iterations;
+  /// number of frames to accumulate before learning the vocabulary
+  unsigned training_frames;
+  /// maximum number of descriptors to learn the vocabulary from
+  unsigned max_training_descriptors;
+  /// number of retrieved frames on which to run feature matching
+  unsigned num_candidates;
+  /// number of most recent frames excluded from retrieval
+  unsigned exclude_window;
+  /// number of matches required to stitch a candidate frame
+  unsigned match_req;
+
+  /// the feature matcher used to verify candidate frames
+  vital::algo::match_features_sptr matcher;
+  /// logger handle
+  vital::logger_handle_t m_logger;
+
+  /// the visual vocabulary
+  vocabulary_tree tree;
+  /// inverse document frequency weight of each word
+  std::vector<float> idf;
+  /// (document, weight) pairs of each word
+  std::vector<std::vector<std::pair<unsigned, float>>> inverted;
+  /// frame number of each document
+  std::vector<frame_id_t> documents;
+  /// descriptors of frames seen before the vocabulary is learned
+  std::vector<std::pair<frame_id_t, std::vector<float>>> training;
+  /// dimension of the training descriptors
+  size_t training_dim;
+};
+
+
+// ----------------------------------------------------------------------------
+std::vector<float>
+close_loops_vocabulary_tree::priv
+::extract(descriptor_set const& descriptors, size_t& dim) const
+{
+  std::vector<float> data;
+  dim = 0;
+  for (auto const& desc : descriptors.descriptors())
+  {
+    if (!desc)
+    {
+      continue;
+    }
+    if (dim == 0)
+    {
+      dim = desc->size();
+      data.reserve(dim * descriptors.size());
+    }
+    if (desc->size() != dim)
+    {
+      continue;
+    }
+    for (auto const v : desc->as_double())
+    {
+      data.push_back(static_cast<float>(v));
+    }
+  }
+  return data;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+close_loops_vocabulary_tree::priv
+::train()
+{
+  auto const dim = this->training_dim;
+
+  // Sample the training descriptors uniformly over all accumulated frames
+  size_t total = 0;
+  for (auto const& t : this->training)
+  {
+    total += t.second.size() / dim;
+  }
+  auto const limit = std::max<size_t>(1, max_training_descriptors);
+  auto const stride = std::max<size_t>(1, (total + limit - 1) / limit);
+
+  std::vector<float> samples;
+  samples.reserve(((total + stride - 1) / stride) * dim);
+  size_t i = 0;
+  for (auto const& t : this->training)
+  {
+    for (auto p = t.second.begin(); p != t.second.end(); p += dim, ++i)
+    {
+      if (i % stride == 0)
+      {
+        samples.insert(samples.end(), p, p + dim);
+      }
+    }
+  }
+
+  auto const num_samples = samples.size() / dim;
+  this->tree.train(samples, dim, branching_factor, depth, kmeans_iterations);
+  samples.clear();
+  samples.shrink_to_fit();
+
+  LOG_INFO(m_logger, "Learned a vocabulary of " << this->tree.num_words()
+                     << " words from " << num_samples << " descriptors");
+
+  // Compute the word weights from the training frames
+  auto const num_words = this->tree.num_words();
+  std::vector<std::vector<unsigned>> words(this->training.size());
+  std::vector<unsigned> frequency(num_words, 0);
+  for (size_t f = 0; f < this->training.size(); ++f)
+  {
+    auto const& data = this->training[f].second;
+    auto& w = words[f];
+    w.resize(data.size() / dim);
+    for (size_t j = 0; j < w.size(); ++j)
+    {
+      w[j] = this->tree.quantize(data.data() + j * dim);
+    }
+    std::sort(w.begin(), w.end());
+    w.erase(std::unique(w.begin(), w.end()), w.end());
+    for (auto const word : w)
+    {
+      ++frequency[word];
+    }
+  }
+
+  this->idf.resize(num_words);
+  this->inverted.assign(num_words, {});
+  auto const n = static_cast<float>(this->training.size());
+  for (unsigned w = 0; w < num_words; ++w)
+  {
+    // A word may occur in no training frame (e.g. an empty k-means cluster);
+    // weight it as the rarest observed words, as if it occurred in one
+    this->idf[w] = std::log(n / static_cast<float>(std::max(1u, frequency[w])));
+  }
+
+  for (auto const& t : this->training)
+  {
+    this->add(t.first, this->bag_of_words(t.second));
+  }
+  this->training.clear();
+}
+
+
+// ----------------------------------------------------------------------------
+bow_vector
+close_loops_vocabulary_tree::priv
+::bag_of_words(std::vector<float> const& data) const
+{
+  auto const dim = this->tree.dimension();
+  std::vector<unsigned> words(data.size() / dim);
+  parallel_for(words.size(), [&](size_t begin, size_t end){
+    for (auto i = begin; i < end; ++i)
+    {
+      words[i] = this->tree.quantize(data.data() + i * dim);
+    }
+  });
+  std::sort(words.begin(), words.end());
+
+  // Weight the term frequencies and normalize
+  bow_vector result;
+  double norm = 0.0;
+  for (auto i = words.begin(); i != words.end(); )
+  {
+    auto const j = std::upper_bound(i, words.end(), *i);
+    auto const weight = static_cast<float>(j - i) * this->idf[*i];
+    if (weight > 0.0f)
+    {
+      result.emplace_back(*i, weight);
+      norm += weight * weight;
+    }
+    i = j;
+  }
+  if (norm > 0.0)
+  {
+    auto const scale = static_cast<float>(1.0 / std::sqrt(norm));
+    for (auto& w : result)
+    {
+      w.second *= scale;
+    }
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+close_loops_vocabulary_tree::priv
+::add(frame_id_t frame, bow_vector const& words)
+{
+  auto const document = static_cast<unsigned>(this->documents.size());
+  this->documents.push_back(frame);
+  for (auto const& w : words)
+  {
+    this->inverted[w.first].emplace_back(document, w.second);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<frame_id_t>
+close_loops_vocabulary_tree::priv
+::query(bow_vector const& words, frame_id_t frame) const
+{
+  // Accumulate cosine similarity over the words shared with each document
+  std::vector<float> scores(this->documents.size(), 0.0f);
+  for (auto const& w : words)
+  {
+    for (auto const& d : this->inverted[w.first])
+    {
+      scores[d.first] += w.second * d.second;
+    }
+  }
+
+  std::vector<std::pair<float, frame_id_t>> ranked;
+  for (size_t d = 0; d < scores.size(); ++d)
+  {
+    if (scores[d] > 0.0f &&
+        this->documents[d] + static_cast<frame_id_t>(exclude_window) < frame)
+    {
+      ranked.emplace_back(scores[d], this->documents[d]);
+    }
+  }
+
+  auto const k = std::min<size_t>(num_candidates, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end(),
+                    [](std::pair<float, frame_id_t> const& a,
+                       std::pair<float, frame_id_t> const& b){
+                      return a.first > b.first;
+                    });
+
+  std::vector<frame_id_t> result;
+  for (size_t i = 0; i < k; ++i)
+  {
+    result.push_back(ranked[i].second);
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+feature_track_set_sptr
+close_loops_vocabulary_tree::priv
+::stitch(frame_id_t frame, feature_track_set_sptr input,
+         std::vector<frame_id_t> const& candidates) const
+{
+  auto const current_tracks = input->active_tracks(frame);
+  auto const current_features = input->frame_features(frame);
+  auto const current_descriptors = input->frame_descriptors(frame);
+
+  std::set<track_sptr> merged;
+  for (auto const candidate : candidates)
+  {
+    auto const candidate_tracks = input->active_tracks(candidate);
+    auto const mset = this->matcher->match(
+      input->frame_features(candidate), input->frame_descriptors(candidate),
+      current_features, current_descriptors);
+    if (!mset || mset->size() < match_req)
+    {
+      continue;
+    }
+
+    unsigned num_linked = 0;
+    for (auto const& m : mset->matches())
+    {
+      auto const& t1 = candidate_tracks[m.first];
+      auto const& t2 = current_tracks[m.second];
+      if (t1 == t2 || merged.count(t2) || merged.count(t1))
+      {
+        continue;
+      }
+      if (t1->append(*t2))
+      {
+        merged.insert(t2);
+        ++num_linked;
+      }
+    }
+    LOG_INFO(m_logger, "Matched frame " << frame << " to frame "
+                       << candidate << ", stitched " << num_linked
+                       << " tracks");
+  }
+
+  if (merged.empty())
+  {
+    return input;
+  }
+
+  std::vector<track_sptr> tracks;
+  for (auto const& t : input->tracks())
+  {
+    if (!merged.count(t))
+    {
+      tracks.push_back(t);
+    }
+  }
+  return std::make_shared<feature_track_set>(tracks);
+}
+
+
+// ----------------------------------------------------------------------------
+close_loops_vocabulary_tree
+::close_loops_vocabulary_tree()
+  : d_(new priv)
+{
+  attach_logger( "close_loops_vocabulary_tree" );
+  d_->m_logger = this->logger();
+}
+
+
+// ----------------------------------------------------------------------------
+close_loops_vocabulary_tree
+::~close_loops_vocabulary_tree() VITAL_NOTHROW
+{
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+close_loops_vocabulary_tree
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  // Sub-algorithm implementation name + sub_config block
+  // - Feature Matcher algorithm
+  algo::match_features::get_nested_algo_configuration(
+    "feature_matcher", config, d_->matcher);
+
+  config->set_value("branching_factor", d_->branching_factor,
+                    "The number of children of each node of the vocabulary "
+                    "tree.");
+  config->set_value("depth", d_->depth,
+                    "The number of levels of the vocabulary tree.  The "
+                    "vocabulary has up to branching_factor^depth words.");
+  config->set_value("kmeans_iterations", d_->kmeans_iterations,
+                    "The maximum number of k-means iterations used to "
+                    "cluster the descriptors at each tree node.");
+  config->set_value("training_frames", d_->training_frames,
+                    "The number of frames to accumulate before the "
+                    "vocabulary is learned.  Loop closure starts after this "
+                    "many frames have been seen.");
+  config->set_value("max_training_descriptors",
+                    d_->max_training_descriptors,
+                    "The maximum number of descriptors used to learn the "
+                    "vocabulary.  The descriptors of the training frames are "
+                    "subsampled uniformly to this count.");
+  config->set_value("num_candidates", d_->num_candidates,
+                    "The number of most similar frames on which to run "
+                    "feature matching.");
+  config->set_value("exclude_window", d_->exclude_window,
+                    "The number of most recent frames which are never "
+                    "retrieved, since the tracker already matches them.");
+  config->set_value("match_req", d_->match_req,
+                    "The required number of features needed to be matched "
+                    "for a success.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+close_loops_vocabulary_tree
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  // Setting nested algorithm instances via setter methods instead of directly
+  // assigning to instance property.
+  algo::match_features::set_nested_algo_configuration(
+    "feature_matcher", config, d_->matcher);
+
+  d_->branching_factor = config->get_value<unsigned>("branching_factor");
+  d_->depth = config->get_value<unsigned>("depth");
+  d_->kmeans_iterations = config->get_value<unsigned>("kmeans_iterations");
+  d_->training_frames = config->get_value<unsigned>("training_frames");
+  d_->max_training_descriptors =
+    config->get_value<unsigned>("max_training_descriptors");
+  d_->num_candidates = config->get_value<unsigned>("num_candidates");
+  d_->exclude_window = config->get_value<unsigned>("exclude_window");
+  d_->match_req = config->get_value<unsigned>("match_req");
+
+  // A new configuration requires a new vocabulary
+  d_->reset();
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+close_loops_vocabulary_tree
+::check_configuration(config_block_sptr config) const
+{
+  return
+    algo::match_features::check_nested_algo_configuration(
+      "feature_matcher", config) &&
+    config->get_value<unsigned>("branching_factor") >= 2 &&
+    config->get_value<unsigned>("depth") >= 1 &&
+    config->get_value<unsigned>("training_frames") >= 1 &&
+    config->get_value<unsigned>("max_training_descriptors") >= 1 &&
+    config->get_value<unsigned>("num_candidates") >= 1;
+}
+
+
+// ----------------------------------------------------------------------------
+feature_track_set_sptr
+close_loops_vocabulary_tree
+::stitch( frame_id_t frame_number,
+          feature_track_set_sptr input,
+          image_container_sptr /*image*/,
+          image_container_sptr /*mask*/ ) const
+{
+  auto const descriptors = input->frame_descriptors(frame_number);
+  if (!descriptors || descriptors->size() == 0)
+  {
+    return input;
+  }
+
+  size_t dim = 0;
+  auto data = d_->extract(*descriptors, dim);
+  if (data.empty())
+  {
+    return input;
+  }
+
+  if (d_->tree.empty())
+  {
+    // Accumulate descriptors until there are enough to learn the vocabulary
+    if (d_->training.empty())
+    {
+      d_->training_dim = dim;
+    }
+    else if (dim != d_->training_dim)
+    {
+      LOG_WARN(d_->m_logger, "Descriptors of frame " << frame_number
+                             << " do not match the training dimension");
+      return input;
+    }
+    d_->training.emplace_back(frame_number, std::move(data));
+    if (d_->training.size() >= d_->training_frames)
+    {
+      d_->train();
+    }
+    return input;
+  }
+
+  if (dim != d_->tree.dimension())
+  {
+    LOG_WARN(d_->m_logger, "Descriptors of frame " << frame_number
+                           << " do not match the vocabulary dimension");
+    return input;
+  }
+
+  auto const words = d_->bag_of_words(data);
+  auto const candidates = d_->query(words, frame_number);
+  d_->add(frame_number, words);
+
+  if (candidates.empty())
+  {
+    return input;
+  }
+  return d_->stitch(frame_number, input, candidates);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,109 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::close_loops_vocabulary_tree
+ */
+
+#ifndef MAPTK_CLOSE_LOOPS_VOCABULARY_TREE_H_
+#define MAPTK_CLOSE_LOOPS_VOCABULARY_TREE_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/algo/algorithm.h>
+#include <vital/algo/close_loops.h>
+#include <vital/config/config_block.h>
+
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Loop closure using image retrieval from a vocabulary tree
+/**
+ * This class indexes every frame it sees in a hierarchical bag-of-words
+ * (vocabulary tree) built from the feature descriptors in the track set.
+ * Each new frame is scored against all previously indexed frames outside of
+ * a window of recent frames, and the nested feature matcher is run only on
+ * the top scoring candidates.  Tracks matched to a candidate frame are then
+ * stitched together.
+ *
+ * The vocabulary is learned incrementally: descriptors from the first few
+ * frames are accumulated and clustered by hierarchical k-means, after which
+ * those frames, and every following frame, are added to the index.
+ */
+class MAPTK_EXPORT close_loops_vocabulary_tree
+  : public vital::algorithm_impl<close_loops_vocabulary_tree,
+                                 vital::algo::close_loops>
+{
+public:
+  /// Default Constructor
+  close_loops_vocabulary_tree();
+
+  /// Destructor
+  virtual ~close_loops_vocabulary_tree() VITAL_NOTHROW;
+
+  /// Get this algorithm's \link vital::config_block configuration block \endlink
+  virtual vital::config_block_sptr get_configuration() const;
+  /// Set this algorithm's properties via a config block
+  virtual void set_configuration(vital::config_block_sptr config);
+  /// Check that the algorithm's currently configuration is valid
+  virtual bool check_configuration(vital::config_block_sptr config) const;
+
+  /// Perform loop closure operation.
+  /**
+   * \param frame_number the frame number of the current frame
+   * \param input the input feature track set to stitch
+   * \param image image data for the current frame
+   * \param mask Optional mask image where positive values indicate
+   *                  regions to consider in the input image.
+   * \returns an updated set of feature tracks after the stitching operation
+   */
+  virtual vital::feature_track_set_sptr
+  stitch( vital::frame_id_t frame_number,
+          vital::feature_track_set_sptr input,
+          vital::image_container_sptr image,
+          vital::image_container_sptr mask = vital::image_container_sptr()) const;
+
+private:
+  /// private implementation class
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_CLOSE_LOOPS_VOCABULARY_TREE_H_
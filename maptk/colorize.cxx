@@ -144,5 +144,47 @@ vital::landmark_map_sptr compute_landmark_colors(
 }
 
 
+/// Compute colors for landmarks from compact tracks
+vital::landmark_map_sptr compute_landmark_colors(
+  vital::landmark_map const& landmarks,
+  compact_feature_tracks const& tracks)
+{
+  auto colored_landmarks = landmarks.landmarks();
+
+  for (auto& lm : colored_landmarks)
+  {
+    auto const ti = tracks.find(static_cast<vital::track_id_t>(lm.first));
+    if (ti == tracks.size())
+    {
+      continue;
+    }
+
+    auto const span = tracks.track(ti);
+    if (span.size == 0)
+    {
+      continue;
+    }
+    int ra = 0, ga = 0, ba = 0; // accumulators
+    for (size_t k = 0; k < span.size; ++k)
+    {
+      ra += span.colors[k].r;
+      ga += span.colors[k].g;
+      ba += span.colors[k].b;
+    }
+
+    auto const k = static_cast<int>(span.size);
+    auto const r = static_cast<unsigned char>(ra / k);
+    auto const g = static_cast<unsigned char>(ga / k);
+    auto const b = static_cast<unsigned char>(ba / k);
+
+    auto colored = std::make_shared<kwiver::vital::landmark_d>(*lm.second);
+    colored->set_color({r, g, b});
+    lm.second = colored;
+  }
+
+  return std::make_shared<kwiver::vital::simple_landmark_map>(colored_landmarks);
+}
+
+
 } // end namespace maptk
 } // end namespace kwiver
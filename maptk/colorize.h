@@ -37,6 +37,7 @@
 #define MAPTK_COLORIZE_H_
 
 #include <maptk/maptk_export.h>
+#include <maptk/compact_feature_tracks.h>
 
 #include <vital/types/feature_set.h>
 #include <vital/types/image_container.h>
@@ -93,6 +94,20 @@ vital::landmark_map_sptr compute_landmark_colors(
   vital::landmark_map const& landmarks,
   vital::feature_track_set const& tracks);
 
+/// Compute colors for landmarks from compact tracks
+/**
+ * This function computes landmark colors by taking the average color of all
+ * associated feature points, reading them from a compact track store.
+ *
+ *  \param [in] landmarks a set of landmarks to be colored
+ *  \param [in] tracks feature tracks to be used for computing landmark colors
+ *  \return a set of colored landmarks
+ */
+MAPTK_EXPORT
+vital::landmark_map_sptr compute_landmark_colors(
+  vital::landmark_map const& landmarks,
+  compact_feature_tracks const& tracks);
+
 } // end namespace maptk
 } // end namespace kwiver
 
@@ -0,0 +1,636 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::compact_feature_tracks
+ */
+
+#include "compact_feature_tracks.h"
+
+#include <vital/types/feature.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+
+const uint32_t compact_feature_tracks::no_descriptor;
+
+
+// ----------------------------------------------------------------------------
+compact_feature_tracks
+::compact_feature_tracks()
+  : track_offsets_(1, 0),
+    first_frame_(0)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+compact_feature_tracks
+::compact_feature_tracks(feature_track_set const& tracks,
+                         bool keep_descriptors)
+  : track_offsets_(1, 0),
+    first_frame_(0)
+{
+  auto all_tracks = tracks.tracks();
+  std::sort(all_tracks.begin(), all_tracks.end(),
+            [](track_sptr const& a, track_sptr const& b)
+            { return a->id() < b->id(); });
+
+  // Size the arrays exactly before filling them
+  size_t count = 0;
+  for (auto const& t : all_tracks)
+  {
+    count += t->size();
+  }
+  track_ids_.reserve(all_tracks.size());
+  track_offsets_.reserve(all_tracks.size() + 1);
+  frames_.reserve(count);
+  positions_.reserve(2 * count);
+  attributes_.reserve(3 * count);
+  colors_.reserve(count);
+  descriptor_indices_.reserve(count);
+  obs_tracks_.reserve(count);
+
+  std::unordered_map<vital::descriptor const*, uint32_t> descriptor_map;
+  for (auto const& t : all_tracks)
+  {
+    this->add_track(t->id());
+    for (auto const& ts : *t)
+    {
+      auto const fts = std::dynamic_pointer_cast<feature_track_state>(ts);
+      if (!fts || !fts->feature)
+      {
+        continue;
+      }
+
+      auto index = no_descriptor;
+      if (keep_descriptors && fts->descriptor)
+      {
+        auto const di = descriptor_map.emplace(
+          fts->descriptor.get(), static_cast<uint32_t>(descriptors_.size()));
+        index = di.second ? this->add_descriptor(fts->descriptor)
+                          : di.first->second;
+      }
+      this->add_observation(ts->frame(), *fts->feature, index);
+    }
+  }
+
+  this->index_frames();
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_feature_tracks
+::add_track(track_id_t id)
+{
+  track_ids_.push_back(id);
+  track_offsets_.push_back(static_cast<uint32_t>(frames_.size()));
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_feature_tracks
+::add_observation(frame_id_t frame, vital::feature const& feature,
+                  uint32_t descriptor)
+{
+  auto const& loc = feature.loc();
+  frames_.push_back(frame);
+  positions_.push_back(static_cast<float>(loc[0]));
+  positions_.push_back(static_cast<float>(loc[1]));
+  attributes_.push_back(static_cast<float>(feature.magnitude()));
+  attributes_.push_back(static_cast<float>(feature.scale()));
+  attributes_.push_back(static_cast<float>(feature.angle()));
+  colors_.push_back(feature.color());
+  descriptor_indices_.push_back(descriptor);
+  obs_tracks_.push_back(static_cast<uint32_t>(track_ids_.size() - 1));
+  ++track_offsets_.back();
+}
+
+
+// ----------------------------------------------------------------------------
+uint32_t
+compact_feature_tracks
+::add_descriptor(descriptor_sptr const& descriptor)
+{
+  descriptors_.push_back(descriptor);
+  return static_cast<uint32_t>(descriptors_.size() - 1);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_feature_tracks
+::index_frames()
+{
+  first_frame_ = 0;
+  frame_offsets_.clear();
+  frame_obs_.clear();
+  if (frames_.empty())
+  {
+    return;
+  }
+
+  // Index the observations by frame with a counting sort
+  auto const range = std::minmax_element(frames_.begin(), frames_.end());
+  first_frame_ = *range.first;
+  frame_offsets_.assign(static_cast<size_t>(*range.second - first_frame_) + 2,
+                        0);
+  for (auto const f : frames_)
+  {
+    ++frame_offsets_[static_cast<size_t>(f - first_frame_) + 1];
+  }
+  for (size_t i = 1; i < frame_offsets_.size(); ++i)
+  {
+    frame_offsets_[i] += frame_offsets_[i - 1];
+  }
+
+  std::vector<uint32_t> next(frame_offsets_.begin(), frame_offsets_.end() - 1);
+  frame_obs_.resize(frames_.size());
+  for (uint32_t obs = 0; obs < frames_.size(); ++obs)
+  {
+    frame_obs_[next[static_cast<size_t>(frames_[obs] - first_frame_)]++] = obs;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+size_t
+compact_feature_tracks
+::memory_usage() const
+{
+  return track_ids_.capacity() * sizeof(track_id_t) +
+         track_offsets_.capacity() * sizeof(uint32_t) +
+         frames_.capacity() * sizeof(frame_id_t) +
+         positions_.capacity() * sizeof(float) +
+         attributes_.capacity() * sizeof(float) +
+         colors_.capacity() * sizeof(rgb_color) +
+         descriptor_indices_.capacity() * sizeof(uint32_t) +
+         obs_tracks_.capacity() * sizeof(uint32_t) +
+         frame_offsets_.capacity() * sizeof(uint32_t) +
+         frame_obs_.capacity() * sizeof(uint32_t) +
+         descriptors_.capacity() * sizeof(descriptor_sptr);
+}
+
+
+// ----------------------------------------------------------------------------
+compact_feature_tracks::track_span
+compact_feature_tracks
+::track(size_t i) const
+{
+  auto const begin = track_offsets_[i];
+  track_span span;
+  span.id = track_ids_[i];
+  span.size = track_offsets_[i + 1] - begin;
+  span.frames = frames_.data() + begin;
+  span.positions = positions_.data() + 2 * begin;
+  span.colors = colors_.data() + begin;
+  span.descriptors = descriptor_indices_.data() + begin;
+  return span;
+}
+
+
+// ----------------------------------------------------------------------------
+size_t
+compact_feature_tracks
+::find(track_id_t id) const
+{
+  auto const iter = std::lower_bound(track_ids_.begin(), track_ids_.end(), id);
+  if (iter == track_ids_.end() || *iter != id)
+  {
+    return track_ids_.size();
+  }
+  return static_cast<size_t>(iter - track_ids_.begin());
+}
+
+
+// ----------------------------------------------------------------------------
+compact_feature_tracks::observation_range
+compact_feature_tracks
+::frame_observations(frame_id_t frame) const
+{
+  if (frame < first_frame_ ||
+      static_cast<size_t>(frame - first_frame_) + 1 >= frame_offsets_.size())
+  {
+    return observation_range(nullptr, nullptr);
+  }
+
+  auto const index = static_cast<size_t>(frame - first_frame_);
+  auto const* const base = frame_obs_.data();
+  return observation_range(base + frame_offsets_[index],
+                           base + frame_offsets_[index + 1]);
+}
+
+
+// ----------------------------------------------------------------------------
+frame_id_t
+compact_feature_tracks
+::last_frame() const
+{
+  if (frame_offsets_.empty())
+  {
+    return first_frame_;
+  }
+  return first_frame_ + static_cast<frame_id_t>(frame_offsets_.size() - 2);
+}
+
+
+// ----------------------------------------------------------------------------
+track_sptr
+compact_feature_tracks
+::make_track(size_t i) const
+{
+  auto const begin = track_offsets_[i];
+  auto const end = track_offsets_[i + 1];
+
+  auto t = track::create();
+  t->set_id(track_ids_[i]);
+  for (auto obs = begin; obs < end; ++obs)
+  {
+    auto const* const attributes = attributes_.data() + 3 * obs;
+    auto const feat = std::make_shared<feature_d>();
+    feat->set_loc(this->position(obs));
+    feat->set_magnitude(attributes[0]);
+    feat->set_scale(attributes[1]);
+    feat->set_angle(attributes[2]);
+    feat->set_color(colors_[obs]);
+
+    auto const di = descriptor_indices_[obs];
+    t->append(std::make_shared<feature_track_state>(
+      frames_[obs], feat,
+      di == no_descriptor ? descriptor_sptr() : descriptors_[di]));
+  }
+  return t;
+}
+
+
+// ----------------------------------------------------------------------------
+compact_track_set_implementation
+::compact_track_set_implementation(
+  std::shared_ptr<compact_feature_tracks const> tracks)
+  : store_(std::move(tracks))
+{
+  if (!store_)
+  {
+    store_ = std::make_shared<compact_feature_tracks const>();
+  }
+  cache_.resize(store_->size());
+}
+
+
+// ----------------------------------------------------------------------------
+size_t
+compact_track_set_implementation
+::size() const
+{
+  return detached_ ? detached_->size() : store_->size();
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+compact_track_set_implementation
+::empty() const
+{
+  return this->size() == 0;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+compact_track_set_implementation
+::contains(track_sptr t) const
+{
+  if (detached_)
+  {
+    return detached_->contains(t);
+  }
+
+  auto const i = (t ? store_->find(t->id()) : store_->size());
+  if (i == store_->size())
+  {
+    return false;
+  }
+
+  // Only the object handed out for the track is part of the set
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_[i].lock() == t;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_track_set_implementation
+::set_tracks(std::vector<track_sptr> const& tracks)
+{
+  this->detach();
+  detached_->set_tracks(tracks);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_track_set_implementation
+::insert(track_sptr t)
+{
+  this->detach();
+  detached_->insert(t);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_track_set_implementation
+::notify_new_state(track_state_sptr ts)
+{
+  this->detach();
+  detached_->notify_new_state(ts);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_track_set_implementation
+::notify_removed_state(track_state_sptr ts)
+{
+  this->detach();
+  detached_->notify_removed_state(ts);
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+compact_track_set_implementation
+::remove(track_sptr t)
+{
+  this->detach();
+  return detached_->remove(t);
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<track_sptr>
+compact_track_set_implementation
+::tracks() const
+{
+  if (detached_)
+  {
+    return detached_->tracks();
+  }
+
+  std::vector<track_sptr> result;
+  result.reserve(store_->size());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < store_->size(); ++i)
+  {
+    result.push_back(this->cached_track(i));
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+std::set<frame_id_t>
+compact_track_set_implementation
+::all_frame_ids() const
+{
+  if (detached_)
+  {
+    return detached_->all_frame_ids();
+  }
+
+  std::set<frame_id_t> result;
+  if (store_->num_observations())
+  {
+    auto const last = store_->last_frame();
+    for (auto f = store_->first_frame(); f <= last; ++f)
+    {
+      auto const range = store_->frame_observations(f);
+      if (range.first != range.second)
+      {
+        result.insert(result.end(), f);
+      }
+    }
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+std::set<track_id_t>
+compact_track_set_implementation
+::all_track_ids() const
+{
+  if (detached_)
+  {
+    return detached_->all_track_ids();
+  }
+
+  auto const& ids = store_->track_ids();
+  return std::set<track_id_t>(ids.begin(), ids.end());
+}
+
+
+// ----------------------------------------------------------------------------
+frame_id_t
+compact_track_set_implementation
+::first_frame() const
+{
+  return detached_ ? detached_->first_frame() : store_->first_frame();
+}
+
+
+// ----------------------------------------------------------------------------
+frame_id_t
+compact_track_set_implementation
+::last_frame() const
+{
+  return detached_ ? detached_->last_frame() : store_->last_frame();
+}
+
+
+// ----------------------------------------------------------------------------
+track_sptr const
+compact_track_set_implementation
+::get_track(track_id_t tid) const
+{
+  if (detached_)
+  {
+    return detached_->get_track(tid);
+  }
+
+  auto const i = store_->find(tid);
+  if (i == store_->size())
+  {
+    return track_sptr();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return this->cached_track(i);
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<track_sptr>
+compact_track_set_implementation
+::active_tracks(frame_id_t offset) const
+{
+  if (detached_)
+  {
+    return detached_->active_tracks(offset);
+  }
+
+  auto const range = store_->frame_observations(this->frame_for_offset(offset));
+
+  std::vector<track_sptr> result;
+  result.reserve(static_cast<size_t>(range.second - range.first));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto obs = range.first; obs != range.second; ++obs)
+  {
+    result.push_back(this->cached_track(store_->observation_track(*obs)));
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<track_state_sptr>
+compact_track_set_implementation
+::frame_states(frame_id_t offset) const
+{
+  if (detached_)
+  {
+    return detached_->frame_states(offset);
+  }
+
+  auto const frame = this->frame_for_offset(offset);
+  auto const range = store_->frame_observations(frame);
+  auto const count = static_cast<size_t>(range.second - range.first);
+
+  std::vector<track_sptr> tracks;
+  std::vector<track_state_sptr> result;
+  tracks.reserve(count);
+  result.reserve(count);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto obs = range.first; obs != range.second; ++obs)
+  {
+    auto const t = this->cached_track(store_->observation_track(*obs));
+    auto const ts = t->find(frame);
+    if (ts != t->end())
+    {
+      result.push_back(*ts);
+      tracks.push_back(t);
+    }
+  }
+
+  // The states only refer weakly to their tracks; keep those alive
+  pinned_.swap(tracks);
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+frame_id_t
+compact_track_set_implementation
+::frame_for_offset(frame_id_t offset) const
+{
+  return offset >= 0 ? offset : store_->last_frame() + offset + 1;
+}
+
+
+// ----------------------------------------------------------------------------
+track_sptr
+compact_track_set_implementation
+::cached_track(size_t i) const
+{
+  auto t = cache_[i].lock();
+  if (!t)
+  {
+    t = store_->make_track(i);
+    cache_[i] = t;
+  }
+  return t;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+compact_track_set_implementation
+::detach()
+{
+  if (detached_)
+  {
+    return;
+  }
+
+  // Tracks still in use keep any changes made to them
+  auto const& all_tracks = this->tracks();
+  detached_.reset(new simple_track_set_implementation(all_tracks));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_.clear();
+  pinned_.clear();
+  store_.reset();
+}
+
+
+// ----------------------------------------------------------------------------
+feature_track_set_sptr
+make_compact_feature_track_set(feature_track_set const& tracks)
+{
+  return make_compact_feature_track_set(
+    std::make_shared<compact_feature_tracks const>(tracks));
+}
+
+
+// ----------------------------------------------------------------------------
+feature_track_set_sptr
+make_compact_feature_track_set(
+  std::shared_ptr<compact_feature_tracks const> tracks)
+{
+  track_set_implementation_uptr impl(
+    new compact_track_set_implementation(std::move(tracks)));
+  return std::make_shared<feature_track_set>(std::move(impl));
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,307 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::compact_feature_tracks
+ */
+
+#ifndef MAPTK_COMPACT_FEATURE_TRACKS_H_
+#define MAPTK_COMPACT_FEATURE_TRACKS_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/color.h>
+#include <vital/types/descriptor.h>
+#include <vital/types/feature.h>
+#include <vital/types/feature_track_set.h>
+#include <vital/types/track_set.h>
+#include <vital/types/vector.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// A compact store of feature tracks
+/**
+ * A vital::feature_track_set holds every observation as a separate heap
+ * allocated track state, with its own feature and descriptor objects.  This
+ * store instead keeps the frame ids and feature attributes of all
+ * observations in contiguous arrays, with the observations of each track in
+ * one span, and keeps each distinct descriptor only once.  It takes a small
+ * fraction of the memory and is much faster to iterate.
+ *
+ * Tracks are stored in order of increasing id.  Feature positions and
+ * attributes are stored in single precision.  A store is normally used
+ * through a feature track set created by make_compact_feature_track_set(),
+ * which creates vital tracks from it on demand.
+ */
+class MAPTK_EXPORT compact_feature_tracks
+{
+public:
+  /// Descriptor index of observations without a descriptor
+  static const uint32_t no_descriptor = std::numeric_limits<uint32_t>::max();
+
+  /// The observations of one track
+  struct track_span
+  {
+    /// the id of the track
+    vital::track_id_t id;
+    /// the number of observations
+    size_t size;
+    /// the frame of each observation, in increasing order
+    vital::frame_id_t const* frames;
+    /// the position of each observation, as interleaved x and y
+    float const* positions;
+    /// the color of each observation
+    vital::rgb_color const* colors;
+    /// the descriptor index of each observation
+    uint32_t const* descriptors;
+
+    /// Get the position of observation \p i
+    vital::vector_2d position(size_t i) const
+    {
+      return vital::vector_2d(positions[2 * i], positions[2 * i + 1]);
+    }
+  };
+
+  /// Range of indices of the observations on a frame
+  typedef std::pair<uint32_t const*, uint32_t const*> observation_range;
+
+  /// Construct an empty store
+  compact_feature_tracks();
+
+  /// Construct a store holding the feature tracks of \p tracks
+  /**
+   * Track states which are not feature track states, or which have no
+   * feature, are skipped.  If \p keep_descriptors is false, the descriptors
+   * are left out, so that they can be released with the track set.
+   */
+  explicit compact_feature_tracks(vital::feature_track_set const& tracks,
+                                  bool keep_descriptors = true);
+
+  /// Start a new track with id \p id
+  /**
+   * Tracks must be added in order of increasing id.  Observations added by
+   * add_observation() belong to the track added last.
+   */
+  void add_track(vital::track_id_t id);
+  /// Add an observation of \p feature on \p frame to the last added track
+  /**
+   * Observations of a track must be added in order of increasing frame.
+   * \p descriptor is an index returned by add_descriptor(), or
+   * no_descriptor.
+   */
+  void add_observation(vital::frame_id_t frame, vital::feature const& feature,
+                       uint32_t descriptor);
+  /// Add a descriptor and return its index
+  uint32_t add_descriptor(vital::descriptor_sptr const& descriptor);
+  /// Index the observations by frame once all tracks have been added
+  void index_frames();
+
+  /// The number of tracks
+  size_t size() const { return track_ids_.size(); }
+  /// The total number of observations
+  size_t num_observations() const { return frames_.size(); }
+  /// The number of distinct descriptors
+  size_t num_descriptors() const { return descriptors_.size(); }
+  /// The approximate number of bytes used by the store, excluding descriptors
+  size_t memory_usage() const;
+
+  /// Get the observations of the track at index \p i
+  track_span track(size_t i) const;
+  /// Get the id of the track at index \p i
+  vital::track_id_t track_id(size_t i) const { return track_ids_[i]; }
+  /// Get the ids of all tracks, in increasing order
+  std::vector<vital::track_id_t> const& track_ids() const
+  {
+    return track_ids_;
+  }
+  /// Get the index of the track with id \p id, or size() if there is none
+  size_t find(vital::track_id_t id) const;
+  /// Get the track with index \p i of the observation at index \p obs
+  size_t observation_track(uint32_t obs) const { return obs_tracks_[obs]; }
+
+  /// Get the indices of the observations on frame \p frame
+  observation_range frame_observations(vital::frame_id_t frame) const;
+  /// Get the first frame with an observation
+  vital::frame_id_t first_frame() const { return first_frame_; }
+  /// Get the last frame with an observation
+  vital::frame_id_t last_frame() const;
+  /// Get the frame of observation \p obs
+  vital::frame_id_t frame(uint32_t obs) const { return frames_[obs]; }
+  /// Get the position of observation \p obs
+  vital::vector_2d position(uint32_t obs) const
+  {
+    return vital::vector_2d(positions_[2 * obs], positions_[2 * obs + 1]);
+  }
+  /// Get the color of observation \p obs
+  vital::rgb_color const& color(uint32_t obs) const { return colors_[obs]; }
+  /// Get the descriptor with index \p i
+  vital::descriptor_sptr const& descriptor(uint32_t i) const
+  {
+    return descriptors_[i];
+  }
+
+  /// Create a vital track from the track at index \p i
+  vital::track_sptr make_track(size_t i) const;
+
+private:
+  // per track arrays; offsets has one more element than the number of tracks
+  std::vector<vital::track_id_t> track_ids_;
+  std::vector<uint32_t> track_offsets_;
+
+  // per observation arrays, grouped by track; attributes holds the
+  // magnitude, scale and angle of each observation
+  std::vector<vital::frame_id_t> frames_;
+  std::vector<float> positions_;
+  std::vector<float> attributes_;
+  std::vector<vital::rgb_color> colors_;
+  std::vector<uint32_t> descriptor_indices_;
+  std::vector<uint32_t> obs_tracks_;
+
+  // observation indices grouped by frame, starting from first_frame_
+  vital::frame_id_t first_frame_;
+  std::vector<uint32_t> frame_offsets_;
+  std::vector<uint32_t> frame_obs_;
+
+  // distinct descriptors
+  std::vector<vital::descriptor_sptr> descriptors_;
+};
+
+/// A track set implementation backed by a compact_feature_tracks store
+/**
+ * Vital tracks are created from the store when they are asked for, and are
+ * shared while they are in use, so the set returns the same object for a
+ * track as long as someone holds it.  frame_states() only creates the
+ * tracks observed on the requested frame.  Since track states do not own
+ * their track, the tracks of the latest frame_states() call are kept alive.
+ *
+ * The store itself is never changed; changes made to the features of
+ * returned track states are lost once their track is released.  Inserting,
+ * removing or changing tracks through the set first moves all tracks into a
+ * vital::simple_track_set_implementation, which then handles every call.
+ */
+class MAPTK_EXPORT compact_track_set_implementation
+  : public vital::track_set_implementation
+{
+public:
+  /// Construct a track set implementation backed by \p tracks
+  explicit compact_track_set_implementation(
+    std::shared_ptr<compact_feature_tracks const> tracks);
+
+  /// Destructor
+  virtual ~compact_track_set_implementation() = default;
+
+  /// Return the number of tracks in the set
+  virtual size_t size() const;
+  /// Return whether or not there are any tracks in the set
+  virtual bool empty() const;
+  /// Return true if the set contains \p t
+  virtual bool contains(vital::track_sptr t) const;
+
+  /// Replace the tracks of the set
+  virtual void set_tracks(std::vector<vital::track_sptr> const& tracks);
+  /// Insert a track into the set
+  virtual void insert(vital::track_sptr t);
+  /// Notify the set that a state was added to one of its tracks
+  virtual void notify_new_state(vital::track_state_sptr ts);
+  /// Notify the set that a state was removed from one of its tracks
+  virtual void notify_removed_state(vital::track_state_sptr ts);
+  /// Remove a track from the set and return true if it was found
+  virtual bool remove(vital::track_sptr t);
+
+  /// Return all tracks in the set
+  virtual std::vector<vital::track_sptr> tracks() const;
+  /// Return the set of all frame ids covered by the tracks
+  virtual std::set<vital::frame_id_t> all_frame_ids() const;
+  /// Return the set of all track ids
+  virtual std::set<vital::track_id_t> all_track_ids() const;
+  /// Return the first frame with an observation
+  virtual vital::frame_id_t first_frame() const;
+  /// Return the last frame with an observation
+  virtual vital::frame_id_t last_frame() const;
+  /// Return the track with id \p tid, or null if there is none
+  virtual vital::track_sptr const get_track(vital::track_id_t tid) const;
+  /// Return the tracks observed on a frame
+  virtual std::vector<vital::track_sptr>
+  active_tracks(vital::frame_id_t offset = -1) const;
+  /// Return the track states on a frame
+  virtual std::vector<vital::track_state_sptr>
+  frame_states(vital::frame_id_t offset = -1) const;
+
+private:
+  /// Convert a frame offset, which counts back from the end if negative
+  vital::frame_id_t frame_for_offset(vital::frame_id_t offset) const;
+  /// Get the track at index \p i, creating it if needed; mutex_ must be held
+  vital::track_sptr cached_track(size_t i) const;
+  /// Move all tracks into a simple implementation
+  void detach();
+
+  std::shared_ptr<compact_feature_tracks const> store_;
+
+  mutable std::mutex mutex_;
+  // tracks in use, by index, and the tracks of the latest frame_states()
+  mutable std::vector<std::weak_ptr<vital::track>> cache_;
+  mutable std::vector<vital::track_sptr> pinned_;
+
+  // the implementation holding the tracks once the set has been changed
+  std::unique_ptr<vital::track_set_implementation> detached_;
+};
+
+/// Create a feature track set stored compactly
+/**
+ * The feature tracks of \p tracks are copied into a compact_feature_tracks
+ * store; tracks and track states of the new set are created from the store
+ * when they are used.
+ */
+MAPTK_EXPORT
+vital::feature_track_set_sptr
+make_compact_feature_track_set(vital::feature_track_set const& tracks);
+
+/// Create a feature track set backed by the compact store \p tracks
+MAPTK_EXPORT
+vital::feature_track_set_sptr
+make_compact_feature_track_set(
+  std::shared_ptr<compact_feature_tracks const> tracks);
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_COMPACT_FEATURE_TRACKS_H_
@@ -0,0 +1,402 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::dense_camera_map
+ */
+
+#include "dense_camera_map.h"
+
+#include <vital/types/camera.h>
+
+#include <algorithm>
+#include <typeinfo>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+
+// ----------------------------------------------------------------------------
+dense_camera_map
+::dense_camera_map()
+  : first_frame_(0),
+    size_(0)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+dense_camera_map
+::dense_camera_map(map_camera_t const& cameras)
+  : first_frame_(0),
+    size_(0)
+{
+  if (!cameras.empty())
+  {
+    // Size the arrays for the whole range up front
+    this->slot(cameras.begin()->first);
+    this->slot(cameras.rbegin()->first);
+  }
+  for (auto const& c : cameras)
+  {
+    this->insert(c.first, c.second);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+dense_camera_map
+::dense_camera_map(dense_camera_map const& other)
+  : camera_map(other),
+    first_frame_(other.first_frame_),
+    size_(other.size_),
+    states_(other.states_),
+    centers_(other.centers_),
+    rotations_(other.rotations_),
+    intrinsics_indices_(other.intrinsics_indices_),
+    intrinsics_(other.intrinsics_),
+    intrinsics_uses_(other.intrinsics_uses_),
+    free_intrinsics_(other.free_intrinsics_),
+    intrinsics_lookup_(other.intrinsics_lookup_)
+{
+  this->clone_others(other);
+}
+
+
+// ----------------------------------------------------------------------------
+dense_camera_map&
+dense_camera_map
+::operator=(dense_camera_map const& other)
+{
+  if (this != &other)
+  {
+    first_frame_ = other.first_frame_;
+    size_ = other.size_;
+    states_ = other.states_;
+    centers_ = other.centers_;
+    rotations_ = other.rotations_;
+    intrinsics_indices_ = other.intrinsics_indices_;
+    intrinsics_ = other.intrinsics_;
+    intrinsics_uses_ = other.intrinsics_uses_;
+    free_intrinsics_ = other.free_intrinsics_;
+    intrinsics_lookup_ = other.intrinsics_lookup_;
+    this->clone_others(other);
+    cache_.clear();
+  }
+  return *this;
+}
+
+
+// ----------------------------------------------------------------------------
+camera_map::map_camera_t
+dense_camera_map
+::cameras() const
+{
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  map_camera_t result;
+  for (size_t i = 0; i < states_.size(); ++i)
+  {
+    if (states_[i] != absent)
+    {
+      auto const frame = first_frame_ + static_cast<frame_id_t>(i);
+      result.emplace_hint(result.end(), frame,
+                          states_[i] == valid_camera ? this->cached_camera(i)
+                                                     : camera_sptr());
+    }
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+dense_camera_map
+::contains(frame_id_t frame) const
+{
+  auto const i = this->find_slot(frame);
+  return i >= 0 && states_[i] != absent;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+dense_camera_map
+::has_camera(frame_id_t frame) const
+{
+  auto const i = this->find_slot(frame);
+  return i >= 0 && states_[i] == valid_camera;
+}
+
+
+// ----------------------------------------------------------------------------
+camera_sptr
+dense_camera_map
+::find(frame_id_t frame) const
+{
+  auto const i = this->find_slot(frame);
+  if (i < 0 || states_[i] != valid_camera)
+  {
+    return camera_sptr();
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  return this->cached_camera(static_cast<size_t>(i));
+}
+
+
+// ----------------------------------------------------------------------------
+vector_3d
+dense_camera_map
+::center(frame_id_t frame) const
+{
+  auto const* const c = centers_.data() + 3 * (frame - first_frame_);
+  return vector_3d(c[0], c[1], c[2]);
+}
+
+
+// ----------------------------------------------------------------------------
+rotation_d
+dense_camera_map
+::rotation(frame_id_t frame) const
+{
+  auto const* const q = rotations_.data() + 4 * (frame - first_frame_);
+  return rotation_d(Eigen::Quaterniond(q[3], q[0], q[1], q[2]));
+}
+
+
+// ----------------------------------------------------------------------------
+camera_intrinsics_sptr const&
+dense_camera_map
+::intrinsics(frame_id_t frame) const
+{
+  return intrinsics_[intrinsics_indices_[frame - first_frame_]];
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_camera_map
+::insert(frame_id_t frame, camera_sptr const& camera)
+{
+  auto const i = this->slot(frame);
+  if (states_[i] == absent)
+  {
+    ++size_;
+  }
+  else if (states_[i] == valid_camera)
+  {
+    this->release(i);
+  }
+  if (i < cache_.size())
+  {
+    cache_[i].reset();
+  }
+  if (!camera)
+  {
+    states_[i] = null_camera;
+    return;
+  }
+  states_[i] = valid_camera;
+
+  auto const& c = camera->center();
+  std::copy(c.data(), c.data() + 3, centers_.begin() + 3 * i);
+
+  auto const& q = camera->rotation().quaternion();
+  rotations_[4 * i + 0] = q.x();
+  rotations_[4 * i + 1] = q.y();
+  rotations_[4 * i + 2] = q.z();
+  rotations_[4 * i + 3] = q.w();
+
+  // Cameras often share intrinsics objects; keep each once
+  auto const& k = camera->intrinsics();
+  auto const ki = intrinsics_lookup_.find(k.get());
+  uint32_t index;
+  if (ki != intrinsics_lookup_.end())
+  {
+    index = ki->second;
+  }
+  else if (!free_intrinsics_.empty())
+  {
+    index = free_intrinsics_.back();
+    free_intrinsics_.pop_back();
+    intrinsics_[index] = k;
+    intrinsics_lookup_.emplace(k.get(), index);
+  }
+  else
+  {
+    index = static_cast<uint32_t>(intrinsics_.size());
+    intrinsics_.push_back(k);
+    intrinsics_uses_.push_back(0);
+    intrinsics_lookup_.emplace(k.get(), index);
+  }
+  ++intrinsics_uses_[index];
+  intrinsics_indices_[i] = index;
+
+  // Only simple cameras can be recreated from the arrays
+  if (typeid(*camera) != typeid(simple_camera))
+  {
+    others_[frame] = camera;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_camera_map
+::erase(frame_id_t frame)
+{
+  auto const i = this->find_slot(frame);
+  if (i >= 0 && states_[i] != absent)
+  {
+    if (states_[i] == valid_camera)
+    {
+      this->release(static_cast<size_t>(i));
+    }
+    states_[i] = absent;
+    --size_;
+    if (static_cast<size_t>(i) < cache_.size())
+    {
+      cache_[i].reset();
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+size_t
+dense_camera_map
+::slot(frame_id_t frame)
+{
+  if (states_.empty())
+  {
+    first_frame_ = frame;
+  }
+
+  // Grow at the front by shifting the existing slots back
+  if (frame < first_frame_)
+  {
+    auto const shift = static_cast<size_t>(first_frame_ - frame);
+    states_.insert(states_.begin(), shift, absent);
+    centers_.insert(centers_.begin(), 3 * shift, 0.0);
+    rotations_.insert(rotations_.begin(), 4 * shift, 0.0);
+    intrinsics_indices_.insert(intrinsics_indices_.begin(), shift, 0);
+    cache_.clear();
+    first_frame_ = frame;
+  }
+
+  auto const i = static_cast<size_t>(frame - first_frame_);
+  if (i >= states_.size())
+  {
+    states_.resize(i + 1, absent);
+    centers_.resize(3 * (i + 1), 0.0);
+    rotations_.resize(4 * (i + 1), 0.0);
+    intrinsics_indices_.resize(i + 1, 0);
+  }
+  return i;
+}
+
+
+// ----------------------------------------------------------------------------
+std::ptrdiff_t
+dense_camera_map
+::find_slot(frame_id_t frame) const
+{
+  if (frame < first_frame_ || frame >= this->end_frame())
+  {
+    return -1;
+  }
+  return static_cast<std::ptrdiff_t>(frame - first_frame_);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_camera_map
+::release(size_t i)
+{
+  auto const index = intrinsics_indices_[i];
+  if (--intrinsics_uses_[index] == 0)
+  {
+    intrinsics_lookup_.erase(intrinsics_[index].get());
+    intrinsics_[index].reset();
+    free_intrinsics_.push_back(index);
+  }
+
+  others_.erase(first_frame_ + static_cast<frame_id_t>(i));
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_camera_map
+::clone_others(dense_camera_map const& other)
+{
+  others_.clear();
+  for (auto const& c : other.others_)
+  {
+    others_.emplace(c.first, c.second->clone());
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+camera_sptr
+dense_camera_map
+::cached_camera(size_t i) const
+{
+  auto const frame = first_frame_ + static_cast<frame_id_t>(i);
+  auto const oi = others_.find(frame);
+  if (oi != others_.end())
+  {
+    return oi->second;
+  }
+
+  if (cache_.size() < states_.size())
+  {
+    cache_.resize(states_.size());
+  }
+
+  auto camera = cache_[i].lock();
+  if (!camera)
+  {
+    camera = std::make_shared<simple_camera>(this->center(frame),
+                                             this->rotation(frame),
+                                             this->intrinsics(frame));
+    cache_[i] = camera;
+  }
+  return camera;
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
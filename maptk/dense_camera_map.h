@@ -0,0 +1,167 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::dense_camera_map
+ */
+
+#ifndef MAPTK_DENSE_CAMERA_MAP_H_
+#define MAPTK_DENSE_CAMERA_MAP_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/camera_map.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// A camera map stored in arrays indexed by frame number
+/**
+ * The camera center and rotation of each frame in a contiguous range of
+ * frame numbers are stored inline in flat arrays, with an index into a table
+ * of the distinct intrinsics.  Looking up the camera of a frame is a constant
+ * time array access, iterating the poses is cache friendly, and copying the
+ * map copies a few flat arrays instead of cloning a camera object per frame.
+ * Intrinsics are released once no frame uses them.
+ *
+ * Cameras of type vital::simple_camera are only kept in the arrays; camera
+ * objects for them are created on demand by find() and cameras(), and are
+ * shared while they are in use, so repeated calls return the same object as
+ * long as someone holds it.  Cameras of any other type are also kept as
+ * they were inserted, and are returned unchanged.  Copies of the map clone
+ * those cameras, so a copy never aliases the cameras of the original.
+ *
+ * Like vital::simple_camera_map, a frame may be present with a null camera.
+ * Frames outside the current range may be inserted at any time; the arrays
+ * grow to cover the new range, so the map is best suited to (nearly)
+ * contiguous frame numbers.
+ */
+class MAPTK_EXPORT dense_camera_map : public vital::camera_map
+{
+public:
+  /// Construct an empty map
+  dense_camera_map();
+
+  /// Construct a map holding the cameras of \p cameras
+  explicit dense_camera_map(map_camera_t const& cameras);
+
+  /// Copy the stored cameras of \p other, but not its camera objects
+  dense_camera_map(dense_camera_map const& other);
+  /// Copy the stored cameras of \p other, but not its camera objects
+  dense_camera_map& operator=(dense_camera_map const& other);
+
+  /// Destructor
+  virtual ~dense_camera_map() = default;
+
+  /// Return the number of frames in the map, including null cameras
+  virtual size_t size() const { return size_; }
+
+  /// Return a map from frame number to camera object
+  virtual map_camera_t cameras() const;
+
+  /// The first frame of the stored range
+  vital::frame_id_t first_frame() const { return first_frame_; }
+  /// One past the last frame of the stored range
+  vital::frame_id_t end_frame() const
+  {
+    return first_frame_ + static_cast<vital::frame_id_t>(states_.size());
+  }
+
+  /// Test if \p frame is in the map, possibly with a null camera
+  bool contains(vital::frame_id_t frame) const;
+  /// Test if \p frame has a (non-null) camera
+  bool has_camera(vital::frame_id_t frame) const;
+
+  /// Get the camera of \p frame, or return null if there is none
+  vital::camera_sptr find(vital::frame_id_t frame) const;
+  /// Get the camera center of \p frame, which must have a camera
+  vital::vector_3d center(vital::frame_id_t frame) const;
+  /// Get the camera rotation of \p frame, which must have a camera
+  vital::rotation_d rotation(vital::frame_id_t frame) const;
+  /// Get the camera intrinsics of \p frame, which must have a camera
+  vital::camera_intrinsics_sptr const& intrinsics(vital::frame_id_t frame) const;
+
+  /// Set the camera of \p frame, which may be null
+  void insert(vital::frame_id_t frame, vital::camera_sptr const& camera);
+  /// Remove \p frame from the map
+  void erase(vital::frame_id_t frame);
+
+private:
+  enum slot_state : uint8_t { absent, null_camera, valid_camera };
+
+  /// Get the slot of \p frame, growing the arrays to cover it
+  size_t slot(vital::frame_id_t frame);
+  /// Get the slot of \p frame, or -1 if it is out of range
+  std::ptrdiff_t find_slot(vital::frame_id_t frame) const;
+  /// Release the intrinsics and camera object used by valid slot \p i
+  void release(size_t i);
+  /// Copy the cameras of other types than simple_camera from \p other
+  void clone_others(dense_camera_map const& other);
+  /// Get the camera object of valid slot \p i; cache_mutex_ must be held
+  vital::camera_sptr cached_camera(size_t i) const;
+
+  vital::frame_id_t first_frame_;
+  size_t size_;
+
+  std::vector<uint8_t> states_;
+  // camera centers (x, y, z) and rotation quaternions (x, y, z, w)
+  std::vector<double> centers_;
+  std::vector<double> rotations_;
+  // index of the intrinsics of each frame, the distinct intrinsics and the
+  // number of frames using each; unused entries are null until reused
+  std::vector<uint32_t> intrinsics_indices_;
+  std::vector<vital::camera_intrinsics_sptr> intrinsics_;
+  std::vector<uint32_t> intrinsics_uses_;
+  std::vector<uint32_t> free_intrinsics_;
+  std::unordered_map<vital::camera_intrinsics const*, uint32_t>
+    intrinsics_lookup_;
+
+  // cameras of other types than simple_camera, as inserted, by frame
+  std::unordered_map<vital::frame_id_t, vital::camera_sptr> others_;
+
+  // camera objects handed out by find() and cameras() and still in use
+  mutable std::mutex cache_mutex_;
+  mutable std::vector<std::weak_ptr<vital::camera>> cache_;
+};
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_DENSE_CAMERA_MAP_H_
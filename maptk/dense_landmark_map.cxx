@@ -0,0 +1,231 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::dense_landmark_map
+ */
+
+#include "dense_landmark_map.h"
+
+#include <algorithm>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+
+// ----------------------------------------------------------------------------
+dense_landmark_map
+::dense_landmark_map()
+  : first_id_(0),
+    size_(0)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+dense_landmark_map
+::dense_landmark_map(map_landmark_t const& landmarks)
+  : first_id_(0),
+    size_(0)
+{
+  if (!landmarks.empty())
+  {
+    // Size the arrays for the whole range up front
+    this->slot(landmarks.begin()->first);
+    this->slot(landmarks.rbegin()->first);
+  }
+  for (auto const& lm : landmarks)
+  {
+    this->insert(lm.first, lm.second);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+landmark_map::map_landmark_t
+dense_landmark_map
+::landmarks() const
+{
+  map_landmark_t result;
+  for (size_t i = 0; i < present_.size(); ++i)
+  {
+    if (present_[i])
+    {
+      auto const id = first_id_ + static_cast<landmark_id_t>(i);
+      result.emplace_hint(result.end(), id, this->find(id));
+    }
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+dense_landmark_map
+::contains(landmark_id_t id) const
+{
+  auto const i = this->find_slot(id);
+  return i >= 0 && present_[i];
+}
+
+
+// ----------------------------------------------------------------------------
+landmark_sptr
+dense_landmark_map
+::find(landmark_id_t id) const
+{
+  auto const i = this->find_slot(id);
+  if (i < 0 || !present_[i])
+  {
+    return landmark_sptr();
+  }
+
+  auto lm = std::make_shared<landmark_d>(this->location(id), scales_[i]);
+  lm->set_color(colors_[i]);
+  lm->set_observations(observations_[i]);
+  return lm;
+}
+
+
+// ----------------------------------------------------------------------------
+vector_3d
+dense_landmark_map
+::location(landmark_id_t id) const
+{
+  auto const* const p = locations_.data() + 3 * (id - first_id_);
+  return vector_3d(p[0], p[1], p[2]);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_landmark_map
+::insert(landmark_id_t id, landmark_sptr const& landmark)
+{
+  if (!landmark)
+  {
+    this->erase(id);
+    return;
+  }
+
+  this->set_location(id, landmark->loc());
+
+  auto const i = static_cast<size_t>(id - first_id_);
+  scales_[i] = landmark->scale();
+  colors_[i] = landmark->color();
+  observations_[i] = static_cast<uint32_t>(landmark->observations());
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_landmark_map
+::set_location(landmark_id_t id, vector_3d const& loc)
+{
+  auto const i = this->slot(id);
+  if (!present_[i])
+  {
+    present_[i] = 1;
+    scales_[i] = 1.0;
+    colors_[i] = rgb_color();
+    observations_[i] = 0;
+    ++size_;
+  }
+  std::copy(loc.data(), loc.data() + 3, locations_.begin() + 3 * i);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+dense_landmark_map
+::erase(landmark_id_t id)
+{
+  auto const i = this->find_slot(id);
+  if (i >= 0 && present_[i])
+  {
+    present_[i] = 0;
+    --size_;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+size_t
+dense_landmark_map
+::slot(landmark_id_t id)
+{
+  if (present_.empty())
+  {
+    first_id_ = id;
+  }
+
+  // Grow at the front by shifting the existing slots back
+  if (id < first_id_)
+  {
+    auto const shift = static_cast<size_t>(first_id_ - id);
+    present_.insert(present_.begin(), shift, 0);
+    locations_.insert(locations_.begin(), 3 * shift, 0.0);
+    scales_.insert(scales_.begin(), shift, 1.0);
+    colors_.insert(colors_.begin(), shift, rgb_color());
+    observations_.insert(observations_.begin(), shift, 0);
+    first_id_ = id;
+  }
+
+  auto const i = static_cast<size_t>(id - first_id_);
+  if (i >= present_.size())
+  {
+    present_.resize(i + 1, 0);
+    locations_.resize(3 * (i + 1), 0.0);
+    scales_.resize(i + 1, 1.0);
+    colors_.resize(i + 1, rgb_color());
+    observations_.resize(i + 1, 0);
+  }
+  return i;
+}
+
+
+// ----------------------------------------------------------------------------
+std::ptrdiff_t
+dense_landmark_map
+::find_slot(landmark_id_t id) const
+{
+  if (id < first_id_ || id >= this->end_id())
+  {
+    return -1;
+  }
+  return static_cast<std::ptrdiff_t>(id - first_id_);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
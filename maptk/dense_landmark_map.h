@@ -0,0 +1,131 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::dense_landmark_map
+ */
+
+#ifndef MAPTK_DENSE_LANDMARK_MAP_H_
+#define MAPTK_DENSE_LANDMARK_MAP_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/landmark_map.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// A landmark map stored in arrays indexed by landmark id
+/**
+ * The location, scale, color and observation count of each landmark in a
+ * contiguous range of ids are stored inline in flat arrays.  Looking up a
+ * landmark is a constant time array access, iterating the locations is cache
+ * friendly, and copying the map copies a few flat arrays instead of cloning
+ * a landmark object per id.
+ *
+ * Landmark objects are created on demand by find() and landmarks().  Landmark
+ * normals and covariances are not kept.  Ids outside the current range may
+ * be inserted at any time; the arrays grow to cover the new range, so the
+ * map is best suited to (nearly) contiguous ids.
+ */
+class MAPTK_EXPORT dense_landmark_map : public vital::landmark_map
+{
+public:
+  /// Construct an empty map
+  dense_landmark_map();
+
+  /// Construct a map holding the landmarks of \p landmarks
+  explicit dense_landmark_map(map_landmark_t const& landmarks);
+
+  /// Destructor
+  virtual ~dense_landmark_map() = default;
+
+  /// Return the number of landmarks in the map
+  virtual size_t size() const { return size_; }
+
+  /// Return a map from id to a new landmark object
+  virtual map_landmark_t landmarks() const;
+
+  /// The first id of the stored range
+  vital::landmark_id_t first_id() const { return first_id_; }
+  /// One past the last id of the stored range
+  vital::landmark_id_t end_id() const
+  {
+    return first_id_ + static_cast<vital::landmark_id_t>(present_.size());
+  }
+
+  /// Test if landmark \p id is in the map
+  bool contains(vital::landmark_id_t id) const;
+
+  /// Create the landmark with \p id, or return null if there is none
+  vital::landmark_sptr find(vital::landmark_id_t id) const;
+  /// Get the location of landmark \p id, which must be in the map
+  vital::vector_3d location(vital::landmark_id_t id) const;
+  /// Get the color of landmark \p id, which must be in the map
+  vital::rgb_color const& color(vital::landmark_id_t id) const
+  {
+    return colors_[static_cast<size_t>(id - first_id_)];
+  }
+
+  /// Set landmark \p id; a null landmark removes it
+  void insert(vital::landmark_id_t id, vital::landmark_sptr const& landmark);
+  /// Set the location of landmark \p id, adding it if needed
+  void set_location(vital::landmark_id_t id, vital::vector_3d const& loc);
+  /// Remove landmark \p id from the map
+  void erase(vital::landmark_id_t id);
+
+private:
+  /// Get the slot of \p id, growing the arrays to cover it
+  size_t slot(vital::landmark_id_t id);
+  /// Get the slot of \p id, or -1 if it is out of range
+  std::ptrdiff_t find_slot(vital::landmark_id_t id) const;
+
+  vital::landmark_id_t first_id_;
+  size_t size_;
+
+  std::vector<uint8_t> present_;
+  // landmark locations (x, y, z)
+  std::vector<double> locations_;
+  std::vector<double> scales_;
+  std::vector<vital::rgb_color> colors_;
+  std::vector<uint32_t> observations_;
+};
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_DENSE_LANDMARK_MAP_H_
@@ -0,0 +1,261 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of the descriptor distance kernels
+ */
+
+#include "descriptor_distance.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAPTK_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Squared Euclidean distance; \p n is a multiple of 8
+float
+l2_scalar(float const* a, float const* b, size_t n)
+{
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; ++i)
+  {
+    float const d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+
+/// Hamming distance between bit strings of \p n 64-bit words
+unsigned
+hamming_scalar(uint64_t const* a, uint64_t const* b, size_t n)
+{
+  unsigned sum = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto x = a[i] ^ b[i];
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    sum += static_cast<unsigned>((x * 0x0101010101010101ull) >> 56);
+  }
+  return sum;
+}
+
+
+#ifdef MAPTK_X86_KERNELS
+/// Squared Euclidean distance using AVX2; \p n is a multiple of 8
+__attribute__((target("avx2,fma")))
+float
+l2_avx2(float const* a, float const* b, size_t n)
+{
+  __m256 sum = _mm256_setzero_ps();
+  for (size_t i = 0; i < n; i += 8)
+  {
+    __m256 const d =
+      _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    sum = _mm256_fmadd_ps(d, d, sum);
+  }
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(sum),
+                        _mm256_extractf128_ps(sum, 1));
+  s = _mm_hadd_ps(s, s);
+  s = _mm_hadd_ps(s, s);
+  return _mm_cvtss_f32(s);
+}
+
+
+/// Hamming distance using the POPCNT instruction
+__attribute__((target("popcnt")))
+unsigned
+hamming_popcnt(uint64_t const* a, uint64_t const* b, size_t n)
+{
+  unsigned sum = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    sum += static_cast<unsigned>(__builtin_popcountll(a[i] ^ b[i]));
+  }
+  return sum;
+}
+#endif
+
+
+/// Choose the fastest Euclidean distance kernel supported by the CPU
+l2_kernel_t
+select_l2_kernel()
+{
+#ifdef MAPTK_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+  {
+    return &l2_avx2;
+  }
+#endif
+  return &l2_scalar;
+}
+
+
+/// Choose the fastest Hamming distance kernel supported by the CPU
+hamming_kernel_t
+select_hamming_kernel()
+{
+#ifdef MAPTK_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("popcnt"))
+  {
+    return &hamming_popcnt;
+  }
+#endif
+  return &hamming_scalar;
+}
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------------------
+l2_kernel_t
+l2_kernel()
+{
+  static l2_kernel_t const kernel = select_l2_kernel();
+  return kernel;
+}
+
+
+// ----------------------------------------------------------------------------
+hamming_kernel_t
+hamming_kernel()
+{
+  static hamming_kernel_t const kernel = select_hamming_kernel();
+  return kernel;
+}
+
+
+// ----------------------------------------------------------------------------
+descriptor_sptr
+first_descriptor(descriptor_set const& descriptors)
+{
+  for (auto const& d : descriptors.descriptors())
+  {
+    if (d)
+    {
+      return d;
+    }
+  }
+  return nullptr;
+}
+
+
+// ----------------------------------------------------------------------------
+packed_descriptors<float>
+pack_float(descriptor_set const& descriptors, size_t dim)
+{
+  auto const& in = descriptors.descriptors();
+
+  packed_descriptors<float> result;
+  for (size_t i = 0; i < in.size(); ++i)
+  {
+    if (in[i] && in[i]->size() == dim)
+    {
+      result.index.push_back(static_cast<unsigned>(i));
+    }
+  }
+  result.count = result.index.size();
+  result.stride = (dim + 7) & ~size_t{7};
+  result.data.assign(result.count * result.stride, 0.0f);
+
+  for (size_t r = 0; r < result.count; ++r)
+  {
+    auto const& d = in[result.index[r]];
+    auto* const row = result.data.data() + r * result.stride;
+    auto const fd = dynamic_cast<descriptor_array_of<float> const*>(d.get());
+    if (fd)
+    {
+      std::memcpy(row, fd->raw_data(), dim * sizeof(float));
+    }
+    else
+    {
+      auto const values = d->as_double();
+      std::copy(values.begin(), values.end(), row);
+    }
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+packed_descriptors<uint64_t>
+pack_binary(descriptor_set const& descriptors, size_t bytes)
+{
+  auto const& in = descriptors.descriptors();
+
+  std::vector<descriptor_array_of<byte> const*> rows;
+  packed_descriptors<uint64_t> result;
+  for (size_t i = 0; i < in.size(); ++i)
+  {
+    auto const bd =
+      dynamic_cast<descriptor_array_of<byte> const*>(in[i].get());
+    if (bd && bd->size() == bytes)
+    {
+      rows.push_back(bd);
+      result.index.push_back(static_cast<unsigned>(i));
+    }
+  }
+  result.count = result.index.size();
+  result.stride = (bytes + 7) / 8;
+  result.data.assign(result.count * result.stride, 0);
+
+  for (size_t r = 0; r < result.count; ++r)
+  {
+    std::memcpy(result.data.data() + r * result.stride,
+                rows[r]->raw_data(), bytes);
+  }
+  return result;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+is_binary(descriptor const& descriptor)
+{
+  return dynamic_cast<descriptor_array_of<byte> const*>(&descriptor) != nullptr;
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
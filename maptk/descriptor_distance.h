@@ -0,0 +1,146 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Descriptor distance kernels shared by the MAP-Tk matchers
+ */
+
+#ifndef MAPTK_DESCRIPTOR_DISTANCE_H_
+#define MAPTK_DESCRIPTOR_DISTANCE_H_
+
+#include <vital/types/descriptor.h>
+#include <vital/types/descriptor_set.h>
+
+#include <cstdint>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+typedef float (*l2_kernel_t)(float const*, float const*, size_t);
+typedef unsigned (*hamming_kernel_t)(uint64_t const*, uint64_t const*, size_t);
+
+/// Get the fastest squared Euclidean distance kernel supported by the CPU
+/**
+ * The kernel requires the length to be a multiple of 8.
+ */
+l2_kernel_t l2_kernel();
+
+/// Get the fastest Hamming distance kernel supported by the CPU
+hamming_kernel_t hamming_kernel();
+
+
+/// Euclidean distance between floating point descriptors
+struct l2_space
+{
+  typedef float element_t;
+
+  explicit l2_space(size_t stride) : kernel(l2_kernel()), stride(stride) {}
+
+  float operator()(float const* a, float const* b) const
+  {
+    return kernel(a, b, stride);
+  }
+
+  /// Distances are squared, so the ratio must be too
+  static float ratio_threshold(float ratio) { return ratio * ratio; }
+
+  l2_kernel_t kernel;
+  size_t stride;
+};
+
+
+/// Hamming distance between binary descriptors
+struct hamming_space
+{
+  typedef uint64_t element_t;
+
+  explicit hamming_space(size_t stride)
+    : kernel(hamming_kernel()), stride(stride) {}
+
+  float operator()(uint64_t const* a, uint64_t const* b) const
+  {
+    return static_cast<float>(kernel(a, b, stride));
+  }
+
+  static float ratio_threshold(float ratio) { return ratio; }
+
+  hamming_kernel_t kernel;
+  size_t stride;
+};
+
+
+/// Descriptors packed into fixed size, zero padded rows
+/**
+ * Only usable descriptors are packed; \c index maps each row back to the
+ * position of its descriptor (and feature) in the original set.
+ */
+template <typename T>
+struct packed_descriptors
+{
+  T const* operator[](size_t i) const { return data.data() + i * stride; }
+
+  std::vector<T> data;
+  std::vector<unsigned> index;
+  size_t stride;
+  size_t count;
+};
+
+
+/// Find the first non-null descriptor of a set
+vital::descriptor_sptr
+first_descriptor(vital::descriptor_set const& descriptors);
+
+/// Test if a descriptor is binary (made of bytes)
+bool is_binary(vital::descriptor const& descriptor);
+
+/// Pack floating point descriptors, padding rows to a multiple of 8
+/**
+ * Null descriptors, and descriptors not of size \p dim, are skipped.
+ */
+packed_descriptors<float>
+pack_float(vital::descriptor_set const& descriptors, size_t dim);
+
+/// Pack byte descriptors into 64-bit words
+/**
+ * Null descriptors, and descriptors not of size \p bytes, are skipped.
+ */
+packed_descriptors<uint64_t>
+pack_binary(vital::descriptor_set const& descriptors, size_t bytes);
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_DESCRIPTOR_DISTANCE_H_
@@ -0,0 +1,909 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of the on-disk cache of decoded video frames
+ */
+
+#include "frame_cache.h"
+
+#include <vital/logger/logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+char const cache_magic[8] = { 'M', 'A', 'P', 'T', 'K', 'F', 'C', '\0' };
+uint32_t const cache_version = 1;
+
+/// Frames are aligned to this many bytes in the file
+uint64_t const frame_alignment = 64;
+
+/// The header at the start of the cache file
+struct file_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t index_offset;
+  uint64_t index_size;
+  uint64_t entry_count;
+  uint64_t padding[3];
+};
+
+/// The index record of one frame, followed by the key padded to 8 bytes
+struct entry_record
+{
+  uint64_t data_offset;
+  uint64_t data_size;
+  int64_t stamp;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t pixel_bytes;
+  uint32_t pixel_type;
+  uint32_t key_size;
+};
+
+static_assert(sizeof(file_header) == 64, "unexpected cache header size");
+static_assert(sizeof(entry_record) == 48, "unexpected cache record size");
+
+// ----------------------------------------------------------------------------
+uint64_t
+padded_size(uint64_t size, uint64_t alignment)
+{
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// ----------------------------------------------------------------------------
+bool
+seek_file(FILE* file, uint64_t offset)
+{
+#ifdef _WIN32
+  return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+file_header
+make_header(uint64_t index_offset, uint64_t index_size, uint64_t entry_count)
+{
+  file_header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+  header.version = cache_version;
+  header.index_offset = index_offset;
+  header.index_size = index_size;
+  header.entry_count = entry_count;
+  return header;
+}
+
+// ----------------------------------------------------------------------------
+bool
+replace_file(std::string const& from, std::string const& to)
+{
+#ifdef _WIN32
+  return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+/// Open the file at \p path for update, creating it if it does not exist,
+/// and lock it against other processes until it is closed
+/**
+ * \param busy set to true if the file is locked by another process
+ * \returns the open file, or null if it can not be opened or locked
+ */
+FILE*
+open_locked(std::string const& path, bool& busy)
+{
+  busy = false;
+#ifdef _WIN32
+  // The file can not be replaced while it is open elsewhere.  The lock is on
+  // a byte far past the end of any cache, so it does not block reading.
+  auto const handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                  OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE)
+  {
+    busy = (GetLastError() == ERROR_SHARING_VIOLATION);
+    return nullptr;
+  }
+  OVERLAPPED overlapped = {};
+  overlapped.Offset = 0xfffffffe;
+  overlapped.OffsetHigh = 0xffffffff;
+  if (!LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY,
+                  0, 1, 0, &overlapped))
+  {
+    busy = (GetLastError() == ERROR_LOCK_VIOLATION);
+    CloseHandle(handle);
+    return nullptr;
+  }
+  auto const fd = _open_osfhandle(reinterpret_cast<intptr_t>(handle), 0);
+  if (fd < 0)
+  {
+    CloseHandle(handle);
+    return nullptr;
+  }
+  auto* const file = _fdopen(fd, "r+b");
+  if (!file)
+  {
+    _close(fd);
+  }
+  return file;
+#else
+  // Another process may replace the file (when compacting it) between it
+  // being opened here and locked, in which case the new file is opened
+  for (int attempt = 0; attempt < 3; ++attempt)
+  {
+    auto const fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+    {
+      return nullptr;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+      busy = (errno == EWOULDBLOCK);
+      ::close(fd);
+      return nullptr;
+    }
+
+    struct stat opened, current;
+    if (fstat(fd, &opened) == 0 && stat(path.c_str(), &current) == 0 &&
+        opened.st_dev == current.st_dev && opened.st_ino == current.st_ino)
+    {
+      auto* const file = fdopen(fd, "r+b");
+      if (!file)
+      {
+        ::close(fd);
+      }
+      return file;
+    }
+    ::close(fd);
+  }
+  busy = true;
+  return nullptr;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+bool
+truncate_file(FILE* file)
+{
+  if (fflush(file) != 0)
+  {
+    return false;
+  }
+#ifdef _WIN32
+  return _chsize_s(_fileno(file), 0) == 0 && seek_file(file, 0);
+#else
+  return ftruncate(fileno(file), 0) == 0 && seek_file(file, 0);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+uint64_t
+file_size(FILE* file)
+{
+#ifdef _WIN32
+  _fseeki64(file, 0, SEEK_END);
+  return static_cast<uint64_t>(_ftelli64(file));
+#else
+  fseeko(file, 0, SEEK_END);
+  return static_cast<uint64_t>(ftello(file));
+#endif
+}
+
+
+// ----------------------------------------------------------------------------
+/// A copy-on-write memory mapping of the start of a file
+class mapped_region
+{
+public:
+  /// Map the first \p size bytes of the file at \p path
+  static std::shared_ptr<mapped_region>
+  map(std::string const& path, uint64_t size)
+  {
+    std::shared_ptr<mapped_region> region(new mapped_region);
+#ifdef _WIN32
+    region->file_ = CreateFileA(path.c_str(), GENERIC_READ,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (region->file_ == INVALID_HANDLE_VALUE)
+    {
+      return nullptr;
+    }
+    region->mapping_ = CreateFileMappingA(region->file_, NULL, PAGE_WRITECOPY,
+                                          0, 0, NULL);
+    if (!region->mapping_)
+    {
+      return nullptr;
+    }
+    region->data_ = MapViewOfFile(region->mapping_, FILE_MAP_COPY, 0, 0,
+                                  static_cast<SIZE_T>(size));
+    if (!region->data_)
+    {
+      return nullptr;
+    }
+#else
+    auto const fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return nullptr;
+    }
+    auto const data = mmap(nullptr, static_cast<size_t>(size),
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+      return nullptr;
+    }
+    region->data_ = data;
+#endif
+    region->size_ = size;
+    return region;
+  }
+
+  ~mapped_region()
+  {
+#ifdef _WIN32
+    if (data_)
+    {
+      UnmapViewOfFile(data_);
+    }
+    if (mapping_)
+    {
+      CloseHandle(mapping_);
+    }
+    if (file_ != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(file_);
+    }
+#else
+    if (data_)
+    {
+      munmap(data_, static_cast<size_t>(size_));
+    }
+#endif
+  }
+
+  uint8_t* data() const { return static_cast<uint8_t*>(data_); }
+  uint64_t size() const { return size_; }
+
+private:
+  mapped_region()
+    : data_(nullptr), size_(0)
+#ifdef _WIN32
+    , file_(INVALID_HANDLE_VALUE), mapping_(NULL)
+#endif
+  {
+  }
+
+  void* data_;
+  uint64_t size_;
+#ifdef _WIN32
+  HANDLE file_;
+  HANDLE mapping_;
+#endif
+};
+
+
+// ----------------------------------------------------------------------------
+/// Image memory referencing a frame in a mapped cache file
+class mapped_image_memory : public image_memory
+{
+public:
+  mapped_image_memory(std::shared_ptr<mapped_region> const& region,
+                      uint8_t* data, size_t size)
+    : region_(region)
+  {
+    this->data_ = data;
+    this->size_ = size;
+  }
+
+  virtual ~mapped_image_memory()
+  {
+    // The memory belongs to the mapping, not to the base class
+    this->data_ = nullptr;
+    this->size_ = 0;
+  }
+
+private:
+  std::shared_ptr<mapped_region> region_;
+};
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class frame_cache::priv
+{
+public:
+  priv()
+    : file(nullptr),
+      end(0),
+      failed(false),
+      m_logger(vital::get_logger("frame_cache"))
+  {
+  }
+
+  /// Read the header and index of an existing cache file
+  bool read_index(uint64_t size);
+  /// Test if the open file is empty or starts like a cache file
+  bool replaceable();
+  /// Start a new, empty cache file
+  bool create();
+  /// Serialize the index of the current entries
+  std::vector<uint8_t> write_index() const;
+  /// Rewrite the file with only the current entries
+  bool compact();
+
+  std::string path;
+  FILE* file;
+  /// offset at which the next frame is written
+  uint64_t end;
+  /// set once writing has failed, after which frames are no longer added
+  bool failed;
+
+  std::shared_ptr<mapped_region> region;
+  std::unordered_map<std::string, entry_record> entries;
+  std::vector<std::pair<std::string, entry_record>> added;
+  std::mutex mutex;
+
+  vital::logger_handle_t m_logger;
+};
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache::priv
+::read_index(uint64_t size)
+{
+  file_header header;
+  if (size < sizeof(header) || !seek_file(this->file, 0) ||
+      fread(&header, sizeof(header), 1, this->file) != 1 ||
+      std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+      header.version != cache_version ||
+      header.index_offset > size ||
+      header.index_size > size - header.index_offset)
+  {
+    return false;
+  }
+
+  this->end = size;
+  if (header.entry_count == 0)
+  {
+    return true;
+  }
+
+  this->region = mapped_region::map(this->path, size);
+  if (!this->region)
+  {
+    return false;
+  }
+
+  auto const* p = this->region->data() + header.index_offset;
+  auto const* const index_end = p + header.index_size;
+  for (uint64_t i = 0; i < header.entry_count; ++i)
+  {
+    entry_record r;
+    if (static_cast<uint64_t>(index_end - p) < sizeof(r))
+    {
+      return false;
+    }
+    std::memcpy(&r, p, sizeof(r));
+    p += sizeof(r);
+
+    auto const key_bytes = padded_size(r.key_size, 8);
+    auto const expected = uint64_t{r.width} * r.height * r.depth * r.pixel_bytes;
+    if (static_cast<uint64_t>(index_end - p) < key_bytes ||
+        r.data_offset > size || r.data_size > size - r.data_offset ||
+        r.data_size != expected)
+    {
+      return false;
+    }
+    this->entries[std::string(reinterpret_cast<char const*>(p), r.key_size)] = r;
+    p += key_bytes;
+  }
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache::priv
+::replaceable()
+{
+  file_header header;
+  auto const size = file_size(this->file);
+  return size == 0 ||
+         (size >= sizeof(cache_magic) && seek_file(this->file, 0) &&
+          fread(&header, sizeof(header.magic), 1, this->file) == 1 &&
+          std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) == 0);
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache::priv
+::create()
+{
+  // Only reached when there is no usable cache to reuse, i.e. the file is
+  // missing, empty, or a cache of another version or damaged beyond use.
+  // The file stays open, so that it stays locked.
+  this->entries.clear();
+  this->region.reset();
+  if (!truncate_file(this->file))
+  {
+    return false;
+  }
+
+  auto const header = make_header(0, 0, 0);
+  this->end = sizeof(header);
+  return fwrite(&header, sizeof(header), 1, this->file) == 1;
+}
+
+
+// ----------------------------------------------------------------------------
+std::vector<uint8_t>
+frame_cache::priv
+::write_index() const
+{
+  std::vector<uint8_t> index;
+  for (auto const& e : this->entries)
+  {
+    auto const* const r = reinterpret_cast<uint8_t const*>(&e.second);
+    index.insert(index.end(), r, r + sizeof(entry_record));
+    index.insert(index.end(), e.first.begin(), e.first.end());
+    index.resize(padded_size(index.size(), 8), 0);
+  }
+  return index;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache::priv
+::compact()
+{
+  // Copy the live frames to a new file, then replace the cache with it.  The
+  // existing file holds a complete index at this point, so on failure it is
+  // simply kept.  Frames mapped from the old file stay valid, as the mapping
+  // keeps the replaced file alive (on Windows the replacement fails instead
+  // while frames are still mapped, or while another process has the file
+  // open).  Elsewhere the old file stays open, and so locked, until it has
+  // been replaced, so another process can not start using it in between.
+  auto const temp_path = this->path + ".tmp";
+  auto* const out = fopen(temp_path.c_str(), "wb");
+  if (!out)
+  {
+    return false;
+  }
+
+  static uint8_t const zeros[frame_alignment] = {};
+  auto header = make_header(0, 0, 0);
+  auto ok = fwrite(&header, sizeof(header), 1, out) == 1;
+  uint64_t offset = sizeof(header);
+  std::vector<uint8_t> buffer;
+  for (auto& e : this->entries)
+  {
+    if (!ok)
+    {
+      break;
+    }
+
+    auto& r = e.second;
+    auto const padding = padded_size(offset, frame_alignment) - offset;
+    buffer.resize(static_cast<size_t>(r.data_size));
+    ok = seek_file(this->file, r.data_offset) &&
+         fread(buffer.data(), 1, buffer.size(), this->file) == buffer.size() &&
+         fwrite(zeros, 1, padding, out) == padding &&
+         fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    r.data_offset = offset + padding;
+    offset = r.data_offset + r.data_size;
+  }
+
+  if (ok)
+  {
+    auto const index = this->write_index();
+    header = make_header(offset, index.size(), this->entries.size());
+    ok = fwrite(index.data(), 1, index.size(), out) == index.size() &&
+         fflush(out) == 0 && seek_file(out, 0) &&
+         fwrite(&header, sizeof(header), 1, out) == 1;
+  }
+  ok = (fclose(out) == 0) && ok;
+
+  if (ok)
+  {
+    this->region.reset();
+#ifdef _WIN32
+    fclose(this->file);
+    this->file = nullptr;
+#endif
+    ok = replace_file(temp_path, this->path);
+  }
+  if (!ok)
+  {
+    std::remove(temp_path.c_str());
+  }
+  return ok;
+}
+
+
+// ----------------------------------------------------------------------------
+frame_cache
+::frame_cache()
+  : d_(new priv)
+{
+}
+
+
+// ----------------------------------------------------------------------------
+frame_cache
+::~frame_cache()
+{
+  this->close();
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache
+::open(std::string const& path)
+{
+  this->close();
+
+  d_->path = path;
+  d_->failed = false;
+
+  // The cache is locked while it is open, as runs sharing it would write
+  // over each other's frames and indices
+  bool busy;
+  d_->file = open_locked(path, busy);
+  if (!d_->file)
+  {
+    if (busy)
+    {
+      LOG_WARN(d_->m_logger, "Frame cache " << path
+                             << " is in use by another process");
+    }
+    else
+    {
+      LOG_ERROR(d_->m_logger, "Unable to open frame cache " << path);
+    }
+    return false;
+  }
+
+  auto const size = file_size(d_->file);
+  if (d_->read_index(size))
+  {
+    LOG_DEBUG(d_->m_logger, "Opened frame cache " << path << " with "
+                            << d_->entries.size() << " frames");
+    return true;
+  }
+
+  if (size > 0)
+  {
+    if (!d_->replaceable())
+    {
+      LOG_ERROR(d_->m_logger, "Not replacing " << path
+                              << ", which is not a frame cache");
+      this->close();
+      return false;
+    }
+    LOG_WARN(d_->m_logger, "Replacing invalid frame cache " << path);
+  }
+  if (!d_->create())
+  {
+    LOG_ERROR(d_->m_logger, "Unable to create frame cache " << path);
+    this->close();
+    return false;
+  }
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+frame_cache
+::close()
+{
+  std::lock_guard<std::mutex> lock(d_->mutex);
+  if (!d_->file)
+  {
+    return;
+  }
+
+  if (!d_->added.empty() && !d_->failed)
+  {
+    // Frames added in this run replace older frames with the same key
+    for (auto const& a : d_->added)
+    {
+      d_->entries[a.first] = a.second;
+    }
+
+    // Write the new index after the frames, then point the header to it
+    auto const index = d_->write_index();
+    auto const header =
+      make_header(d_->end, index.size(), d_->entries.size());
+
+    if (!seek_file(d_->file, d_->end) ||
+        fwrite(index.data(), 1, index.size(), d_->file) != index.size() ||
+        fflush(d_->file) != 0 || !seek_file(d_->file, 0) ||
+        fwrite(&header, sizeof(header), 1, d_->file) != 1)
+    {
+      LOG_ERROR(d_->m_logger, "Failed to write frame cache index to "
+                              << d_->path);
+    }
+    else
+    {
+      LOG_DEBUG(d_->m_logger, "Added " << d_->added.size()
+                              << " frames to frame cache " << d_->path);
+
+      // Replaced frames and the indices of earlier runs are never reused;
+      // rewrite the file once they take up more space than the live frames
+      uint64_t live = 0;
+      for (auto const& e : d_->entries)
+      {
+        live += padded_size(e.second.data_size, frame_alignment);
+      }
+      auto const dead = d_->end - sizeof(file_header) - std::min(
+        live, d_->end - sizeof(file_header));
+      if (dead > live)
+      {
+        if (d_->compact())
+        {
+          LOG_DEBUG(d_->m_logger, "Compacted frame cache " << d_->path
+                                  << ", reclaiming " << dead << " bytes");
+        }
+        else
+        {
+          LOG_DEBUG(d_->m_logger, "Unable to compact frame cache "
+                                  << d_->path);
+        }
+      }
+    }
+  }
+
+  if (d_->file)
+  {
+    fclose(d_->file);
+    d_->file = nullptr;
+  }
+  d_->entries.clear();
+  d_->added.clear();
+  d_->region.reset();
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+frame_cache
+::is_open() const
+{
+  return d_->file != nullptr;
+}
+
+
+// ----------------------------------------------------------------------------
+image_container_sptr
+frame_cache
+::find(std::string const& key, int64_t stamp) const
+{
+  auto const ei = d_->entries.find(key);
+  if (ei == d_->entries.end() || ei->second.stamp != stamp || !d_->region)
+  {
+    return nullptr;
+  }
+
+  auto const& r = ei->second;
+  auto* const data = d_->region->data() + r.data_offset;
+  auto const memory = std::make_shared<mapped_image_memory>(
+    d_->region, data, static_cast<size_t>(r.data_size));
+  auto const traits = image_pixel_traits(
+    static_cast<image_pixel_traits::pixel_type>(r.pixel_type), r.pixel_bytes);
+
+  // Frames are stored with interleaved channels
+  image const img(memory, data, r.width, r.height, r.depth,
+                  static_cast<ptrdiff_t>(r.depth),
+                  static_cast<ptrdiff_t>(r.width) * r.depth, 1, traits);
+  return std::make_shared<simple_image_container>(img);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+frame_cache
+::add(std::string const& key, int64_t stamp, image const& img)
+{
+  if (!this->is_open() || d_->failed)
+  {
+    return;
+  }
+
+  // Pack the pixels with interleaved channels
+  auto const pixel_bytes = img.pixel_traits().num_bytes;
+  std::vector<uint8_t> data(img.width() * img.height() * img.depth() *
+                            pixel_bytes);
+  auto const* const base = static_cast<uint8_t const*>(img.first_pixel());
+  auto* out = data.data();
+  for (size_t j = 0; j < img.height(); ++j)
+  {
+    for (size_t i = 0; i < img.width(); ++i)
+    {
+      for (size_t k = 0; k < img.depth(); ++k)
+      {
+        auto const offset = static_cast<ptrdiff_t>(i) * img.w_step() +
+                            static_cast<ptrdiff_t>(j) * img.h_step() +
+                            static_cast<ptrdiff_t>(k) * img.d_step();
+        std::memcpy(out, base + offset * static_cast<ptrdiff_t>(pixel_bytes),
+                    pixel_bytes);
+        out += pixel_bytes;
+      }
+    }
+  }
+
+  entry_record r;
+  r.data_size = data.size();
+  r.stamp = stamp;
+  r.width = static_cast<uint32_t>(img.width());
+  r.height = static_cast<uint32_t>(img.height());
+  r.depth = static_cast<uint32_t>(img.depth());
+  r.pixel_bytes = static_cast<uint32_t>(pixel_bytes);
+  r.pixel_type = static_cast<uint32_t>(img.pixel_traits().type);
+  r.key_size = static_cast<uint32_t>(key.size());
+
+  std::lock_guard<std::mutex> lock(d_->mutex);
+  if (!d_->file || d_->failed)
+  {
+    return;
+  }
+
+  static uint8_t const zeros[frame_alignment] = {};
+  auto const padding = padded_size(d_->end, frame_alignment) - d_->end;
+  r.data_offset = d_->end + padding;
+  if (!seek_file(d_->file, d_->end) ||
+      fwrite(zeros, 1, padding, d_->file) != padding ||
+      fwrite(data.data(), 1, data.size(), d_->file) != data.size())
+  {
+    LOG_ERROR(d_->m_logger, "Failed to write to frame cache " << d_->path
+                            << "; no more frames will be cached");
+    d_->failed = true;
+    return;
+  }
+
+  d_->end = r.data_offset + r.data_size;
+  d_->added.emplace_back(key, r);
+}
+
+
+// ----------------------------------------------------------------------------
+image_container_sptr
+frame_cache
+::convert(image_container_sptr const& frame, color_mode mode,
+          unsigned downscale)
+{
+  if (!frame)
+  {
+    return frame;
+  }
+
+  image const& in = frame->get_image();
+  auto const channels = in.depth();
+  downscale = std::max(1u, downscale);
+  if (!(in.pixel_traits() == image_pixel_traits_of<uint8_t>()) ||
+      (downscale == 1 &&
+       (mode == original || (mode == gray && channels == 1) ||
+        (mode == rgb && channels == 3))))
+  {
+    return frame;
+  }
+
+  auto const width = std::max<size_t>(1, in.width() / downscale);
+  auto const height = std::max<size_t>(1, in.height() / downscale);
+  auto const depth = (mode == gray ? 1 : mode == rgb ? 3 : channels);
+  image_of<uint8_t> const src(in);
+  image_of<uint8_t> out(width, height, depth);
+
+  std::vector<unsigned> sums(channels);
+  for (size_t y = 0; y < height; ++y)
+  {
+    for (size_t x = 0; x < width; ++x)
+    {
+      // Average the source pixels covered by this output pixel
+      auto const x1 = std::min(in.width(), (x + 1) * downscale);
+      auto const y1 = std::min(in.height(), (y + 1) * downscale);
+      std::fill(sums.begin(), sums.end(), 0u);
+      unsigned count = 0;
+      for (size_t sy = y * downscale; sy < y1; ++sy)
+      {
+        for (size_t sx = x * downscale; sx < x1; ++sx, ++count)
+        {
+          for (size_t k = 0; k < channels; ++k)
+          {
+            sums[k] += src(sx, sy, k);
+          }
+        }
+      }
+
+      auto const value = [&](size_t k) {
+        return static_cast<float>(sums[std::min(k, channels - 1)]) / count;
+      };
+      if (mode == gray)
+      {
+        auto const v = (channels >= 3
+                        ? 0.299f * value(0) + 0.587f * value(1) +
+                          0.114f * value(2)
+                        : value(0));
+        out(x, y, 0) = static_cast<uint8_t>(v + 0.5f);
+      }
+      else
+      {
+        for (size_t k = 0; k < depth; ++k)
+        {
+          out(x, y, k) = static_cast<uint8_t>(value(k) + 0.5f);
+        }
+      }
+    }
+  }
+
+  return std::make_shared<simple_image_container>(out);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
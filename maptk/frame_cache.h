@@ -0,0 +1,125 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief On-disk cache of decoded video frames
+ */
+
+#ifndef MAPTK_FRAME_CACHE_H_
+#define MAPTK_FRAME_CACHE_H_
+
+#include <vital/types/image_container.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// A single file holding decoded frames, indexed by source
+/**
+ * Each frame is stored uncompressed under a key, normally the path of the
+ * source image, together with a stamp, normally the modification time of
+ * the source.  A frame is only found if both match.  The index and the
+ * frames present when the cache is opened are memory-mapped, so frames read
+ * from the cache are not copied until they are written to; they remain
+ * valid after the cache is closed.
+ *
+ * Frames added while the cache is open are appended to the file, and the
+ * index is rewritten on close.  The previous index stays valid until the
+ * new one is complete, so an interrupted run loses only its own frames.
+ * Replaced frames and old indices are left in place until they take up more
+ * of the file than the live frames; the file is then rewritten on close.
+ * The file is locked while it is open, so only one process uses a cache at
+ * a time.  add() may be called from several threads at once.
+ */
+class frame_cache
+{
+public:
+  /// How frames are converted before they are cached
+  enum color_mode
+  {
+    /// keep the channels of the source
+    original,
+    /// convert 8-bit color images to a single gray channel
+    gray,
+    /// convert 8-bit images to three color channels
+    rgb,
+  };
+
+  frame_cache();
+  ~frame_cache();
+
+  /// Open (or create) the cache file at \p path
+  /**
+   * The frames of an existing cache are reused.  A cache of another version,
+   * or one that is damaged, is replaced by an empty cache, but a file that
+   * is not a cache at all is left untouched, as is a cache that another
+   * process has open.
+   * \returns false if the file can not be used, created or written, or is
+   *          in use by another process
+   */
+  bool open(std::string const& path);
+  /// Write the index of any added frames and close the file
+  void close();
+  /// Return true if the cache is open
+  bool is_open() const;
+
+  /// Find the frame with \p key and \p stamp, or return null
+  vital::image_container_sptr find(std::string const& key,
+                                   int64_t stamp) const;
+  /// Add a frame to the cache
+  void add(std::string const& key, int64_t stamp, vital::image const& image);
+
+  /// Convert a decoded frame to the form in which it is cached
+  /**
+   * Color conversion and downscaling (by box averaging over
+   * \p downscale x \p downscale pixels) only apply to 8-bit images; other
+   * images are returned unchanged.
+   */
+  static vital::image_container_sptr
+  convert(vital::image_container_sptr const& frame,
+          color_mode mode, unsigned downscale);
+
+private:
+  class priv;
+  std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_FRAME_CACHE_H_
@@ -0,0 +1,586 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::match_features_hnsw
+ */
+
+#include "match_features_hnsw.h"
+
+#include <maptk/descriptor_distance.h>
+#include <maptk/parallel.h>
+
+#include <vital/logger/logger.h>
+#include <vital/types/match_set.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Scratch space for searching a graph
+struct search_scratch
+{
+  search_scratch() : epoch(0) {}
+
+  /// Start a new search over \p count nodes
+  void reset(size_t count)
+  {
+    if (visited.size() != count)
+    {
+      visited.assign(count, 0);
+      epoch = 0;
+    }
+    if (++epoch == 0)
+    {
+      std::fill(visited.begin(), visited.end(), 0u);
+      epoch = 1;
+    }
+  }
+
+  /// Mark a node visited; return false if it already was
+  bool visit(unsigned i)
+  {
+    if (visited[i] == epoch)
+    {
+      return false;
+    }
+    visited[i] = epoch;
+    return true;
+  }
+
+  std::vector<unsigned> visited;
+  unsigned epoch;
+};
+
+
+/// Hierarchical navigable small world graph over a set of descriptors
+template <typename Space>
+class hnsw_index
+{
+public:
+  typedef typename Space::element_t element_t;
+  typedef std::pair<float, unsigned> neighbor;
+
+  /// Build the graph by inserting each descriptor in turn
+  hnsw_index(Space const& space, packed_descriptors<element_t> const& points,
+             unsigned m, unsigned ef_construction)
+    : space_(space), points_(points), m_(std::max(2u, m)),
+      ef_construction_(std::max(m_, ef_construction)),
+      level_scale_(1.0 / std::log(static_cast<double>(m_))),
+      entry_(0), max_level_(0), links_(points.count)
+  {
+    std::mt19937 rng;
+    search_scratch scratch;
+    for (unsigned i = 0; i < points.count; ++i)
+    {
+      this->insert(i, rng, scratch);
+    }
+  }
+
+  /// Find up to \p k nearest neighbors of \p query, nearest first
+  void search(element_t const* query, unsigned k, unsigned ef,
+              std::vector<neighbor>& result, search_scratch& scratch) const
+  {
+    result.clear();
+    if (links_.empty())
+    {
+      return;
+    }
+
+    std::vector<neighbor> entry{{space_(query, points_[entry_]), entry_}};
+    for (int level = max_level_; level > 0; --level)
+    {
+      this->search_layer(query, entry, 1, level, entry, scratch);
+    }
+    this->search_layer(query, entry, std::max(ef, k), 0, result, scratch);
+    if (result.size() > k)
+    {
+      result.resize(k);
+    }
+  }
+
+private:
+  void insert(unsigned i, std::mt19937& rng, search_scratch& scratch);
+
+  void search_layer(element_t const* query, std::vector<neighbor> entry,
+                    unsigned ef, int level, std::vector<neighbor>& result,
+                    search_scratch& scratch) const;
+
+  void select_neighbors(std::vector<neighbor>& candidates,
+                        unsigned m) const;
+
+  Space const space_;
+  packed_descriptors<element_t> const& points_;
+  unsigned const m_;
+  unsigned const ef_construction_;
+  double const level_scale_;
+
+  unsigned entry_;
+  int max_level_;
+  /// neighbor lists of each node at each of its levels
+  std::vector<std::vector<std::vector<unsigned>>> links_;
+};
+
+
+// ----------------------------------------------------------------------------
+template <typename Space>
+void
+hnsw_index<Space>
+::insert(unsigned i, std::mt19937& rng, search_scratch& scratch)
+{
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  auto const level = static_cast<int>(
+    std::floor(-std::log(1.0 - uniform(rng)) * level_scale_));
+  links_[i].resize(level + 1);
+
+  if (i == 0)
+  {
+    entry_ = i;
+    max_level_ = level;
+    return;
+  }
+
+  auto const* const query = points_[i];
+  std::vector<neighbor> entry{{space_(query, points_[entry_]), entry_}};
+  for (int l = max_level_; l > level; --l)
+  {
+    this->search_layer(query, entry, 1, l, entry, scratch);
+  }
+
+  std::vector<neighbor> found;
+  for (int l = std::min(level, max_level_); l >= 0; --l)
+  {
+    this->search_layer(query, entry, ef_construction_, l, found, scratch);
+
+    auto neighbors = found;
+    this->select_neighbors(neighbors, m_);
+
+    auto const max_links = (l == 0 ? 2 * m_ : m_);
+    for (auto const& n : neighbors)
+    {
+      links_[i][l].push_back(n.second);
+
+      auto& reverse = links_[n.second][l];
+      reverse.push_back(i);
+      if (reverse.size() > max_links)
+      {
+        // Prune the neighbor's links using the same heuristic
+        auto const* const p = points_[n.second];
+        std::vector<neighbor> candidates;
+        for (auto const r : reverse)
+        {
+          candidates.emplace_back(space_(p, points_[r]), r);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        this->select_neighbors(candidates, max_links);
+
+        reverse.clear();
+        for (auto const& c : candidates)
+        {
+          reverse.push_back(c.second);
+        }
+      }
+    }
+
+    entry.swap(found);
+  }
+
+  if (level > max_level_)
+  {
+    max_level_ = level;
+    entry_ = i;
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+template <typename Space>
+void
+hnsw_index<Space>
+::search_layer(element_t const* query, std::vector<neighbor> entry,
+               unsigned ef, int level, std::vector<neighbor>& result,
+               search_scratch& scratch) const
+{
+  scratch.reset(links_.size());
+
+  // Candidates to expand, nearest first, and the best found, furthest first
+  std::priority_queue<neighbor, std::vector<neighbor>,
+                      std::greater<neighbor>> candidates;
+  std::priority_queue<neighbor> best;
+  for (auto const& e : entry)
+  {
+    scratch.visit(e.second);
+    candidates.push(e);
+    best.push(e);
+  }
+
+  while (!candidates.empty())
+  {
+    auto const c = candidates.top();
+    if (best.size() >= ef && c.first > best.top().first)
+    {
+      break;
+    }
+    candidates.pop();
+
+    for (auto const n : links_[c.second][level])
+    {
+      if (!scratch.visit(n))
+      {
+        continue;
+      }
+
+      auto const d = space_(query, points_[n]);
+      if (best.size() < ef || d < best.top().first)
+      {
+        candidates.emplace(d, n);
+        best.emplace(d, n);
+        if (best.size() > ef)
+        {
+          best.pop();
+        }
+      }
+    }
+  }
+
+  result.resize(best.size());
+  for (auto r = result.rbegin(); r != result.rend(); ++r)
+  {
+    *r = best.top();
+    best.pop();
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+template <typename Space>
+void
+hnsw_index<Space>
+::select_neighbors(std::vector<neighbor>& candidates, unsigned m) const
+{
+  // Keep candidates closer to the base point than to any kept neighbor, so
+  // that links spread out in different directions; then top up with the
+  // nearest of the rest
+  std::vector<neighbor> selected;
+  std::vector<neighbor> rejected;
+  for (auto const& c : candidates)
+  {
+    if (selected.size() >= m)
+    {
+      break;
+    }
+
+    auto keep = true;
+    for (auto const& s : selected)
+    {
+      if (space_(points_[c.second], points_[s.second]) < c.first)
+      {
+        keep = false;
+        break;
+      }
+    }
+    (keep ? selected : rejected).push_back(c);
+  }
+
+  for (size_t i = 0; i < rejected.size() && selected.size() < m; ++i)
+  {
+    selected.push_back(rejected[i]);
+  }
+  candidates.swap(selected);
+}
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class match_features_hnsw::priv
+{
+public:
+  /// Constructor
+  priv()
+    : m(16),
+      ef_construction(100),
+      ef_search(64),
+      ratio_test(0.8f),
+      cross_check(true)
+  {
+  }
+
+  /// Match descriptors in a given space
+  template <typename Space>
+  std::vector<vital::match>
+  match_descriptors(Space const& space,
+        packed_descriptors<typename Space::element_t> const& set1,
+        packed_descriptors<typename Space::element_t> const& set2) const;
+
+  /// maximum number of links of each graph node per level
+  unsigned m;
+  /// size of the candidate list while building the graph
+  unsigned ef_construction;
+  /// size of the candidate list while searching the graph
+  unsigned ef_search;
+  /// maximum ratio of nearest to second nearest neighbor distance
+  float ratio_test;
+  /// only keep matches which are mutual nearest neighbors
+  bool cross_check;
+
+  /// logger handle
+  vital::logger_handle_t m_logger;
+};
+
+
+// ----------------------------------------------------------------------------
+template <typename Space>
+std::vector<vital::match>
+match_features_hnsw::priv
+::match_descriptors(Space const& space,
+        packed_descriptors<typename Space::element_t> const& set1,
+        packed_descriptors<typename Space::element_t> const& set2) const
+{
+  typedef hnsw_index<Space> index_t;
+  typedef typename index_t::neighbor neighbor_t;
+
+  // Build the index of the second set and, when cross checking, the reverse
+  // index of the first set concurrently; parallel_for waits for both before
+  // propagating an error, so neither build outlives this function
+  std::unique_ptr<index_t> index1, index2;
+  parallel_for(this->cross_check ? 2 : 1, [&](size_t begin, size_t end){
+    for (auto k = begin; k < end; ++k)
+    {
+      auto& index = (k == 0 ? index2 : index1);
+      auto const& set = (k == 0 ? set2 : set1);
+      index.reset(new index_t(space, set, m, ef_construction));
+    }
+  }, 1);
+
+  // Find the nearest neighbor of each descriptor in the first set
+  auto const ratio = Space::ratio_threshold(this->ratio_test);
+  auto const use_ratio = this->ratio_test < 1.0f;
+  std::vector<int> forward(set1.count, -1);
+  parallel_for(set1.count, [&](size_t begin, size_t end){
+    search_scratch scratch;
+    std::vector<neighbor_t> nn;
+    for (auto i = begin; i < end; ++i)
+    {
+      index2->search(set1[i], 2, ef_search, nn, scratch);
+      if (nn.empty() ||
+          (use_ratio && nn.size() > 1 && !(nn[0].first < ratio * nn[1].first)))
+      {
+        continue;
+      }
+      forward[i] = static_cast<int>(nn[0].second);
+    }
+  }, 64);
+
+  std::vector<int> backward;
+  if (this->cross_check)
+  {
+    // Only the matched descriptors of the second set need to be checked
+    backward.assign(set2.count, -1);
+    for (auto const f : forward)
+    {
+      if (f >= 0)
+      {
+        backward[f] = -2;
+      }
+    }
+    parallel_for(set2.count, [&](size_t begin, size_t end){
+      search_scratch scratch;
+      std::vector<neighbor_t> nn;
+      for (auto j = begin; j < end; ++j)
+      {
+        if (backward[j] == -2)
+        {
+          index1->search(set2[j], 1, ef_search, nn, scratch);
+          backward[j] = (nn.empty() ? -1 : static_cast<int>(nn[0].second));
+        }
+      }
+    }, 64);
+  }
+
+  std::vector<vital::match> matches;
+  for (size_t i = 0; i < forward.size(); ++i)
+  {
+    auto const j = forward[i];
+    if (j >= 0 &&
+        (!this->cross_check || backward[j] == static_cast<int>(i)))
+    {
+      matches.emplace_back(set1.index[i], set2.index[j]);
+    }
+  }
+  return matches;
+}
+
+
+// ----------------------------------------------------------------------------
+match_features_hnsw
+::match_features_hnsw()
+  : d_(new priv)
+{
+  attach_logger( "match_features_hnsw" );
+  d_->m_logger = this->logger();
+}
+
+
+// ----------------------------------------------------------------------------
+match_features_hnsw
+::~match_features_hnsw() VITAL_NOTHROW
+{
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+match_features_hnsw
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  config->set_value("m", d_->m,
+                    "The number of links created for each descriptor when it "
+                    "is inserted in the search graph.  Larger values improve "
+                    "recall on high dimensional descriptors at the cost of "
+                    "memory and build time.");
+  config->set_value("ef_construction", d_->ef_construction,
+                    "The number of candidate neighbors considered while "
+                    "building the search graph.");
+  config->set_value("ef_search", d_->ef_search,
+                    "The number of candidate neighbors considered for each "
+                    "query.  Larger values improve recall at the cost of "
+                    "speed.");
+  config->set_value("ratio_test", d_->ratio_test,
+                    "Reject a match unless the distance to the nearest "
+                    "neighbor is less than this fraction of the distance to "
+                    "the second nearest neighbor.  A value of 1 or more "
+                    "disables the test.");
+  config->set_value("cross_check", d_->cross_check,
+                    "If true, only keep matches where each descriptor is the "
+                    "nearest neighbor of the other.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+match_features_hnsw
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  d_->m = config->get_value<unsigned>("m");
+  d_->ef_construction = config->get_value<unsigned>("ef_construction");
+  d_->ef_search = config->get_value<unsigned>("ef_search");
+  d_->ratio_test = config->get_value<float>("ratio_test");
+  d_->cross_check = config->get_value<bool>("cross_check");
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+match_features_hnsw
+::check_configuration(config_block_sptr config) const
+{
+  return config->get_value<unsigned>("m") >= 2 &&
+         config->get_value<unsigned>("ef_search") >= 2 &&
+         config->get_value<float>("ratio_test") > 0.0f;
+}
+
+
+// ----------------------------------------------------------------------------
+match_set_sptr
+match_features_hnsw
+::match(feature_set_sptr feat1, descriptor_set_sptr desc1,
+        feature_set_sptr feat2, descriptor_set_sptr desc2) const
+{
+  // Return empty match set pointer if either of the input sets were empty
+  // pointers
+  if( !desc1 || !desc2 )
+  {
+    return match_set_sptr();
+  }
+
+  auto const first1 = first_descriptor(*desc1);
+  auto const first2 = first_descriptor(*desc2);
+  if (!first1 || !first2)
+  {
+    return std::make_shared<simple_match_set>();
+  }
+
+  auto const binary1 = is_binary(*first1);
+  auto const binary2 = is_binary(*first2);
+  if (binary1 != binary2 || first1->size() != first2->size())
+  {
+    LOG_WARN(d_->m_logger, "Cannot match descriptors of different types");
+    return std::make_shared<simple_match_set>();
+  }
+
+  std::vector<vital::match> matches;
+  auto const size = first1->size();
+  if (binary1)
+  {
+    auto const set1 = pack_binary(*desc1, size);
+    auto const set2 = pack_binary(*desc2, size);
+    matches = d_->match_descriptors(
+      hamming_space{set1.stride}, set1, set2);
+  }
+  else
+  {
+    auto const set1 = pack_float(*desc1, size);
+    auto const set2 = pack_float(*desc2, size);
+    matches = d_->match_descriptors(
+      l2_space{set1.stride}, set1, set2);
+  }
+
+  return std::make_shared<simple_match_set>(matches);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,516 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::match_features_homography_grid
+ */
+
+#include "match_features_homography_grid.h"
+
+#include <maptk/descriptor_distance.h>
+#include <maptk/parallel.h>
+#include <maptk/point_grid.h>
+
+#include <vital/algo/estimate_homography.h>
+#include <vital/logger/logger.h>
+#include <vital/types/feature_set.h>
+#include <vital/types/homography.h>
+#include <vital/types/match_set.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Get the matrix of a homography of any scalar type
+bool
+homography_matrix(homography const& h, matrix_3x3d& m)
+{
+  if (auto const hd = dynamic_cast<homography_<double> const*>(&h))
+  {
+    m = hd->get_matrix();
+    return true;
+  }
+  if (auto const hf = dynamic_cast<homography_<float> const*>(&h))
+  {
+    m = hf->get_matrix().cast<double>();
+    return true;
+  }
+  return false;
+}
+
+
+/// Select the features (and descriptors) of greatest magnitude
+/**
+ * Null features are never selected.
+ */
+void
+strongest_features(feature_set_sptr& features,
+                   descriptor_set_sptr& descriptors, size_t count)
+{
+  auto const& feat = features->features();
+  auto const& desc = descriptors->descriptors();
+  if (feat.size() != desc.size())
+  {
+    return;
+  }
+
+  std::vector<size_t> order;
+  order.reserve(feat.size());
+  for (size_t i = 0; i < feat.size(); ++i)
+  {
+    if (feat[i])
+    {
+      order.push_back(i);
+    }
+  }
+  if (order.size() == feat.size() && feat.size() <= count)
+  {
+    return;
+  }
+
+  count = std::min(count, order.size());
+  std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                    [&feat](size_t a, size_t b){
+                      return feat[a]->magnitude() > feat[b]->magnitude();
+                    });
+
+  std::vector<feature_sptr> out_feat;
+  std::vector<descriptor_sptr> out_desc;
+  for (size_t i = 0; i < count; ++i)
+  {
+    out_feat.push_back(feat[order[i]]);
+    out_desc.push_back(desc[order[i]]);
+  }
+  features = std::make_shared<simple_feature_set>(out_feat);
+  descriptors = std::make_shared<simple_descriptor_set>(out_desc);
+}
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class match_features_homography_grid::priv
+{
+public:
+  /// Constructor
+  priv()
+    : seed_count(500),
+      min_seed_inliers(20),
+      inlier_scale(4.0),
+      search_radius(20.0),
+      ratio_test(0.8f),
+      one_to_one(true)
+  {
+  }
+
+  /// Estimate a homography from matches of the strongest features
+  bool estimate(feature_set_sptr feat1, descriptor_set_sptr desc1,
+                feature_set_sptr feat2, descriptor_set_sptr desc2,
+                matrix_3x3d& h) const;
+
+  /// Match descriptors of features within the search radius
+  template <typename Space>
+  std::vector<vital::match>
+  match_nearby(Space const& space,
+               packed_descriptors<typename Space::element_t> const& set1,
+               packed_descriptors<typename Space::element_t> const& set2,
+               std::vector<feature_sptr> const& features1,
+               std::vector<feature_sptr> const& features2,
+               matrix_3x3d const& homography) const;
+
+  /// number of strongest features matched to estimate the homography
+  unsigned seed_count;
+  /// minimum number of inliers of the estimated homography
+  unsigned min_seed_inliers;
+  /// inlier threshold of the homography estimation, in pixels
+  double inlier_scale;
+  /// radius around the warped location in which to search, in pixels
+  double search_radius;
+  /// maximum ratio of nearest to second nearest neighbor distance
+  float ratio_test;
+  /// keep only the best match to each feature of the second set
+  bool one_to_one;
+
+  /// the feature matcher used to match the strongest features
+  vital::algo::match_features_sptr seed_matcher;
+  /// the homography estimator fit to the seed matches
+  vital::algo::estimate_homography_sptr homography_estimator;
+  /// logger handle
+  vital::logger_handle_t m_logger;
+};
+
+
+// ----------------------------------------------------------------------------
+bool
+match_features_homography_grid::priv
+::estimate(feature_set_sptr feat1, descriptor_set_sptr desc1,
+           feature_set_sptr feat2, descriptor_set_sptr desc2,
+           matrix_3x3d& h) const
+{
+  if (!this->seed_matcher || !this->homography_estimator)
+  {
+    return false;
+  }
+
+  strongest_features(feat1, desc1, seed_count);
+  strongest_features(feat2, desc2, seed_count);
+
+  auto const seeds = this->seed_matcher->match(feat1, desc1, feat2, desc2);
+  if (!seeds || seeds->size() < min_seed_inliers)
+  {
+    return false;
+  }
+
+  std::vector<bool> inliers;
+  auto const hs = this->homography_estimator->estimate(feat1, feat2, seeds,
+                                                       inliers, inlier_scale);
+  auto const num_inliers = std::count(inliers.begin(), inliers.end(), true);
+  if (!hs || num_inliers < static_cast<decltype(num_inliers)>(min_seed_inliers))
+  {
+    LOG_DEBUG(m_logger, "Seed homography has too few inliers ("
+                        << num_inliers << ")");
+    return false;
+  }
+
+  return homography_matrix(*hs, h);
+}
+
+
+// ----------------------------------------------------------------------------
+template <typename Space>
+std::vector<vital::match>
+match_features_homography_grid::priv
+::match_nearby(Space const& space,
+               packed_descriptors<typename Space::element_t> const& set1,
+               packed_descriptors<typename Space::element_t> const& set2,
+               std::vector<feature_sptr> const& features1,
+               std::vector<feature_sptr> const& features2,
+               matrix_3x3d const& homography) const
+{
+  // Work on the packed rows, which omit unusable descriptors; warp the first
+  // features into the second image
+  std::vector<vector_2d> warped1(set1.count);
+  std::vector<char> valid1(set1.count, 0);
+  for (size_t i = 0; i < set1.count; ++i)
+  {
+    auto const& f = features1[set1.index[i]];
+    if (!f)
+    {
+      continue;
+    }
+    auto const p = vector_3d(homography * f->loc().homogeneous());
+    if (std::abs(p.z()) > 1e-12)
+    {
+      warped1[i] = p.hnormalized();
+      valid1[i] = 1;
+    }
+  }
+
+  std::vector<vector_2d> points2(set2.count, vector_2d::Zero());
+  std::vector<char> valid2(set2.count, 0);
+  for (size_t j = 0; j < set2.count; ++j)
+  {
+    auto const& f = features2[set2.index[j]];
+    if (f)
+    {
+      points2[j] = f->loc();
+      valid2[j] = 1;
+    }
+  }
+
+  point_grid const grid(points2, search_radius);
+
+  auto const radius_sq = search_radius * search_radius;
+  auto const ratio = Space::ratio_threshold(this->ratio_test);
+  auto const use_ratio = this->ratio_test < 1.0f;
+
+  // Find the best nearby match of each feature of the first set
+  std::vector<std::pair<int, float>> forward(set1.count, {-1, 0.0f});
+  parallel_for(set1.count, [&](size_t begin, size_t end){
+    for (auto i = begin; i < end; ++i)
+    {
+      if (!valid1[i])
+      {
+        continue;
+      }
+
+      auto best = std::numeric_limits<float>::max();
+      auto second = std::numeric_limits<float>::max();
+      auto best_j = -1;
+      grid.query(warped1[i], search_radius, [&](unsigned j){
+        if (!valid2[j] || (points2[j] - warped1[i]).squaredNorm() > radius_sq)
+        {
+          return;
+        }
+
+        auto const d = space(set1[i], set2[j]);
+        if (d < best)
+        {
+          second = best;
+          best = d;
+          best_j = static_cast<int>(j);
+        }
+        else if (d < second)
+        {
+          second = d;
+        }
+      });
+
+      if (best_j < 0 ||
+          (use_ratio && second < std::numeric_limits<float>::max() &&
+           !(best < ratio * second)))
+      {
+        continue;
+      }
+      forward[i] = {best_j, best};
+    }
+  }, 256);
+
+  // Resolve features of the second set matched more than once
+  std::vector<int> owner;
+  if (this->one_to_one)
+  {
+    owner.assign(set2.count, -1);
+    for (size_t i = 0; i < forward.size(); ++i)
+    {
+      auto const j = forward[i].first;
+      if (j >= 0 &&
+          (owner[j] < 0 || forward[i].second < forward[owner[j]].second))
+      {
+        owner[j] = static_cast<int>(i);
+      }
+    }
+  }
+
+  std::vector<vital::match> matches;
+  for (size_t i = 0; i < forward.size(); ++i)
+  {
+    auto const j = forward[i].first;
+    if (j >= 0 && (!this->one_to_one || owner[j] == static_cast<int>(i)))
+    {
+      matches.emplace_back(set1.index[i], set2.index[j]);
+    }
+  }
+  return matches;
+}
+
+
+// ----------------------------------------------------------------------------
+match_features_homography_grid
+::match_features_homography_grid()
+  : d_(new priv)
+{
+  attach_logger( "match_features_homography_grid" );
+  d_->m_logger = this->logger();
+}
+
+
+// ----------------------------------------------------------------------------
+match_features_homography_grid
+::~match_features_homography_grid() VITAL_NOTHROW
+{
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+match_features_homography_grid
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  // Sub-algorithm implementation name + sub_config block
+  algo::match_features::get_nested_algo_configuration(
+    "seed_matcher", config, d_->seed_matcher);
+  algo::estimate_homography::get_nested_algo_configuration(
+    "homography_estimator", config, d_->homography_estimator);
+
+  config->set_value("seed_count", d_->seed_count,
+                    "The number of strongest features of each set which are "
+                    "matched to estimate the homography.");
+  config->set_value("min_seed_inliers", d_->min_seed_inliers,
+                    "The minimum number of inliers of the estimated "
+                    "homography.  If there are fewer, the seed matcher is "
+                    "used to match all of the features.");
+  config->set_value("inlier_scale", d_->inlier_scale,
+                    "The acceptable error distance (in pixels) between warped "
+                    "and measured points to be considered an inlier match "
+                    "when estimating the homography.");
+  config->set_value("search_radius", d_->search_radius,
+                    "The distance (in pixels) from the warped location of a "
+                    "feature in which to search for matches.");
+  config->set_value("ratio_test", d_->ratio_test,
+                    "Reject a match unless its descriptor distance is less "
+                    "than this fraction of the distance to the second best "
+                    "feature within the search radius.  A value of 1 or more "
+                    "disables the test.");
+  config->set_value("one_to_one", d_->one_to_one,
+                    "If true, a feature of the second set is only matched to "
+                    "the feature of the first set with the closest "
+                    "descriptor.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+match_features_homography_grid
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  // Setting nested algorithm instances via setter methods instead of directly
+  // assigning to instance property.
+  algo::match_features::set_nested_algo_configuration(
+    "seed_matcher", config, d_->seed_matcher);
+  algo::estimate_homography::set_nested_algo_configuration(
+    "homography_estimator", config, d_->homography_estimator);
+
+  d_->seed_count = config->get_value<unsigned>("seed_count");
+  d_->min_seed_inliers = config->get_value<unsigned>("min_seed_inliers");
+  d_->inlier_scale = config->get_value<double>("inlier_scale");
+  d_->search_radius = config->get_value<double>("search_radius");
+  d_->ratio_test = config->get_value<float>("ratio_test");
+  d_->one_to_one = config->get_value<bool>("one_to_one");
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+match_features_homography_grid
+::check_configuration(config_block_sptr config) const
+{
+  return
+    algo::match_features::check_nested_algo_configuration(
+      "seed_matcher", config) &&
+    algo::estimate_homography::check_nested_algo_configuration(
+      "homography_estimator", config) &&
+    config->get_value<unsigned>("min_seed_inliers") >= 4 &&
+    config->get_value<double>("search_radius") > 0.0 &&
+    config->get_value<float>("ratio_test") > 0.0f;
+}
+
+
+// ----------------------------------------------------------------------------
+match_set_sptr
+match_features_homography_grid
+::match(feature_set_sptr feat1, descriptor_set_sptr desc1,
+        feature_set_sptr feat2, descriptor_set_sptr desc2) const
+{
+  // Return empty match set pointer if either of the input sets were empty
+  // pointers
+  if( !feat1 || !desc1 || !feat2 || !desc2 )
+  {
+    return match_set_sptr();
+  }
+
+  matrix_3x3d h;
+  if (d_->estimate(feat1, desc1, feat2, desc2, h))
+  {
+    return this->guided_match(feat1, desc1, feat2, desc2, h);
+  }
+
+  LOG_DEBUG(d_->m_logger, "No homography estimated, matching all features");
+  if (!d_->seed_matcher)
+  {
+    return match_set_sptr();
+  }
+  return d_->seed_matcher->match(feat1, desc1, feat2, desc2);
+}
+
+
+// ----------------------------------------------------------------------------
+match_set_sptr
+match_features_homography_grid
+::guided_match(feature_set_sptr feat1, descriptor_set_sptr desc1,
+               feature_set_sptr feat2, descriptor_set_sptr desc2,
+               matrix_3x3d const& homography) const
+{
+  if( !feat1 || !desc1 || !feat2 || !desc2 )
+  {
+    return match_set_sptr();
+  }
+
+  auto const& features1 = feat1->features();
+  auto const& features2 = feat2->features();
+  if (features1.size() != desc1->size() || features2.size() != desc2->size())
+  {
+    LOG_WARN(d_->m_logger, "Feature and descriptor counts differ");
+    return std::make_shared<simple_match_set>();
+  }
+
+  auto const first1 = first_descriptor(*desc1);
+  auto const first2 = first_descriptor(*desc2);
+  if (!first1 || !first2 ||
+      is_binary(*first1) != is_binary(*first2) ||
+      first1->size() != first2->size())
+  {
+    return std::make_shared<simple_match_set>();
+  }
+
+  std::vector<vital::match> matches;
+  auto const size = first1->size();
+  if (is_binary(*first1))
+  {
+    auto const set1 = pack_binary(*desc1, size);
+    auto const set2 = pack_binary(*desc2, size);
+    matches = d_->match_nearby(hamming_space{set1.stride}, set1, set2,
+                               features1, features2, homography);
+  }
+  else
+  {
+    auto const set1 = pack_float(*desc1, size);
+    auto const set2 = pack_float(*desc2, size);
+    matches = d_->match_nearby(l2_space{set1.stride}, set1, set2,
+                               features1, features2, homography);
+  }
+
+  return std::make_shared<simple_match_set>(matches);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,123 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::match_features_homography_grid
+ */
+
+#ifndef MAPTK_MATCH_FEATURES_HOMOGRAPHY_GRID_H_
+#define MAPTK_MATCH_FEATURES_HOMOGRAPHY_GRID_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/algo/algorithm.h>
+#include <vital/algo/match_features.h>
+#include <vital/config/config_block.h>
+#include <vital/types/matrix.h>
+
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Homography guided feature matching using a spatial grid
+/**
+ * This class warps the features of the first set by a homography into the
+ * second image, and compares descriptors only with the features of the
+ * second set which lie within a search radius of the warped location.  The
+ * features of the second set are bucketed in a uniform grid with cells the
+ * size of the search radius, so that matching time is roughly linear in the
+ * number of features.
+ *
+ * When no homography is given, one is estimated by matching only the
+ * strongest features of each set with the nested seed matcher and fitting
+ * a homography to those matches with the nested estimator.  If that fails,
+ * the seed matcher is used to match the full sets.
+ */
+class MAPTK_EXPORT match_features_homography_grid
+  : public vital::algorithm_impl<match_features_homography_grid,
+                                 vital::algo::match_features>
+{
+public:
+  /// Default Constructor
+  match_features_homography_grid();
+
+  /// Destructor
+  virtual ~match_features_homography_grid() VITAL_NOTHROW;
+
+  /// Get this algorithm's \link vital::config_block configuration block \endlink
+  virtual vital::config_block_sptr get_configuration() const;
+  /// Set this algorithm's properties via a config block
+  virtual void set_configuration(vital::config_block_sptr config);
+  /// Check that the algorithm's currently configuration is valid
+  virtual bool check_configuration(vital::config_block_sptr config) const;
+
+  /// Match one set of features and corresponding descriptors to another
+  /**
+   * \param [in] feat1 the first set of features to match
+   * \param [in] desc1 the descriptors corresponding to \a feat1
+   * \param [in] feat2 the second set of features to match
+   * \param [in] desc2 the descriptors corresponding to \a feat2
+   * \returns a set of matching indices from \a feat1 to \a feat2
+   */
+  virtual vital::match_set_sptr
+  match(vital::feature_set_sptr feat1, vital::descriptor_set_sptr desc1,
+        vital::feature_set_sptr feat2, vital::descriptor_set_sptr desc2) const;
+
+  /// Match features given a predicted homography
+  /**
+   * \param [in] feat1 the first set of features to match
+   * \param [in] desc1 the descriptors corresponding to \a feat1
+   * \param [in] feat2 the second set of features to match
+   * \param [in] desc2 the descriptors corresponding to \a feat2
+   * \param [in] homography maps feature locations of the first set to the
+   *                        image of the second set
+   * \returns a set of matching indices from \a feat1 to \a feat2
+   */
+  vital::match_set_sptr
+  guided_match(vital::feature_set_sptr feat1, vital::descriptor_set_sptr desc1,
+               vital::feature_set_sptr feat2, vital::descriptor_set_sptr desc2,
+               vital::matrix_3x3d const& homography) const;
+
+private:
+  /// private implementation class
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_MATCH_FEATURES_HOMOGRAPHY_GRID_H_
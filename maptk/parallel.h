@@ -0,0 +1,174 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Helper for running loops on the KWIVER thread pool
+ */
+
+#ifndef MAPTK_PARALLEL_H_
+#define MAPTK_PARALLEL_H_
+
+#include <vital/util/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace detail {
+
+/// Shared state of a parallel_for call
+/**
+ * Chunks are claimed through the atomic \c next index by the calling thread
+ * and by any helper job that gets to run.  Helper jobs hold a reference to
+ * this state rather than to the caller's stack, so a job that only starts
+ * after the call has returned finds nothing left to claim and exits without
+ * touching \c work.
+ */
+template <typename Work>
+struct parallel_for_state
+{
+  parallel_for_state(size_t count, size_t chunks, Work const& work)
+    : count(count), chunks(chunks), work(work), next(0), active(0) {}
+
+  /// Claim and process chunks until none remain or one has failed
+  void run()
+  {
+    for (size_t c; (c = next++) < chunks; )
+    {
+      try
+      {
+        work(count * c / chunks, count * (c + 1) / chunks);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error)
+        {
+          error = std::current_exception();
+        }
+        next = chunks;
+      }
+    }
+  }
+
+  /// Entry point of a helper job on the thread pool
+  void help()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (next >= chunks)
+      {
+        return;
+      }
+      ++active;
+    }
+
+    run();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--active == 0)
+    {
+      finished.notify_all();
+    }
+  }
+
+  size_t const count;
+  size_t const chunks;
+  Work const& work;
+
+  std::atomic<size_t> next;
+
+  // Number of helpers currently processing chunks, guarded by mutex
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t active;
+  std::exception_ptr error;
+};
+
+} // end namespace detail
+
+
+/// Run \p work on sub-ranges of [0, \p count) using the thread pool
+/**
+ * The range is split into chunks of no fewer than \p grain items, which are
+ * claimed in turn by the calling thread and by helper jobs on the thread
+ * pool.  The calling thread keeps claiming chunks until none remain, and then
+ * waits only for helpers that are still processing one, so this is safe to
+ * call from a job that is itself running on the pool.  \p work is called as
+ * <code>work(begin, end)</code> and must be safe to call concurrently on
+ * disjoint ranges.  If \p work throws, no further chunks are started and the
+ * first exception is rethrown once all running chunks have finished.
+ */
+template <typename Work>
+void
+parallel_for(size_t count, Work const& work, size_t grain = 1024)
+{
+  size_t const threads =
+    std::max(1u, std::thread::hardware_concurrency());
+  size_t const chunks =
+    std::min(4 * threads, count / std::max<size_t>(grain, 1) + 1);
+  if (chunks < 2)
+  {
+    work(size_t{0}, count);
+    return;
+  }
+
+  auto const state =
+    std::make_shared<detail::parallel_for_state<Work>>(count, chunks, work);
+  for (size_t i = 1; i < std::min(threads, chunks); ++i)
+  {
+    vital::thread_pool::instance().enqueue([state]{ state->help(); });
+  }
+
+  state->run();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock, [&state]{ return state->active == 0; });
+  if (state->error)
+  {
+    std::rethrow_exception(state->error);
+  }
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_PARALLEL_H_
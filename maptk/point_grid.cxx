@@ -0,0 +1,99 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::point_grid
+ */
+
+#include "point_grid.h"
+
+#include <cmath>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+
+// ----------------------------------------------------------------------------
+point_grid
+::point_grid(std::vector<vector_2d> const& points, double cell_size)
+  : min_(0.0, 0.0), max_(0.0, 0.0), cell_size_(cell_size), nx_(1), ny_(1)
+{
+  if (!points.empty())
+  {
+    min_ = max_ = points.front();
+    for (auto const& p : points)
+    {
+      min_ = min_.cwiseMin(p);
+      max_ = max_.cwiseMax(p);
+    }
+  }
+
+  // Keep the number of cells proportional to the number of points, in case
+  // a few points lie far away from the rest
+  auto const max_cells = std::max<double>(1024.0, 4.0 * points.size());
+  auto const extent = vector_2d(max_ - min_);
+  while ((std::floor(extent.x() / cell_size_) + 1.0) *
+         (std::floor(extent.y() / cell_size_) + 1.0) > max_cells)
+  {
+    cell_size_ *= 2.0;
+  }
+  nx_ = static_cast<int>(extent.x() / cell_size_) + 1;
+  ny_ = static_cast<int>(extent.y() / cell_size_) + 1;
+
+  // Counting sort of the points by cell
+  std::vector<unsigned> cells(points.size());
+  cell_start_.assign(static_cast<size_t>(nx_ * ny_) + 1, 0);
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    auto const x = static_cast<int>((points[i].x() - min_.x()) / cell_size_);
+    auto const y = static_cast<int>((points[i].y() - min_.y()) / cell_size_);
+    cells[i] = static_cast<unsigned>(std::min(y, ny_ - 1) * nx_ +
+                                     std::min(x, nx_ - 1));
+    ++cell_start_[cells[i] + 1];
+  }
+  for (size_t c = 1; c < cell_start_.size(); ++c)
+  {
+    cell_start_[c] += cell_start_[c - 1];
+  }
+
+  auto next = cell_start_;
+  indices_.resize(points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+  {
+    indices_[next[cells[i]]++] = static_cast<unsigned>(i);
+  }
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,117 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Uniform grid for finding nearby image points
+ */
+
+#ifndef MAPTK_POINT_GRID_H_
+#define MAPTK_POINT_GRID_H_
+
+#include <vital/types/vector.h>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Indices of points bucketed in a uniform grid
+/**
+ * The points are sorted into square cells by a counting sort, so building
+ * the grid is linear in the number of points.  The cell size is increased if
+ * needed to keep the number of cells proportional to the number of points.
+ */
+class point_grid
+{
+public:
+  point_grid(std::vector<vital::vector_2d> const& points, double cell_size);
+
+  /// Call \p visit with the index of each point in the cells overlapping
+  /// the square of half width \p radius around \p center
+  template <typename Visit>
+  void query(vital::vector_2d const& center, double radius,
+             Visit const& visit) const;
+
+private:
+  vital::vector_2d min_;
+  vital::vector_2d max_;
+  double cell_size_;
+  int nx_;
+  int ny_;
+  /// offset in indices_ of the first point of each cell, and the end
+  std::vector<unsigned> cell_start_;
+  std::vector<unsigned> indices_;
+};
+
+
+// ----------------------------------------------------------------------------
+template <typename Visit>
+inline void
+point_grid
+::query(vital::vector_2d const& center, double radius,
+        Visit const& visit) const
+{
+  if (center.x() + radius < min_.x() || center.x() - radius > max_.x() ||
+      center.y() + radius < min_.y() || center.y() - radius > max_.y())
+  {
+    return;
+  }
+
+  auto const cell = [this](double v, double origin, int n){
+    return std::max(0, std::min(n - 1,
+                                static_cast<int>((v - origin) / cell_size_)));
+  };
+  auto const x0 = cell(center.x() - radius, min_.x(), nx_);
+  auto const x1 = cell(center.x() + radius, min_.x(), nx_);
+  auto const y0 = cell(center.y() - radius, min_.y(), ny_);
+  auto const y1 = cell(center.y() + radius, min_.y(), ny_);
+
+  for (int y = y0; y <= y1; ++y)
+  {
+    // Cells of a row are contiguous
+    auto const first = cell_start_[y * nx_ + x0];
+    auto const last = cell_start_[y * nx_ + x1 + 1];
+    for (auto k = first; k < last; ++k)
+    {
+      visit(indices_[k]);
+    }
+  }
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_POINT_GRID_H_
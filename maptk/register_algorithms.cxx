@@ -0,0 +1,119 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Registration function for the MAP-Tk algorithm implementations
+ */
+
+#include <maptk/maptk_plugin_export.h>
+
+#include <vital/algo/algorithm_factory.h>
+
+#include <maptk/close_loops_vocabulary_tree.h>
+#include <maptk/match_features_hnsw.h>
+#include <maptk/match_features_homography_grid.h>
+#include <maptk/track_features_klt.h>
+#include <maptk/triangulate_landmarks_parallel.h>
+#include <maptk/video_input_prefetch.h>
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Register one algorithm implementation provided by this module
+template <typename algorithm_t>
+void
+add_algorithm( kwiver::vital::plugin_loader& vpm,
+               std::string const& module_name,
+               char const* name, char const* description )
+{
+  auto fact = vpm.ADD_ALGORITHM( name, algorithm_t );
+  fact->add_attribute( kwiver::vital::plugin_factory::PLUGIN_DESCRIPTION,
+                       description )
+    .add_attribute( kwiver::vital::plugin_factory::PLUGIN_MODULE_NAME,
+                    module_name )
+    .add_attribute( kwiver::vital::plugin_factory::PLUGIN_VERSION, "1.0" )
+    .add_attribute( kwiver::vital::plugin_factory::PLUGIN_ORGANIZATION,
+                    "Kitware Inc." )
+    ;
+}
+
+} // end anonymous namespace
+
+
+extern "C"
+MAPTK_PLUGIN_EXPORT
+void
+register_factories( kwiver::vital::plugin_loader& vpm )
+{
+  static auto const module_name = std::string( "maptk" );
+  if ( vpm.is_module_loaded( module_name ) )
+  {
+    return;
+  }
+
+  add_algorithm< close_loops_vocabulary_tree >(
+    vpm, module_name, "vocabulary_tree",
+    "Loop closure by retrieving similar frames from an incrementally "
+    "learned vocabulary tree and matching only those frames." );
+
+  add_algorithm< match_features_hnsw >(
+    vpm, module_name, "hnsw",
+    "Approximate nearest neighbor matching with a hierarchical navigable "
+    "small world graph, using SIMD distance kernels." );
+
+  add_algorithm< match_features_homography_grid >(
+    vpm, module_name, "homography_grid",
+    "Homography guided matching, comparing descriptors only of features "
+    "near their warped location in a uniform spatial grid." );
+
+  add_algorithm< track_features_klt >(
+    vpm, module_name, "klt",
+    "Feature tracking by pyramidal Lucas-Kanade optical flow, with "
+    "detection only in sparse grid cells and on keyframes." );
+
+  add_algorithm< triangulate_landmarks_parallel >(
+    vpm, module_name, "parallel",
+    "Triangulation of chunks of the landmark map concurrently, each by its "
+    "own instance of a nested triangulator." );
+
+  add_algorithm< video_input_prefetch >(
+    vpm, module_name, "prefetch",
+    "Decodes the frames of another video input, such as an image list, "
+    "ahead of the consumer on several threads." );
+
+  vpm.mark_module_as_loaded( module_name );
+}
+
+} // end namespace maptk
+} // end namespace kwiver
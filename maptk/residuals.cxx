@@ -0,0 +1,273 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk reprojection residual analysis functions
+ */
+
+#include "residuals.h"
+
+#include <maptk/parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Statistics accumulated over one contiguous range of tracks
+struct partial_statistics
+{
+  partial_statistics() : invalid(0) {}
+
+  residual_summary total;
+  std::unordered_map<vital::frame_id_t, residual_summary> cameras;
+  std::vector<size_t> histogram;
+  std::vector<reprojection_outlier> outliers;
+  size_t invalid;
+};
+
+/// Order outliers by track and then by frame
+bool
+outlier_less(reprojection_outlier const& a, reprojection_outlier const& b)
+{
+  return a.track < b.track || (a.track == b.track && a.frame < b.frame);
+}
+
+} // end anonymous namespace
+
+
+// ----------------------------------------------------------------------------
+void
+residual_summary
+::add(double error)
+{
+  ++this->count;
+  this->sum_squared += error * error;
+  this->max_error = std::max(this->max_error, error);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+residual_summary
+::add(residual_summary const& other)
+{
+  this->count += other.count;
+  this->sum_squared += other.sum_squared;
+  this->max_error = std::max(this->max_error, other.max_error);
+}
+
+
+// ----------------------------------------------------------------------------
+double
+residual_summary
+::rmse() const
+{
+  return this->count ? std::sqrt(this->sum_squared / this->count) : 0.0;
+}
+
+
+// ----------------------------------------------------------------------------
+reprojection_statistics
+compute_reprojection_statistics(
+  vital::camera_map::map_camera_t const& cameras,
+  vital::landmark_map::map_landmark_t const& landmarks,
+  std::vector<vital::track_sptr> const& tracks,
+  double outlier_threshold,
+  double bin_width,
+  unsigned num_bins)
+{
+  num_bins = std::max(1u, num_bins);
+  bin_width = bin_width > 0.0 ? bin_width : 1.0;
+
+  // Per-track results are written in place; everything else is accumulated
+  // per range of tracks and merged afterward in range order
+  std::vector<residual_summary> track_summaries(tracks.size());
+  std::map<size_t, partial_statistics> partials;
+  std::mutex partials_mutex;
+
+  parallel_for(tracks.size(), [&](size_t begin, size_t end)
+  {
+    partial_statistics partial;
+    partial.histogram.resize(num_bins, 0);
+
+    for (size_t i = begin; i < end; ++i)
+    {
+      auto const& t = tracks[i];
+      auto const lmi = landmarks.find(static_cast<vital::landmark_id_t>(t->id()));
+      if (lmi == landmarks.end() || !lmi->second)
+      {
+        continue;
+      }
+      auto const& point = lmi->second->loc();
+
+      for (auto const& ts : *t)
+      {
+        auto const fts =
+          std::dynamic_pointer_cast<vital::feature_track_state>(ts);
+        if (!fts || !fts->feature)
+        {
+          continue;
+        }
+        auto const ci = cameras.find(ts->frame());
+        if (ci == cameras.end() || !ci->second)
+        {
+          continue;
+        }
+
+        auto const error =
+          (ci->second->project(point) - fts->feature->loc()).norm();
+        if (!std::isfinite(error))
+        {
+          // Degenerate cameras project to infinity or NaN; leave these out
+          // of the statistics, but report them as outliers if any are
+          ++partial.invalid;
+          if (outlier_threshold > 0.0)
+          {
+            partial.outliers.push_back(
+              {t->id(), ts->frame(), std::numeric_limits<double>::infinity()});
+          }
+          continue;
+        }
+
+        track_summaries[i].add(error);
+        partial.total.add(error);
+        partial.cameras[ts->frame()].add(error);
+
+        auto const bin = static_cast<size_t>(error / bin_width);
+        ++partial.histogram[std::min<size_t>(bin, num_bins - 1)];
+
+        if (outlier_threshold > 0.0 && error > outlier_threshold)
+        {
+          partial.outliers.push_back({t->id(), ts->frame(), error});
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(partials_mutex);
+    partials[begin] = std::move(partial);
+  }, 256);
+
+  reprojection_statistics stats;
+  stats.bin_width = bin_width;
+  stats.histogram.resize(num_bins, 0);
+  stats.invalid = 0;
+  for (auto const& p : partials)
+  {
+    stats.invalid += p.second.invalid;
+    stats.total.add(p.second.total);
+    for (auto const& c : p.second.cameras)
+    {
+      stats.cameras[c.first].add(c.second);
+    }
+    for (unsigned b = 0; b < num_bins; ++b)
+    {
+      stats.histogram[b] += p.second.histogram[b];
+    }
+    stats.outliers.insert(stats.outliers.end(),
+                          p.second.outliers.begin(), p.second.outliers.end());
+  }
+  for (size_t i = 0; i < tracks.size(); ++i)
+  {
+    if (track_summaries[i].count)
+    {
+      stats.tracks[tracks[i]->id()].add(track_summaries[i]);
+    }
+  }
+  std::sort(stats.outliers.begin(), stats.outliers.end(), outlier_less);
+
+  return stats;
+}
+
+
+// ----------------------------------------------------------------------------
+vital::feature_track_set_sptr
+remove_outliers(vital::feature_track_set const& tracks,
+                std::vector<reprojection_outlier> const& outliers,
+                size_t min_track_length)
+{
+  std::vector<vital::track_sptr> pruned;
+  for (auto const& t : tracks.tracks())
+  {
+    reprojection_outlier const key =
+      { t->id(), std::numeric_limits<vital::frame_id_t>::min(), 0.0 };
+    auto oi = std::lower_bound(outliers.begin(), outliers.end(), key,
+                               outlier_less);
+    if (oi == outliers.end() || oi->track != t->id())
+    {
+      pruned.push_back(t);
+      continue;
+    }
+
+    // Copy the track, skipping the states of the outliers
+    auto nt = vital::track::create();
+    nt->set_id(t->id());
+    for (auto const& ts : *t)
+    {
+      while (oi != outliers.end() && oi->track == t->id() &&
+             oi->frame < ts->frame())
+      {
+        ++oi;
+      }
+      if (oi != outliers.end() && oi->track == t->id() &&
+          oi->frame == ts->frame())
+      {
+        continue;
+      }
+
+      auto const fts =
+        std::dynamic_pointer_cast<vital::feature_track_state>(ts);
+      if (fts)
+      {
+        nt->append(std::make_shared<vital::feature_track_state>(
+          fts->frame(), fts->feature, fts->descriptor));
+      }
+    }
+
+    if (nt->size() >= min_track_length)
+    {
+      pruned.push_back(nt);
+    }
+  }
+
+  return std::make_shared<vital::feature_track_set>(pruned);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
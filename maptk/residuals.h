@@ -0,0 +1,158 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk reprojection residual analysis functions
+ */
+
+#ifndef MAPTK_RESIDUALS_H_
+#define MAPTK_RESIDUALS_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/types/camera_map.h>
+#include <vital/types/feature_track_set.h>
+#include <vital/types/landmark_map.h>
+
+#include <map>
+#include <vector>
+
+
+namespace kwiver {
+namespace maptk {
+
+/// Accumulated reprojection errors of a group of observations
+struct MAPTK_EXPORT residual_summary
+{
+  residual_summary() : count(0), sum_squared(0.0), max_error(0.0) {}
+
+  /// Add the reprojection error of one observation
+  void add(double error);
+  /// Add the errors accumulated in another summary
+  void add(residual_summary const& other);
+  /// The root mean squared error, or 0 if there are no observations
+  double rmse() const;
+
+  /// the number of observations
+  size_t count;
+  /// the sum of the squared reprojection errors
+  double sum_squared;
+  /// the largest reprojection error
+  double max_error;
+};
+
+/// A single observation with a large reprojection error
+struct reprojection_outlier
+{
+  /// the track (and landmark) of the observation
+  vital::track_id_t track;
+  /// the frame (and camera) of the observation
+  vital::frame_id_t frame;
+  /// the reprojection error in pixels
+  double error;
+};
+
+/// Reprojection error statistics of a reconstruction
+struct reprojection_statistics
+{
+  /// errors of all observations
+  residual_summary total;
+  /// errors of the observations in each camera
+  std::map<vital::frame_id_t, residual_summary> cameras;
+  /// errors of the observations of each landmark
+  std::map<vital::track_id_t, residual_summary> tracks;
+
+  /// width of the histogram bins in pixels
+  double bin_width;
+  /// number of observations with errors in each bin; the last bin also
+  /// counts all errors beyond the end of the histogram
+  std::vector<size_t> histogram;
+
+  /// observations with errors above the outlier threshold, ordered by track
+  /// and then by frame; observations whose error is not finite are also
+  /// outliers, with an infinite error
+  std::vector<reprojection_outlier> outliers;
+  /// number of observations whose error is not finite (e.g. with degenerate
+  /// cameras), which are left out of all other statistics
+  size_t invalid;
+};
+
+/// Compute reprojection error statistics in a single parallel pass
+/**
+ * Each track state with both a camera and a landmark is projected once, and
+ * its error is accumulated into the total, per-camera, per-track and
+ * histogram statistics.  The tracks are processed concurrently, but the
+ * results are merged in a fixed order and do not depend on scheduling.
+ *
+ *  \param [in] cameras the cameras viewing the landmarks, indexed by frame
+ *  \param [in] landmarks the landmarks, indexed by track id
+ *  \param [in] tracks the feature tracks observing the landmarks
+ *  \param [in] outlier_threshold observations with errors above this are
+ *              reported as outliers; a value of 0 or less reports none
+ *  \param [in] bin_width the width of the histogram bins in pixels
+ *  \param [in] num_bins the number of histogram bins
+ *  \return the reprojection statistics
+ */
+MAPTK_EXPORT
+reprojection_statistics
+compute_reprojection_statistics(
+  vital::camera_map::map_camera_t const& cameras,
+  vital::landmark_map::map_landmark_t const& landmarks,
+  std::vector<vital::track_sptr> const& tracks,
+  double outlier_threshold = 0.0,
+  double bin_width = 0.5,
+  unsigned num_bins = 20);
+
+/// Remove outlier observations from a set of tracks
+/**
+ * The tracks containing outliers are replaced by copies without the outlier
+ * states, and those left with fewer than \p min_track_length states are
+ * dropped.  Tracks without outliers are shared with the input set, whatever
+ * their length.
+ *
+ *  \param [in] tracks the feature tracks to prune
+ *  \param [in] outliers the observations to remove, ordered by track and
+ *              then by frame as produced by compute_reprojection_statistics()
+ *  \param [in] min_track_length the minimum number of states to keep a
+ *              track that had outliers removed
+ *  \return the pruned track set
+ */
+MAPTK_EXPORT
+vital::feature_track_set_sptr
+remove_outliers(vital::feature_track_set const& tracks,
+                std::vector<reprojection_outlier> const& outliers,
+                size_t min_track_length = 2);
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_RESIDUALS_H_
@@ -0,0 +1,986 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::track_features_klt
+ */
+
+#include "track_features_klt.h"
+
+#include <maptk/parallel.h>
+#include <maptk/point_grid.h>
+
+#include <vital/algo/close_loops.h>
+#include <vital/algo/detect_features.h>
+#include <vital/algo/extract_descriptors.h>
+#include <vital/algo/feature_descriptor_io.h>
+#include <vital/exceptions/algorithm.h>
+#include <vital/exceptions/image.h>
+#include <vital/logger/logger.h>
+#include <vital/types/feature_set.h>
+#include <vital/types/image_container.h>
+#include <vital/video_metadata/video_metadata_util.h>
+
+#include <kwiversys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using namespace kwiver::vital;
+
+typedef kwiversys::SystemTools ST;
+
+namespace kwiver {
+namespace maptk {
+
+namespace {
+
+/// Single channel floating point image
+struct gray_image
+{
+  gray_image() : width(0), height(0) {}
+
+  /// Bilinear interpolation, clamped at the image border
+  float sample(double x, double y) const
+  {
+    x = std::min(std::max(x, 0.0), width - 1.001);
+    y = std::min(std::max(y, 0.0), height - 1.001);
+    auto const x0 = static_cast<int>(x);
+    auto const y0 = static_cast<int>(y);
+    auto const fx = static_cast<float>(x - x0);
+    auto const fy = static_cast<float>(y - y0);
+    auto const* const p = data.data() + y0 * width + x0;
+    return (1.0f - fy) * ((1.0f - fx) * p[0] + fx * p[1]) +
+           fy * ((1.0f - fx) * p[width] + fx * p[width + 1]);
+  }
+
+  int width;
+  int height;
+  std::vector<float> data;
+};
+
+typedef std::vector<gray_image> pyramid;
+
+
+/// Convert an image to gray levels, multiplying pixel values by \p scale
+template <typename T>
+gray_image
+to_gray(image_of<T> const& img, float scale)
+{
+  gray_image result;
+  result.width = static_cast<int>(img.width());
+  result.height = static_cast<int>(img.height());
+  result.data.resize(img.width() * img.height());
+
+  auto const channels = img.depth();
+  auto const ws = img.w_step();
+  auto const hs = img.h_step();
+  auto const ds = img.d_step();
+  auto* out = result.data.data();
+  for (size_t y = 0; y < img.height(); ++y)
+  {
+    auto const* p = img.first_pixel() + static_cast<ptrdiff_t>(y) * hs;
+    for (size_t x = 0; x < img.width(); ++x, p += ws)
+    {
+      *out++ = (channels >= 3
+                ? 0.299f * static_cast<float>(p[0]) +
+                  0.587f * static_cast<float>(p[ds]) +
+                  0.114f * static_cast<float>(p[2 * ds])
+                : static_cast<float>(p[0])) * scale;
+    }
+  }
+  return result;
+}
+
+
+/// Convert an image to gray levels in [0, 1]
+/**
+ * Unsigned integer pixels are scaled by the largest value of their type;
+ * floating point pixels are taken to be in [0, 1] already.  An empty image
+ * is returned for other pixel types.
+ */
+gray_image
+to_gray(image const& img)
+{
+  auto const& traits = img.pixel_traits();
+  if (traits == image_pixel_traits_of<uint8_t>())
+  {
+    return to_gray(image_of<uint8_t>(img), 1.0f / 255.0f);
+  }
+  if (traits == image_pixel_traits_of<uint16_t>())
+  {
+    return to_gray(image_of<uint16_t>(img), 1.0f / 65535.0f);
+  }
+  if (traits == image_pixel_traits_of<float>())
+  {
+    return to_gray(image_of<float>(img), 1.0f);
+  }
+  if (traits == image_pixel_traits_of<double>())
+  {
+    return to_gray(image_of<double>(img), 1.0f);
+  }
+  return gray_image();
+}
+
+
+/// Build an image pyramid by repeated 2x2 averaging
+pyramid
+build_pyramid(gray_image base, unsigned levels, int min_size)
+{
+  pyramid result;
+  result.push_back(std::move(base));
+  while (result.size() < levels &&
+         result.back().width / 2 >= min_size &&
+         result.back().height / 2 >= min_size)
+  {
+    auto const& in = result.back();
+    gray_image out;
+    out.width = in.width / 2;
+    out.height = in.height / 2;
+    out.data.resize(static_cast<size_t>(out.width * out.height));
+    for (int y = 0; y < out.height; ++y)
+    {
+      auto const* r0 = in.data.data() + (2 * y) * in.width;
+      auto const* r1 = r0 + in.width;
+      auto* o = out.data.data() + y * out.width;
+      for (int x = 0; x < out.width; ++x)
+      {
+        o[x] = 0.25f * (r0[2 * x] + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1]);
+      }
+    }
+    result.push_back(std::move(out));
+  }
+  return result;
+}
+
+
+/// Clear the pixels of a detection mask which another mask excludes
+template <typename T>
+void
+apply_mask(image_of<uint8_t>& cells, image const& mask)
+{
+  image_of<T> const m(mask);
+  for (size_t y = 0; y < cells.height(); ++y)
+  {
+    for (size_t x = 0; x < cells.width(); ++x)
+    {
+      if (!m(x, y))
+      {
+        cells(x, y) = 0;
+      }
+    }
+  }
+}
+
+
+/// A feature being followed from frame to frame
+struct tracked_point
+{
+  track_sptr track;
+  feature_sptr feature;
+  descriptor_sptr descriptor;
+};
+
+} // end anonymous namespace
+
+
+/// Private implementation class
+class track_features_klt::priv
+{
+public:
+  /// Constructor
+  priv()
+    : pyramid_levels(3),
+      window_radius(7),
+      max_iterations(10),
+      min_eigenvalue(1e-5),
+      fb_threshold(1.0),
+      grid_rows(8),
+      grid_cols(8),
+      min_features_per_cell(2),
+      max_features_per_cell(20),
+      min_distance(3.0),
+      keyframe_interval(30),
+      min_tracked_fraction(0.5),
+      prev_frame(0),
+      last_keyframe(0),
+      keyframe_count(0),
+      next_track_id(0)
+  {
+  }
+
+  /// Follow a point from one pyramid to another
+  /**
+   * \p to holds the initial guess and receives the result.
+   */
+  bool flow(pyramid const& from_pyr, pyramid const& to_pyr,
+            vector_2d const& from, vector_2d& to,
+            std::vector<float>& scratch) const;
+
+  /// Follow the active points into a new frame; lost points are removed
+  void propagate(pyramid const& next);
+
+  /// Grid cell containing a location
+  size_t cell(vector_2d const& p, size_t width, size_t height) const
+  {
+    auto const cx = std::min<size_t>(
+      grid_cols - 1, static_cast<size_t>(std::max(0.0, p.x()) * grid_cols /
+                                         width));
+    auto const cy = std::min<size_t>(
+      grid_rows - 1, static_cast<size_t>(std::max(0.0, p.y()) * grid_rows /
+                                         height));
+    return cy * grid_cols + cx;
+  }
+
+  /// Make a detection mask covering the given grid cells
+  image_container_sptr
+  cell_mask(std::vector<char> const& cells, size_t width, size_t height,
+            image_container_sptr mask) const;
+
+  /// Get the features file of a frame, or an empty path if not used
+  path_t feature_file(image_container_sptr image, frame_id_t frame) const;
+
+  /// Detect and describe features, or load them from the features file
+  void detect(image_container_sptr image, image_container_sptr mask,
+              std::vector<char> const& cells, bool keyframe,
+              frame_id_t frame, feature_set_sptr& features,
+              descriptor_set_sptr& descriptors) const;
+
+  /// Update the track of each active point after loop closure
+  void update_tracks(feature_track_set const& tracks, frame_id_t frame);
+
+  /// number of pyramid levels used by the optical flow
+  unsigned pyramid_levels;
+  /// half size of the optical flow window
+  int window_radius;
+  /// maximum number of optical flow iterations per level
+  unsigned max_iterations;
+  /// minimum eigenvalue of the window's structure tensor
+  double min_eigenvalue;
+  /// maximum forward-backward flow error, in pixels
+  double fb_threshold;
+  /// number of rows of the detection grid
+  unsigned grid_rows;
+  /// number of columns of the detection grid
+  unsigned grid_cols;
+  /// cells with fewer tracked features are detected in
+  unsigned min_features_per_cell;
+  /// no features are added to cells with this many
+  unsigned max_features_per_cell;
+  /// detections closer than this to a tracked feature are the same feature
+  double min_distance;
+  /// maximum number of frames between keyframes
+  unsigned keyframe_interval;
+  /// fraction of the features of the last keyframe below which to detect
+  double min_tracked_fraction;
+  /// path to the feature and descriptor files
+  path_t features_dir;
+
+  /// the feature detector algorithm
+  algo::detect_features_sptr detector;
+  /// the descriptor extractor algorithm
+  algo::extract_descriptors_sptr extractor;
+  /// the loop closure algorithm (optional)
+  algo::close_loops_sptr closer;
+  /// the feature and descriptor I/O algorithm (optional)
+  algo::feature_descriptor_io_sptr feature_io;
+  /// logger handle
+  vital::logger_handle_t m_logger;
+
+  /// features being followed
+  std::vector<tracked_point> active;
+  /// locations of the active features in the current frame
+  std::vector<vector_2d> locations;
+  /// pyramid of the previous frame
+  pyramid prev_pyramid;
+  /// the previous frame number
+  frame_id_t prev_frame;
+  /// the last keyframe number
+  frame_id_t last_keyframe;
+  /// number of active features after the last keyframe
+  size_t keyframe_count;
+  /// the next track id to assign
+  track_id_t next_track_id;
+};
+
+
+// ----------------------------------------------------------------------------
+bool
+track_features_klt::priv
+::flow(pyramid const& from_pyr, pyramid const& to_pyr,
+       vector_2d const& from, vector_2d& to,
+       std::vector<float>& scratch) const
+{
+  auto const r = window_radius;
+  auto const n = static_cast<size_t>((2 * r + 1) * (2 * r + 1));
+  scratch.resize(3 * n);
+  auto* const patch = scratch.data();
+  auto* const gx = patch + n;
+  auto* const gy = gx + n;
+
+  auto const levels = static_cast<int>(std::min(from_pyr.size(),
+                                                to_pyr.size()));
+  vector_2d v = (to - from) / static_cast<double>(1 << (levels - 1));
+  for (int level = levels - 1; level >= 0; --level)
+  {
+    auto const& img0 = from_pyr[level];
+    auto const& img1 = to_pyr[level];
+    vector_2d const p = from / static_cast<double>(1 << level);
+
+    // Sample the window and its gradient in the first image
+    double gxx = 0.0, gxy = 0.0, gyy = 0.0;
+    size_t k = 0;
+    for (int dy = -r; dy <= r; ++dy)
+    {
+      for (int dx = -r; dx <= r; ++dx, ++k)
+      {
+        auto const x = p.x() + dx;
+        auto const y = p.y() + dy;
+        patch[k] = img0.sample(x, y);
+        gx[k] = 0.5f * (img0.sample(x + 1.0, y) - img0.sample(x - 1.0, y));
+        gy[k] = 0.5f * (img0.sample(x, y + 1.0) - img0.sample(x, y - 1.0));
+        gxx += gx[k] * gx[k];
+        gxy += gx[k] * gy[k];
+        gyy += gy[k] * gy[k];
+      }
+    }
+
+    // Reject windows without texture in two directions
+    auto const det = gxx * gyy - gxy * gxy;
+    auto const min_eig =
+      0.5 * (gxx + gyy - std::sqrt((gxx - gyy) * (gxx - gyy) +
+                                   4.0 * gxy * gxy)) / n;
+    if (min_eig < min_eigenvalue || det <= 0.0)
+    {
+      return false;
+    }
+
+    for (unsigned iter = 0; iter < max_iterations; ++iter)
+    {
+      double bx = 0.0, by = 0.0;
+      k = 0;
+      for (int dy = -r; dy <= r; ++dy)
+      {
+        for (int dx = -r; dx <= r; ++dx, ++k)
+        {
+          auto const diff =
+            patch[k] - img1.sample(p.x() + v.x() + dx, p.y() + v.y() + dy);
+          bx += diff * gx[k];
+          by += diff * gy[k];
+        }
+      }
+
+      vector_2d const delta((gyy * bx - gxy * by) / det,
+                            (gxx * by - gxy * bx) / det);
+      v += delta;
+      if (delta.squaredNorm() < 1e-4)
+      {
+        break;
+      }
+    }
+
+    if (level > 0)
+    {
+      v *= 2.0;
+    }
+  }
+
+  to = from + v;
+  auto const& base = to_pyr.front();
+  return to.x() >= 0.0 && to.y() >= 0.0 &&
+         to.x() <= base.width - 1.0 && to.y() <= base.height - 1.0;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+track_features_klt::priv
+::propagate(pyramid const& next)
+{
+  std::vector<char> found(this->active.size(), 0);
+  std::vector<vector_2d> moved(this->locations);
+  parallel_for(this->active.size(), [&](size_t begin, size_t end){
+    std::vector<float> scratch;
+    for (auto i = begin; i < end; ++i)
+    {
+      if (!this->flow(this->prev_pyramid, next, this->locations[i],
+                      moved[i], scratch))
+      {
+        continue;
+      }
+
+      // Check that the flow leads back to where it started
+      if (fb_threshold > 0.0)
+      {
+        vector_2d back = this->locations[i];
+        if (!this->flow(next, this->prev_pyramid, moved[i], back, scratch) ||
+            (back - this->locations[i]).squaredNorm() >
+              fb_threshold * fb_threshold)
+        {
+          continue;
+        }
+      }
+      found[i] = 1;
+    }
+  }, 64);
+
+  size_t kept = 0;
+  for (size_t i = 0; i < this->active.size(); ++i)
+  {
+    if (found[i])
+    {
+      this->active[kept] = std::move(this->active[i]);
+      this->locations[kept] = moved[i];
+      ++kept;
+    }
+  }
+  this->active.resize(kept);
+  this->locations.resize(kept);
+}
+
+
+// ----------------------------------------------------------------------------
+image_container_sptr
+track_features_klt::priv
+::cell_mask(std::vector<char> const& cells, size_t width, size_t height,
+            image_container_sptr mask) const
+{
+  image_of<uint8_t> result(width, height, 1);
+  for (size_t y = 0; y < height; ++y)
+  {
+    for (size_t x = 0; x < width; ++x)
+    {
+      auto const c = this->cell(vector_2d(x, y), width, height);
+      result(x, y) = (cells[c] ? 255 : 0);
+    }
+  }
+
+  if (mask)
+  {
+    auto const& m = mask->get_image();
+    if (m.width() != width || m.height() != height)
+    {
+      throw image_size_mismatch_exception(
+        "Mask image must be the same size as the input image",
+        width, height, m.width(), m.height());
+    }
+    if (m.pixel_traits() == image_pixel_traits_of<bool>())
+    {
+      apply_mask<bool>(result, m);
+    }
+    else
+    {
+      apply_mask<uint8_t>(result, m);
+    }
+  }
+
+  return std::make_shared<simple_image_container>(result);
+}
+
+
+// ----------------------------------------------------------------------------
+path_t
+track_features_klt::priv
+::feature_file(image_container_sptr image, frame_id_t frame) const
+{
+  if (!this->feature_io || this->features_dir.empty())
+  {
+    return path_t();
+  }
+
+  auto const basename = basename_from_metadata(image->get_metadata(), frame);
+  return this->features_dir + "/" + basename + ".kwfd";
+}
+
+
+// ----------------------------------------------------------------------------
+void
+track_features_klt::priv
+::detect(image_container_sptr image, image_container_sptr mask,
+         std::vector<char> const& cells, bool keyframe, frame_id_t frame,
+         feature_set_sptr& features, descriptor_set_sptr& descriptors) const
+{
+  // Reuse full frame detections from a previous run, if available
+  auto const kwfd_file = this->feature_file(image, frame);
+  if (!kwfd_file.empty() && ST::FileExists(kwfd_file))
+  {
+    this->feature_io->load(kwfd_file, features, descriptors);
+    return;
+  }
+
+  // Only detect in the cells which need features, except on keyframes
+  auto const detect_mask =
+    (keyframe ? mask : this->cell_mask(cells, image->width(),
+                                       image->height(), mask));
+  features = this->detector->detect(image, detect_mask);
+  descriptors = this->extractor->extract(image, features, mask);
+
+  // Only full frame detections are saved, since partial ones would be
+  // mistaken for complete feature files by other tools
+  if (keyframe && !kwfd_file.empty())
+  {
+    auto const fd_dir = ST::GetFilenamePath(kwfd_file);
+    if (!ST::FileIsDirectory(fd_dir) && !ST::MakeDirectory(fd_dir))
+    {
+      LOG_ERROR(m_logger, "Unable to create directory: " << fd_dir);
+      return;
+    }
+    this->feature_io->save(kwfd_file, features, descriptors);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+void
+track_features_klt::priv
+::update_tracks(feature_track_set const& tracks, frame_id_t frame)
+{
+  // Loop closure may merge tracks, so find the track now holding each
+  // active feature
+  std::unordered_map<feature const*, track_sptr> owners;
+  for (auto const& t : tracks.active_tracks(frame))
+  {
+    auto const s = t->find(frame);
+    if (s == t->end())
+    {
+      continue;
+    }
+    auto const fts = std::dynamic_pointer_cast<feature_track_state>(*s);
+    if (fts && fts->feature)
+    {
+      owners[fts->feature.get()] = t;
+    }
+  }
+
+  for (auto& a : this->active)
+  {
+    auto const o = owners.find(a.feature.get());
+    if (o != owners.end())
+    {
+      a.track = o->second;
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+track_features_klt
+::track_features_klt()
+  : d_(new priv)
+{
+  attach_logger( "track_features_klt" );
+  d_->m_logger = this->logger();
+}
+
+
+// ----------------------------------------------------------------------------
+track_features_klt
+::~track_features_klt() VITAL_NOTHROW
+{
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+track_features_klt
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  // Sub-algorithm implementation name + sub_config block
+  // - Feature Detector algorithm
+  algo::detect_features::get_nested_algo_configuration(
+    "feature_detector", config, d_->detector);
+
+  // - Descriptor Extractor algorithm
+  algo::extract_descriptors::get_nested_algo_configuration(
+    "descriptor_extractor", config, d_->extractor);
+
+  // - Loop closure algorithm
+  algo::close_loops::get_nested_algo_configuration(
+    "loop_closer", config, d_->closer);
+
+  // - Feature/Descriptor IO algorithm
+  algo::feature_descriptor_io::get_nested_algo_configuration(
+    "feature_io", config, d_->feature_io);
+
+  config->set_value("features_dir", d_->features_dir,
+                    "Path to a directory in which to read or write the "
+                    "feature detection and description files.  Only full "
+                    "frame detections (on keyframes) are written.  Using "
+                    "this directory requires a feature_io algorithm.");
+  config->set_value("pyramid_levels", d_->pyramid_levels,
+                    "The number of image pyramid levels used by the optical "
+                    "flow.  Each level allows roughly twice the motion.");
+  config->set_value("window_radius", d_->window_radius,
+                    "Half of the size of the optical flow window, in pixels.");
+  config->set_value("max_iterations", d_->max_iterations,
+                    "The maximum number of optical flow iterations at each "
+                    "pyramid level.");
+  config->set_value("min_eigenvalue", d_->min_eigenvalue,
+                    "The minimum eigenvalue of the gradient structure tensor "
+                    "of a window, normalized by the window area, for a "
+                    "feature to be tracked.  Features in windows without "
+                    "enough texture are dropped.");
+  config->set_value("fb_threshold", d_->fb_threshold,
+                    "The maximum distance (in pixels) between a feature and "
+                    "the result of tracking it forward and back again.  A "
+                    "value of 0 disables the check.");
+  config->set_value("grid_rows", d_->grid_rows,
+                    "The number of rows of the grid used to decide where to "
+                    "detect new features.");
+  config->set_value("grid_cols", d_->grid_cols,
+                    "The number of columns of the grid used to decide where "
+                    "to detect new features.");
+  config->set_value("min_features_per_cell", d_->min_features_per_cell,
+                    "New features are detected in grid cells with fewer "
+                    "tracked features than this.");
+  config->set_value("max_features_per_cell", d_->max_features_per_cell,
+                    "New features are not added to grid cells with this many "
+                    "features.");
+  config->set_value("min_distance", d_->min_distance,
+                    "Detections closer than this distance (in pixels) to a "
+                    "tracked feature are considered to be that feature.");
+  config->set_value("keyframe_interval", d_->keyframe_interval,
+                    "The maximum number of frames between keyframes, on which "
+                    "features are detected on the whole frame.");
+  config->set_value("min_tracked_fraction", d_->min_tracked_fraction,
+                    "A keyframe is also made when fewer than this fraction of "
+                    "the features of the last keyframe are still tracked.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+track_features_klt
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  // Setting nested algorithm instances via setter methods instead of directly
+  // assigning to instance property.
+  algo::detect_features::set_nested_algo_configuration(
+    "feature_detector", config, d_->detector);
+  algo::extract_descriptors::set_nested_algo_configuration(
+    "descriptor_extractor", config, d_->extractor);
+  algo::close_loops::set_nested_algo_configuration(
+    "loop_closer", config, d_->closer);
+  algo::feature_descriptor_io::set_nested_algo_configuration(
+    "feature_io", config, d_->feature_io);
+
+  d_->features_dir = config->get_value<path_t>("features_dir");
+  d_->pyramid_levels = config->get_value<unsigned>("pyramid_levels");
+  d_->window_radius = config->get_value<int>("window_radius");
+  d_->max_iterations = config->get_value<unsigned>("max_iterations");
+  d_->min_eigenvalue = config->get_value<double>("min_eigenvalue");
+  d_->fb_threshold = config->get_value<double>("fb_threshold");
+  d_->grid_rows = config->get_value<unsigned>("grid_rows");
+  d_->grid_cols = config->get_value<unsigned>("grid_cols");
+  d_->min_features_per_cell =
+    config->get_value<unsigned>("min_features_per_cell");
+  d_->max_features_per_cell =
+    config->get_value<unsigned>("max_features_per_cell");
+  d_->min_distance = config->get_value<double>("min_distance");
+  d_->keyframe_interval = config->get_value<unsigned>("keyframe_interval");
+  d_->min_tracked_fraction = config->get_value<double>("min_tracked_fraction");
+
+  // Tracking starts over with the new configuration
+  d_->active.clear();
+  d_->locations.clear();
+  d_->prev_pyramid.clear();
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+track_features_klt
+::check_configuration(config_block_sptr config) const
+{
+  bool config_valid =
+    algo::detect_features::check_nested_algo_configuration(
+      "feature_detector", config) &&
+    algo::extract_descriptors::check_nested_algo_configuration(
+      "descriptor_extractor", config) &&
+    config->get_value<unsigned>("pyramid_levels") >= 1 &&
+    config->get_value<int>("window_radius") >= 1 &&
+    config->get_value<unsigned>("grid_rows") >= 1 &&
+    config->get_value<unsigned>("grid_cols") >= 1;
+
+  // these algorithms are optional
+  if (config->get_value<std::string>("loop_closer:type", "") != "")
+  {
+    config_valid = config_valid &&
+      algo::close_loops::check_nested_algo_configuration(
+        "loop_closer", config);
+  }
+  if (config->get_value<std::string>("feature_io:type", "") != "")
+  {
+    config_valid = config_valid &&
+      algo::feature_descriptor_io::check_nested_algo_configuration(
+        "feature_io", config);
+  }
+
+  return config_valid;
+}
+
+
+// ----------------------------------------------------------------------------
+feature_track_set_sptr
+track_features_klt
+::track(feature_track_set_sptr prev_tracks,
+        unsigned int frame_number,
+        image_container_sptr image_data,
+        image_container_sptr mask) const
+{
+  // verify that all dependent algorithms have been initialized
+  if( !d_->detector || !d_->extractor )
+  {
+    // Something did not initialize
+    throw vital::algorithm_configuration_exception(
+      this->type_name(), this->impl_name(),
+      "not all sub-algorithms have been initialized");
+  }
+
+  auto const width = image_data->width();
+  auto const height = image_data->height();
+  auto const frame = static_cast<frame_id_t>(frame_number);
+
+  auto gray = to_gray(image_data->get_image());
+  if (gray.data.empty() && width * height > 0)
+  {
+    auto const& traits = image_data->get_image().pixel_traits();
+    std::ostringstream msg;
+    msg << "unsupported pixel type " << static_cast<int>(traits.type) << " of "
+        << traits.num_bytes << " bytes; images must be 8-bit or 16-bit "
+        << "unsigned integer, or floating point";
+    throw vital::image_type_mismatch_exception(msg.str());
+  }
+
+  auto next = build_pyramid(std::move(gray), d_->pyramid_levels,
+                            2 * d_->window_radius + 1);
+
+  // Continue only if the tracks are the ones this tracker last returned
+  auto const continuing =
+    prev_tracks && !d_->prev_pyramid.empty() &&
+    prev_tracks->last_frame() == d_->prev_frame && frame > d_->prev_frame;
+  if (continuing)
+  {
+    d_->propagate(next);
+  }
+  else
+  {
+    d_->active.clear();
+    d_->locations.clear();
+    d_->next_track_id = 0;
+    if (prev_tracks)
+    {
+      for (auto const& t : prev_tracks->tracks())
+      {
+        d_->next_track_id = std::max(d_->next_track_id, t->id() + 1);
+      }
+    }
+  }
+
+  // Find the grid cells which need new features
+  auto const num_cells = static_cast<size_t>(d_->grid_rows * d_->grid_cols);
+  std::vector<unsigned> counts(num_cells, 0);
+  for (auto const& p : d_->locations)
+  {
+    ++counts[d_->cell(p, width, height)];
+  }
+
+  auto const keyframe =
+    !continuing ||
+    frame - d_->last_keyframe >=
+      static_cast<frame_id_t>(d_->keyframe_interval) ||
+    d_->active.size() < d_->min_tracked_fraction * d_->keyframe_count;
+
+  std::vector<char> sparse(num_cells, 0);
+  auto detecting = keyframe;
+  for (size_t c = 0; c < num_cells; ++c)
+  {
+    sparse[c] = (counts[c] < d_->min_features_per_cell);
+    detecting = detecting || sparse[c];
+  }
+
+  std::vector<tracked_point> added;
+  std::vector<vector_2d> added_locations;
+  if (detecting)
+  {
+    feature_set_sptr features;
+    descriptor_set_sptr descriptors;
+    d_->detect(image_data, mask, sparse, keyframe, frame,
+               features, descriptors);
+
+    auto const& feat = features ? features->features()
+                                : std::vector<feature_sptr>();
+    auto const& desc = descriptors ? descriptors->descriptors()
+                                   : std::vector<descriptor_sptr>();
+    if (feat.size() != desc.size())
+    {
+      LOG_WARN(d_->m_logger, "Feature and descriptor counts differ on frame "
+                             << frame << ", no features added");
+    }
+    else
+    {
+      // Strongest detections first
+      std::vector<size_t> order(feat.size());
+      for (size_t i = 0; i < order.size(); ++i)
+      {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [&feat](size_t a, size_t b){
+        return feat[a]->magnitude() > feat[b]->magnitude();
+      });
+
+      point_grid const grid(d_->locations, std::max(d_->min_distance, 1.0));
+      std::vector<char> refreshed(d_->active.size(), 0);
+      auto const min_dist_sq = d_->min_distance * d_->min_distance;
+      for (auto const i : order)
+      {
+        auto const& loc = feat[i]->loc();
+
+        // Find the nearest tracked feature
+        auto nearest = -1;
+        auto nearest_dist = min_dist_sq;
+        grid.query(loc, d_->min_distance, [&](unsigned j){
+          auto const d = (d_->locations[j] - loc).squaredNorm();
+          if (d <= nearest_dist)
+          {
+            nearest_dist = d;
+            nearest = static_cast<int>(j);
+          }
+        });
+
+        if (nearest >= 0)
+        {
+          // On keyframes, the detection refreshes the tracked feature
+          if (keyframe && !refreshed[nearest])
+          {
+            d_->active[nearest].feature = feat[i];
+            d_->active[nearest].descriptor = desc[i];
+            d_->locations[nearest] = loc;
+            refreshed[nearest] = 1;
+          }
+          continue;
+        }
+
+        auto const c = d_->cell(loc, width, height);
+        if (!sparse[c] && !keyframe)
+        {
+          continue;
+        }
+        if (counts[c] >= d_->max_features_per_cell)
+        {
+          continue;
+        }
+        ++counts[c];
+
+        auto t = track::create();
+        t->set_id(d_->next_track_id++);
+        added.push_back(tracked_point{t, feat[i], desc[i]});
+        added_locations.push_back(loc);
+      }
+    }
+  }
+
+  // Add the states of the current frame
+  for (size_t i = 0; i < d_->active.size(); ++i)
+  {
+    auto& a = d_->active[i];
+    if (a.feature->loc() != d_->locations[i])
+    {
+      auto const moved = std::make_shared<feature_d>(*a.feature);
+      moved->set_loc(d_->locations[i]);
+      a.feature = moved;
+    }
+    a.track->append(
+      std::make_shared<feature_track_state>(frame, a.feature, a.descriptor));
+  }
+
+  std::vector<track_sptr> all_tracks;
+  if (prev_tracks)
+  {
+    all_tracks = prev_tracks->tracks();
+  }
+  for (auto& a : added)
+  {
+    a.track->append(
+      std::make_shared<feature_track_state>(frame, a.feature, a.descriptor));
+    all_tracks.push_back(a.track);
+    d_->active.push_back(std::move(a));
+  }
+  d_->locations.insert(d_->locations.end(),
+                       added_locations.begin(), added_locations.end());
+
+  LOG_DEBUG(d_->m_logger, "Frame " << frame << ": "
+                          << d_->active.size() - added.size()
+                          << " features tracked, " << added.size()
+                          << " added" << (keyframe ? " (keyframe)" : ""));
+
+  if (keyframe)
+  {
+    d_->last_keyframe = frame;
+    d_->keyframe_count = d_->active.size();
+  }
+  d_->prev_frame = frame;
+  d_->prev_pyramid.swap(next);
+
+  auto tracks = std::make_shared<feature_track_set>(all_tracks);
+
+  // run loop closure if enabled
+  if (d_->closer)
+  {
+    auto const closed = d_->closer->stitch(frame, tracks, image_data, mask);
+    if (closed != tracks)
+    {
+      d_->update_tracks(*closed, frame);
+    }
+    tracks = closed;
+  }
+
+  return tracks;
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,121 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::track_features_klt
+ */
+
+#ifndef MAPTK_TRACK_FEATURES_KLT_H_
+#define MAPTK_TRACK_FEATURES_KLT_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/algo/algorithm.h>
+#include <vital/algo/track_features.h>
+#include <vital/config/config_block.h>
+
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Feature tracking by pyramidal Lucas-Kanade optical flow
+/**
+ * This class follows the features of the previous frame into the current
+ * frame with pyramidal Lucas-Kanade optical flow, rather than detecting,
+ * describing and matching features on every frame.  The image is divided
+ * into a grid, and new features are only detected and described in cells
+ * where too few features survived.  On keyframes, which occur periodically
+ * or when many features have been lost, features are detected on the whole
+ * frame; detections coinciding with tracked features refresh their location
+ * and descriptor, and the rest start new tracks.
+ *
+ * Tracked features carry the descriptor of their last detection, so the
+ * track set remains usable by the loop closer.  Full frame detections are
+ * read from and written to the features directory in the same way as the
+ * core tracker, so existing feature files are reused.
+ */
+class MAPTK_EXPORT track_features_klt
+  : public vital::algorithm_impl<track_features_klt,
+                                 vital::algo::track_features>
+{
+public:
+  /// Default Constructor
+  track_features_klt();
+
+  /// Destructor
+  virtual ~track_features_klt() VITAL_NOTHROW;
+
+  /// Get this algorithm's \link vital::config_block configuration block \endlink
+  virtual vital::config_block_sptr get_configuration() const;
+  /// Set this algorithm's properties via a config block
+  virtual void set_configuration(vital::config_block_sptr config);
+  /// Check that the algorithm's currently configuration is valid
+  virtual bool check_configuration(vital::config_block_sptr config) const;
+
+  /// Extend a previous set of feature tracks using the current frame
+  /**
+   * \throws image_size_mismatch_exception
+   *    When the given non-zero mask image does not match the size of the
+   *    dimensions of the given image data.
+   * \throws image_type_mismatch_exception
+   *    When the image pixels are not 8-bit or 16-bit unsigned integers or
+   *    floating point values (which are taken to be in [0, 1]).
+   *
+   * \param [in] prev_tracks the feature tracks from previous tracking steps
+   * \param [in] frame_number the frame number of the current frame
+   * \param [in] image_data the image pixels for the current frame
+   * \param [in] mask Optional mask image that uses positive values to denote
+   *                  regions of the input image to consider for feature
+   *                  tracking. An empty sptr indicates no mask (default
+   *                  value).
+   * \returns an updated set of feature tracks including the current frame
+   */
+  virtual vital::feature_track_set_sptr
+  track(vital::feature_track_set_sptr prev_tracks,
+        unsigned int frame_number,
+        vital::image_container_sptr image_data,
+        vital::image_container_sptr mask = vital::image_container_sptr()) const;
+
+private:
+  /// private implementation class
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_TRACK_FEATURES_KLT_H_
@@ -0,0 +1,252 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::triangulate_landmarks_parallel
+ */
+
+#include "triangulate_landmarks_parallel.h"
+
+#include <maptk/parallel.h>
+
+#include <vital/exceptions/algorithm.h>
+#include <vital/logger/logger.h>
+#include <vital/types/landmark_map.h>
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace kwiver::vital;
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Private implementation class
+class triangulate_landmarks_parallel::priv
+{
+public:
+  /// Constructor
+  priv()
+    : min_chunk_size(256),
+      max_chunks(0)
+  {
+  }
+
+  /// Number of chunks to use for a number of landmarks
+  size_t num_chunks(size_t count) const
+  {
+    auto const limit = std::min(this->triangulators.size(),
+                                (count + min_chunk_size - 1) / min_chunk_size);
+    return std::max<size_t>(1, limit);
+  }
+
+  /// minimum number of landmarks in a chunk
+  unsigned min_chunk_size;
+  /// maximum number of chunks, or 0 to use one per hardware thread
+  unsigned max_chunks;
+
+  /// one nested triangulator per chunk
+  std::vector<vital::algo::triangulate_landmarks_sptr> triangulators;
+  /// logger handle
+  vital::logger_handle_t m_logger;
+};
+
+
+// ----------------------------------------------------------------------------
+triangulate_landmarks_parallel
+::triangulate_landmarks_parallel()
+  : d_(new priv)
+{
+  attach_logger( "triangulate_landmarks_parallel" );
+  d_->m_logger = this->logger();
+}
+
+
+// ----------------------------------------------------------------------------
+triangulate_landmarks_parallel
+::~triangulate_landmarks_parallel() VITAL_NOTHROW
+{
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+triangulate_landmarks_parallel
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  // Sub-algorithm implementation name + sub_config block
+  algo::triangulate_landmarks::get_nested_algo_configuration(
+    "triangulator", config,
+    d_->triangulators.empty() ? algo::triangulate_landmarks_sptr()
+                              : d_->triangulators.front());
+
+  config->set_value("min_chunk_size", d_->min_chunk_size,
+                    "The minimum number of landmarks triangulated by each "
+                    "instance of the nested triangulator.  Smaller maps use "
+                    "fewer chunks.");
+  config->set_value("max_chunks", d_->max_chunks,
+                    "The maximum number of chunks triangulated concurrently. "
+                    "A value of 0 uses one chunk per hardware thread.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+triangulate_landmarks_parallel
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  d_->min_chunk_size =
+    std::max(1u, config->get_value<unsigned>("min_chunk_size"));
+  d_->max_chunks = config->get_value<unsigned>("max_chunks");
+
+  // Create an independent instance of the nested algorithm for each chunk,
+  // so that implementations which are not reentrant may still be used
+  auto const count = (d_->max_chunks ? d_->max_chunks
+                      : std::max(1u, std::thread::hardware_concurrency()));
+  d_->triangulators.resize(count);
+  for (auto& t : d_->triangulators)
+  {
+    algo::triangulate_landmarks::set_nested_algo_configuration(
+      "triangulator", config, t);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+triangulate_landmarks_parallel
+::check_configuration(config_block_sptr config) const
+{
+  return algo::triangulate_landmarks::check_nested_algo_configuration(
+    "triangulator", config);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+triangulate_landmarks_parallel
+::triangulate(camera_map_sptr cameras,
+              feature_track_set_sptr tracks,
+              landmark_map_sptr& landmarks) const
+{
+  if (d_->triangulators.empty() || !d_->triangulators.front())
+  {
+    throw vital::algorithm_configuration_exception(
+      this->type_name(), this->impl_name(),
+      "nested triangulator has not been initialized");
+  }
+
+  auto const& all_landmarks = landmarks->landmarks();
+  auto const chunks = d_->num_chunks(all_landmarks.size());
+  if (chunks < 2)
+  {
+    d_->triangulators.front()->triangulate(cameras, tracks, landmarks);
+    return;
+  }
+
+  // Index the tracks by id, which is also the landmark id
+  std::unordered_map<track_id_t, track_sptr> track_index;
+  for (auto const& t : tracks->tracks())
+  {
+    track_index.emplace(t->id(), t);
+  }
+
+  // Partition the landmarks, in id order, into chunks of (nearly) equal size,
+  // each with the tracks of its landmarks
+  std::vector<landmark_map_sptr> results(chunks);
+  std::vector<feature_track_set_sptr> chunk_tracks(chunks);
+  {
+    auto lmi = all_landmarks.begin();
+    for (size_t c = 0; c < chunks; ++c)
+    {
+      auto const end_index = all_landmarks.size() * (c + 1) / chunks;
+      auto const begin_index = all_landmarks.size() * c / chunks;
+
+      landmark_map::map_landmark_t subset;
+      std::vector<track_sptr> subset_tracks;
+      for (auto i = begin_index; i < end_index; ++i, ++lmi)
+      {
+        subset.insert(subset.end(), *lmi);
+        auto const t = track_index.find(lmi->first);
+        if (t != track_index.end())
+        {
+          subset_tracks.push_back(t->second);
+        }
+      }
+
+      results[c] = std::make_shared<simple_landmark_map>(subset);
+      chunk_tracks[c] = std::make_shared<feature_track_set>(subset_tracks);
+    }
+  }
+
+  // Triangulate the chunks concurrently
+  parallel_for(chunks, [&](size_t begin, size_t end){
+    for (auto c = begin; c < end; ++c)
+    {
+      d_->triangulators[c]->triangulate(cameras, chunk_tracks[c], results[c]);
+    }
+  }, 1);
+
+  // Merge the results in chunk order; chunks hold disjoint, increasing id
+  // ranges, so inserting at the end keeps the merge linear
+  landmark_map::map_landmark_t merged;
+  for (auto const& r : results)
+  {
+    for (auto const& lm : r->landmarks())
+    {
+      merged.insert(merged.end(), lm);
+    }
+  }
+
+  LOG_DEBUG(d_->m_logger, "Triangulated " << merged.size() << " of "
+                          << all_landmarks.size() << " landmarks in "
+                          << chunks << " chunks");
+
+  landmarks = std::make_shared<simple_landmark_map>(merged);
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
@@ -0,0 +1,104 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::triangulate_landmarks_parallel
+ */
+
+#ifndef MAPTK_TRIANGULATE_LANDMARKS_PARALLEL_H_
+#define MAPTK_TRIANGULATE_LANDMARKS_PARALLEL_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/algo/algorithm.h>
+#include <vital/algo/triangulate_landmarks.h>
+#include <vital/config/config_block.h>
+
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Proxy running another landmark triangulator in parallel
+/**
+ * This class partitions the landmark map into chunks of consecutive landmark
+ * ids and triangulates each chunk with its own instance of the nested
+ * triangulator, concurrently on the KWIVER thread pool.  Each chunk is given
+ * only the tracks of its landmarks; cameras, tracks and track states are
+ * shared read-only.  The results are merged in chunk order, so the output
+ * does not depend on the order in which the chunks finish.
+ */
+class MAPTK_EXPORT triangulate_landmarks_parallel
+  : public vital::algorithm_impl<triangulate_landmarks_parallel,
+                                 vital::algo::triangulate_landmarks>
+{
+public:
+  /// Default Constructor
+  triangulate_landmarks_parallel();
+
+  /// Destructor
+  virtual ~triangulate_landmarks_parallel() VITAL_NOTHROW;
+
+  /// Get this algorithm's \link vital::config_block configuration block \endlink
+  virtual vital::config_block_sptr get_configuration() const;
+  /// Set this algorithm's properties via a config block
+  virtual void set_configuration(vital::config_block_sptr config);
+  /// Check that the algorithm's currently configuration is valid
+  virtual bool check_configuration(vital::config_block_sptr config) const;
+
+  /// Triangulate the landmark locations given sets of cameras and tracks
+  /**
+   * \param [in] cameras the cameras viewing the landmarks
+   * \param [in] tracks the tracks to use as constraints
+   * \param [in,out] landmarks the landmarks to triangulate
+   *
+   * This function only triangulates the landmarks with indices in the
+   * landmark map and which have support in the tracks and cameras
+   */
+  virtual void
+  triangulate(vital::camera_map_sptr cameras,
+              vital::feature_track_set_sptr tracks,
+              vital::landmark_map_sptr& landmarks) const;
+
+private:
+  /// private implementation class
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_TRIANGULATE_LANDMARKS_PARALLEL_H_
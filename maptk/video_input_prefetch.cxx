@@ -0,0 +1,676 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Implementation of maptk::video_input_prefetch
+ */
+
+#include "video_input_prefetch.h"
+
+#include "frame_cache.h"
+
+#include <vital/exceptions/algorithm.h>
+#include <vital/logger/logger.h>
+
+#include <kwiversys/SystemTools.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace kwiver::vital;
+
+typedef kwiversys::SystemTools ST;
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Private implementation class
+class video_input_prefetch::priv
+{
+public:
+  /// A decoded frame
+  struct frame_data
+  {
+    frame_data() : bytes(0) {}
+
+    timestamp ts;
+    image_container_sptr image;
+    video_metadata_vector metadata;
+    size_t bytes;
+  };
+
+  /// Constructor
+  priv()
+    : num_threads(0),
+      read_ahead(16),
+      max_memory(1024),
+      cache_color("original"),
+      cache_downscale(1),
+      source_type("auto"),
+      cache_mode(frame_cache::original),
+      source_stamp(0),
+      buffered_bytes(0),
+      next_index(0),
+      end_index(0),
+      stopping(false),
+      is_open(false),
+      has_current(false),
+      at_end(false)
+  {
+  }
+
+  /// Decode the frames assigned to worker \p k with its own reader
+  void worker(size_t k);
+  /// Stop and join the worker threads
+  void stop();
+  /// Decode (or read from the cache) the current frame of \p reader
+  image_container_sptr read_image(algo::video_input& reader, size_t index);
+
+  /// Find the source images of an image list for the cache keys
+  void list_frame_sources(std::string const& name);
+  /// Get the cache key and stamp of frame \p index
+  std::pair<std::string, int64_t> frame_source(size_t index) const;
+
+  /// Test if the worker decoding frame \p index may do so now
+  bool may_decode(size_t index) const
+  {
+    if (index == next_index)
+    {
+      return true;
+    }
+    auto const max_bytes = static_cast<size_t>(max_memory) << 20;
+    return index < next_index + read_ahead &&
+           (max_memory == 0 || buffered_bytes < max_bytes);
+  }
+
+  /// number of decoding threads, or 0 for one per hardware thread
+  unsigned num_threads;
+  /// maximum number of frames decoded ahead of the current frame
+  unsigned read_ahead;
+  /// maximum megabytes of decoded images held, or 0 for no limit
+  unsigned max_memory;
+  /// path of the decoded frame cache, or empty to disable the cache
+  std::string cache_file;
+  /// conversion of cached frames: original, gray or rgb
+  std::string cache_color;
+  /// factor by which cached frames are downscaled
+  unsigned cache_downscale;
+  /// kind of source for the cache keys: auto, image_list or video
+  std::string source_type;
+
+  // decoded frame cache, and the keys of the frames of the open video
+  frame_cache cache;
+  frame_cache::color_mode cache_mode;
+  std::string source;
+  int64_t source_stamp;
+  std::vector<std::pair<std::string, int64_t>> frame_sources;
+
+  /// one nested reader per worker
+  std::vector<algo::video_input_sptr> readers;
+  std::vector<std::thread> threads;
+
+  // reorder buffer, and the state shared with the workers
+  std::mutex mutex;
+  std::condition_variable frame_ready;
+  std::condition_variable space_ready;
+  std::map<size_t, frame_data> buffer;
+  size_t buffered_bytes;
+  size_t next_index;
+  size_t end_index;
+  std::atomic<bool> stopping;
+  std::exception_ptr error;
+
+  // state of the consumer
+  bool is_open;
+  frame_data current;
+  bool has_current;
+  bool at_end;
+
+  /// logger handle
+  vital::logger_handle_t m_logger;
+};
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch::priv
+::worker(size_t k)
+{
+  auto& reader = *this->readers[k];
+  auto const count = this->readers.size();
+
+  try
+  {
+    timestamp ts;
+    for (size_t index = 0; !this->stopping; ++index)
+    {
+      if (!reader.next_frame(ts))
+      {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->end_index = std::min(this->end_index, index);
+        this->frame_ready.notify_all();
+        return;
+      }
+
+      // Frames are dealt to the workers in turn; skip the others' frames
+      if (index % count != k)
+      {
+        continue;
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->space_ready.wait(lock, [&]{
+          return this->stopping || this->may_decode(index);
+        });
+        if (this->stopping)
+        {
+          return;
+        }
+      }
+
+      frame_data frame;
+      frame.ts = ts;
+      frame.image = this->read_image(reader, index);
+      frame.metadata = reader.frame_metadata();
+      frame.bytes = (frame.image ? frame.image->size() : 0);
+
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->buffered_bytes += frame.bytes;
+      this->buffer.emplace(index, std::move(frame));
+      this->frame_ready.notify_all();
+    }
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->error)
+    {
+      this->error = std::current_exception();
+    }
+    this->frame_ready.notify_all();
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+image_container_sptr
+video_input_prefetch::priv
+::read_image(algo::video_input& reader, size_t index)
+{
+  if (!this->cache.is_open())
+  {
+    return reader.frame_image();
+  }
+
+  auto const key = this->frame_source(index);
+  auto image = this->cache.find(key.first, key.second);
+  if (!image)
+  {
+    // Frames are delivered as they are cached, so that a run gives the same
+    // images whether or not they come from the cache
+    image = frame_cache::convert(reader.frame_image(), this->cache_mode,
+                                 this->cache_downscale);
+    if (image)
+    {
+      this->cache.add(key.first, key.second, image->get_image());
+    }
+  }
+  return image;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch::priv
+::list_frame_sources(std::string const& name)
+{
+  this->frame_sources.clear();
+  this->source = ST::CollapseFullPath(name);
+  this->source_stamp = (ST::FileExists(this->source)
+                        ? static_cast<int64_t>(ST::ModifiedTime(this->source))
+                        : 0);
+
+  // Only image lists name the images of their frames; frames of other
+  // sources are keyed by their number
+  auto const is_list =
+    (this->source_type == "auto"
+     ? this->readers.front()->impl_name() == "image_list"
+     : this->source_type == "image_list");
+  if (!is_list || !ST::FileExists(this->source, true))
+  {
+    return;
+  }
+
+  // Resolve each image as the image list reader does, skipping blank lines
+  // and comments, relative to the list and then to the working directory
+  auto const list_dir = ST::GetFilenamePath(this->source);
+  std::ifstream list(this->source);
+  std::string line;
+  while (std::getline(list, line))
+  {
+    line = line.substr(0, line.find('#'));
+    auto const first = line.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+    {
+      continue;
+    }
+    line = line.substr(first, line.find_last_not_of(" \t\r\n") - first + 1);
+
+    auto path = ST::CollapseFullPath(line, list_dir);
+    if (!ST::FileExists(path, true))
+    {
+      path = ST::CollapseFullPath(line);
+    }
+    if (ST::FileExists(path, true))
+    {
+      this->frame_sources.emplace_back(
+        path, static_cast<int64_t>(ST::ModifiedTime(path)));
+    }
+    else
+    {
+      this->frame_sources.emplace_back(std::string(), 0);
+    }
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+std::pair<std::string, int64_t>
+video_input_prefetch::priv
+::frame_source(size_t index) const
+{
+  // The conversion is part of the key, so frames cached with other settings
+  // are not used
+  std::ostringstream key;
+  key << this->cache_color << '/' << this->cache_downscale << ':';
+
+  if (index < this->frame_sources.size() &&
+      !this->frame_sources[index].first.empty())
+  {
+    key << this->frame_sources[index].first;
+    return std::make_pair(key.str(), this->frame_sources[index].second);
+  }
+
+  // Otherwise identify the frame by its number in the video
+  key << this->source << '#' << index;
+  return std::make_pair(key.str(), this->source_stamp);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch::priv
+::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = true;
+    this->space_ready.notify_all();
+  }
+  for (auto& t : this->threads)
+  {
+    t.join();
+  }
+  this->threads.clear();
+  this->stopping = false;
+}
+
+
+// ----------------------------------------------------------------------------
+video_input_prefetch
+::video_input_prefetch()
+  : d_(new priv)
+{
+  attach_logger( "video_input_prefetch" );
+  d_->m_logger = this->logger();
+
+  set_capability(vital::algo::video_input::HAS_TIMEOUT, true);
+}
+
+
+// ----------------------------------------------------------------------------
+video_input_prefetch
+::~video_input_prefetch() VITAL_NOTHROW
+{
+  try
+  {
+    this->close();
+  }
+  catch (...)
+  {
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+config_block_sptr
+video_input_prefetch
+::get_configuration() const
+{
+  // get base config from base class
+  config_block_sptr config = algorithm::get_configuration();
+
+  // Sub-algorithm implementation name + sub_config block
+  algo::video_input::get_nested_algo_configuration(
+    "video_reader", config,
+    d_->readers.empty() ? algo::video_input_sptr() : d_->readers.front());
+
+  config->set_value("num_threads", d_->num_threads,
+                    "The number of threads decoding frames, each with its own "
+                    "instance of the nested video reader.  A value of 0 uses "
+                    "one thread per hardware thread.");
+  config->set_value("read_ahead", d_->read_ahead,
+                    "The maximum number of frames decoded ahead of the "
+                    "current frame.");
+  config->set_value("max_memory", d_->max_memory,
+                    "The maximum number of megabytes of decoded images held "
+                    "ahead of the current frame.  The next frame is always "
+                    "decoded.  A value of 0 removes the limit.");
+  config->set_value("cache_file", d_->cache_file,
+                    "Path of a file in which to cache decoded frames, so that "
+                    "later runs on the same images read them directly "
+                    "instead of decoding them again.  Frames are keyed by the "
+                    "path and modification time of their source image.  If "
+                    "empty, no cache is used.");
+  config->set_value("cache_color", d_->cache_color,
+                    "The conversion of 8-bit frames when a cache is used.  "
+                    "One of \"original\" to keep the channels of the source, "
+                    "\"gray\" to convert to gray levels, or \"rgb\" to "
+                    "convert to three color channels.  Frames are delivered "
+                    "as they are cached.");
+  config->set_value("cache_downscale", d_->cache_downscale,
+                    "The factor by which 8-bit frames are downscaled, by "
+                    "averaging, when a cache is used.  A value of 1 keeps "
+                    "the full resolution.");
+  config->set_value("source_type", d_->source_type,
+                    "How the frames are identified in the cache.  One of "
+                    "\"image_list\" if the source is a list of images, whose "
+                    "frames are keyed by the path of each image, \"video\" "
+                    "to key frames by the source path and frame number, or "
+                    "\"auto\" to treat the source as an image list only if "
+                    "the nested reader is the image_list reader.");
+
+  return config;
+}
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch
+::set_configuration(config_block_sptr in_config)
+{
+  // Starting with our generated config_block to ensure that assumed values
+  // are present.  An alternative is to check for key presence before
+  // performing a get_value() call.
+  config_block_sptr config = this->get_configuration();
+  config->merge_config(in_config);
+
+  d_->num_threads = config->get_value<unsigned>("num_threads");
+  d_->read_ahead = std::max(1u, config->get_value<unsigned>("read_ahead"));
+  d_->max_memory = config->get_value<unsigned>("max_memory");
+  d_->cache_file = config->get_value<std::string>("cache_file");
+  d_->cache_color = config->get_value<std::string>("cache_color");
+  d_->cache_downscale =
+    std::max(1u, config->get_value<unsigned>("cache_downscale"));
+  d_->source_type = config->get_value<std::string>("source_type");
+  d_->cache_mode = (d_->cache_color == "gray" ? frame_cache::gray
+                    : d_->cache_color == "rgb" ? frame_cache::rgb
+                    : frame_cache::original);
+
+  // Each worker steps through the video with its own reader
+  this->close();
+  auto const count = (d_->num_threads ? d_->num_threads
+                      : std::max(1u, std::thread::hardware_concurrency()));
+  d_->readers.resize(count);
+  for (auto& r : d_->readers)
+  {
+    algo::video_input::set_nested_algo_configuration(
+      "video_reader", config, r);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+video_input_prefetch
+::check_configuration(config_block_sptr config) const
+{
+  auto const color = config->get_value<std::string>("cache_color", "original");
+  if (color != "original" && color != "gray" && color != "rgb")
+  {
+    LOG_ERROR(d_->m_logger, "cache_color must be one of \"original\", "
+                            "\"gray\" or \"rgb\", not \"" << color << "\"");
+    return false;
+  }
+
+  auto const source_type =
+    config->get_value<std::string>("source_type", "auto");
+  if (source_type != "auto" && source_type != "image_list" &&
+      source_type != "video")
+  {
+    LOG_ERROR(d_->m_logger, "source_type must be one of \"auto\", "
+                            "\"image_list\" or \"video\", not \""
+                            << source_type << "\"");
+    return false;
+  }
+
+  return algo::video_input::check_nested_algo_configuration(
+    "video_reader", config);
+}
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch
+::open(std::string name)
+{
+  if (d_->readers.empty() || !d_->readers.front())
+  {
+    throw vital::algorithm_configuration_exception(
+      this->type_name(), this->impl_name(),
+      "nested video reader has not been initialized");
+  }
+
+  this->close();
+  for (auto const& r : d_->readers)
+  {
+    r->open(name);
+  }
+
+  // Report the capabilities of the nested reader
+  typedef vital::algo::video_input vi;
+  auto const& caps = d_->readers.front()->get_implementation_capabilities();
+  set_capability(vi::HAS_EOV, caps.capability(vi::HAS_EOV));
+  set_capability(vi::HAS_FRAME_NUMBERS, caps.capability(vi::HAS_FRAME_NUMBERS));
+  set_capability(vi::HAS_FRAME_DATA, caps.capability(vi::HAS_FRAME_DATA));
+  set_capability(vi::HAS_FRAME_TIME, caps.capability(vi::HAS_FRAME_TIME));
+  set_capability(vi::HAS_METADATA, caps.capability(vi::HAS_METADATA));
+  set_capability(vi::HAS_ABSOLUTE_FRAME_TIME,
+                 caps.capability(vi::HAS_ABSOLUTE_FRAME_TIME));
+
+  if (!d_->cache_file.empty())
+  {
+    if (d_->cache.open(d_->cache_file))
+    {
+      d_->list_frame_sources(name);
+    }
+    else
+    {
+      LOG_WARN(d_->m_logger, "Decoding without a frame cache");
+    }
+  }
+
+  d_->next_index = 0;
+  d_->end_index = std::numeric_limits<size_t>::max();
+  d_->is_open = true;
+  for (size_t k = 0; k < d_->readers.size(); ++k)
+  {
+    d_->threads.emplace_back(&priv::worker, d_.get(), k);
+  }
+
+  LOG_DEBUG(d_->m_logger, "Decoding \"" << name << "\" with "
+                          << d_->readers.size() << " threads");
+}
+
+
+// ----------------------------------------------------------------------------
+void
+video_input_prefetch
+::close()
+{
+  if (!d_->is_open)
+  {
+    return;
+  }
+
+  d_->stop();
+  d_->cache.close();
+  for (auto const& r : d_->readers)
+  {
+    r->close();
+  }
+
+  d_->buffer.clear();
+  d_->buffered_bytes = 0;
+  d_->error = nullptr;
+  d_->current = priv::frame_data();
+  d_->has_current = false;
+  d_->at_end = false;
+  d_->is_open = false;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+video_input_prefetch
+::end_of_video() const
+{
+  return d_->at_end;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+video_input_prefetch
+::good() const
+{
+  return d_->is_open && d_->has_current;
+}
+
+
+// ----------------------------------------------------------------------------
+bool
+video_input_prefetch
+::next_frame(timestamp& ts, uint32_t timeout)
+{
+  if (!d_->is_open || d_->at_end)
+  {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(d_->mutex);
+  auto const ready = [this]{
+    return d_->error || d_->buffer.count(d_->next_index) ||
+           d_->next_index >= d_->end_index;
+  };
+  if (timeout)
+  {
+    if (!d_->frame_ready.wait_for(lock, std::chrono::seconds(timeout), ready))
+    {
+      return false;
+    }
+  }
+  else
+  {
+    d_->frame_ready.wait(lock, ready);
+  }
+
+  if (d_->error)
+  {
+    std::rethrow_exception(d_->error);
+  }
+
+  auto const fi = d_->buffer.find(d_->next_index);
+  if (fi == d_->buffer.end())
+  {
+    // The frame is neither buffered nor coming, so the video has ended
+    d_->current = priv::frame_data();
+    d_->has_current = false;
+    d_->at_end = true;
+    return false;
+  }
+
+  d_->current = std::move(fi->second);
+  d_->buffered_bytes -= d_->current.bytes;
+  d_->buffer.erase(fi);
+  d_->has_current = true;
+  ++d_->next_index;
+  d_->space_ready.notify_all();
+
+  ts = d_->current.ts;
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------
+image_container_sptr
+video_input_prefetch
+::frame_image()
+{
+  return d_->current.image;
+}
+
+
+// ----------------------------------------------------------------------------
+video_metadata_vector
+video_input_prefetch
+::frame_metadata()
+{
+  return d_->current.metadata;
+}
+
+
+} // end namespace maptk
+} // end namespace kwiver
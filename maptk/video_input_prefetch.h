@@ -0,0 +1,129 @@
+/*ckwg +29
+ * Copyright 2017 by Kitware, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ *  * Neither the name Kitware, Inc. nor the names of any contributors may be
+ *    used to endorse or promote products derived from this software without
+ *    specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \file
+ * \brief Header for maptk::video_input_prefetch
+ */
+
+#ifndef MAPTK_VIDEO_INPUT_PREFETCH_H_
+#define MAPTK_VIDEO_INPUT_PREFETCH_H_
+
+#include <maptk/maptk_export.h>
+
+#include <vital/algo/algorithm.h>
+#include <vital/algo/video_input.h>
+#include <vital/config/config_block.h>
+
+#include <memory>
+
+
+namespace kwiver {
+namespace maptk {
+
+
+/// Video input proxy which decodes frames ahead in parallel
+/**
+ * This class wraps another video input, typically an image list, and
+ * decodes the frames ahead of the consumer on several worker threads.  Each
+ * worker opens its own instance of the nested video input, steps through
+ * every frame, and decodes only the frames assigned to it, so the nested
+ * reader need not be thread safe.  This is efficient when stepping to the
+ * next frame is cheap and the cost is in decoding the image, as for image
+ * lists; it is not suited to compressed video streams.
+ *
+ * Decoded frames are held in a reorder buffer and delivered in their
+ * original order.  Workers stop decoding when the buffer holds
+ * \c read_ahead frames or \c max_memory megabytes of images, except for the
+ * next frame to be delivered, which is always decoded.
+ *
+ * Optionally, decoded frames are kept in a cache file, keyed by the path and
+ * modification time of their source image, so that later runs on the same
+ * images memory-map the frames instead of decoding them.  Frames of sources
+ * other than image lists (as set by \c source_type) are keyed by the source
+ * path and frame number instead.  Cached 8-bit
+ * frames may be converted to gray or color and downscaled; frames are
+ * delivered as they are cached.
+ */
+class MAPTK_EXPORT video_input_prefetch
+  : public vital::algorithm_impl<video_input_prefetch,
+                                 vital::algo::video_input>
+{
+public:
+  /// Default Constructor
+  video_input_prefetch();
+
+  /// Destructor
+  virtual ~video_input_prefetch() VITAL_NOTHROW;
+
+  /// Get this algorithm's \link vital::config_block configuration block \endlink
+  virtual vital::config_block_sptr get_configuration() const;
+  /// Set this algorithm's properties via a config block
+  virtual void set_configuration(vital::config_block_sptr config);
+  /// Check that the algorithm's currently configuration is valid
+  virtual bool check_configuration(vital::config_block_sptr config) const;
+
+  /// Open a video stream and start decoding ahead
+  virtual void open(std::string name);
+  /// Stop decoding and close the video stream
+  virtual void close();
+
+  /// Return true if the end of the video has been reached
+  virtual bool end_of_video() const;
+  /// Return true if there is a current frame
+  virtual bool good() const;
+
+  /// Advance to the next frame, waiting for it to be decoded
+  /**
+   * \param [out] ts the time stamp of the new frame
+   * \param [in] timeout the number of seconds to wait for the frame, or 0
+   *                     to wait indefinitely
+   * \returns true if a frame is available, false at the end of the video or
+   *          if the timeout expired
+   */
+  virtual bool next_frame(vital::timestamp& ts, uint32_t timeout = 0);
+
+  /// Get the image of the current frame
+  virtual vital::image_container_sptr frame_image();
+  /// Get the metadata of the current frame
+  virtual vital::video_metadata_vector frame_metadata();
+
+private:
+  /// private implementation class
+  class priv;
+  const std::unique_ptr<priv> d_;
+};
+
+
+} // end namespace maptk
+} // end namespace kwiver
+
+
+#endif // MAPTK_VIDEO_INPUT_PREFETCH_H_
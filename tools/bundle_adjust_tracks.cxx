@@ -38,7 +38,9 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 #include <exception>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -73,8 +75,11 @@
 #include <arrows/core/transform.h>
 
 #include <maptk/colorize.h>
+#include <maptk/compact_feature_tracks.h>
+#include <maptk/dense_camera_map.h>
 #include <maptk/geo_reference_points_io.h>
 #include <maptk/local_geo_cs.h>
+#include <maptk/residuals.h>
 #include <maptk/version.h>
 
 typedef kwiversys::SystemTools     ST;
@@ -193,6 +198,20 @@ static kwiver::vital::config_block_sptr default_config()
   config->set_value("depthmaps_images_file", "",
                     "An optional file containing paths to depthmaps as image datas.");
 
+  config->set_value("outlier_pruning:max_iterations", "0",
+                    "The maximum number of times to remove outlier observations "
+                    "and run bundle adjustment again after the first bundle "
+                    "adjustment.  A value of 0 disables outlier pruning.");
+
+  config->set_value("outlier_pruning:threshold", "4.0",
+                    "Observations with a reprojection error greater than this "
+                    "many pixels are removed as outliers between bundle "
+                    "adjustment rounds.");
+
+  config->set_value("outlier_pruning:min_track_length", "2",
+                    "Tracks (and their landmarks) left with fewer than this "
+                    "many observations after outlier removal are discarded.");
+
   auto default_vi = kwiver::vital::algo::video_input::create("pos");
   kwiver::vital::algo::video_input::get_nested_algo_configuration("video_reader", config, default_vi);
   kwiver::vital::algo::filter_tracks::get_nested_algo_configuration("track_filter", config,
@@ -398,6 +417,62 @@ bool load_input_cameras(kwiver::vital::config_block_sptr config,
 }
 
 
+// ------------------------------------------------------------------
+/// Log a summary of reprojection statistics
+/**
+ * Reports the overall error, the error histogram, and the cameras with the
+ * largest errors, which are often where a reconstruction goes wrong.
+ */
+static void
+log_reprojection_statistics(kwiver::maptk::reprojection_statistics const& stats)
+{
+  LOG_DEBUG(main_logger, "final reprojection RMSE: " << stats.total.rmse()
+                         << " (max " << stats.total.max_error << ") over "
+                         << stats.total.count << " observations, "
+                         << stats.cameras.size() << " cameras and "
+                         << stats.tracks.size() << " tracks");
+  if (stats.invalid)
+  {
+    LOG_WARN(main_logger, stats.invalid << " observations have undefined "
+                          "reprojection errors");
+  }
+
+  std::ostringstream histogram;
+  for (size_t b = 0; b < stats.histogram.size(); ++b)
+  {
+    histogram << "\n  " << (b * stats.bin_width) << " - ";
+    if (b + 1 < stats.histogram.size())
+    {
+      histogram << ((b + 1) * stats.bin_width);
+    }
+    histogram << " px: " << stats.histogram[b];
+  }
+  LOG_DEBUG(main_logger, "reprojection error histogram:" << histogram.str());
+
+  // Report the cameras with the largest RMSE
+  typedef std::pair<double, kwiver::vital::frame_id_t> camera_error_t;
+  std::vector<camera_error_t> camera_errors;
+  for (auto const& c : stats.cameras)
+  {
+    camera_errors.push_back(camera_error_t(c.second.rmse(), c.first));
+  }
+  auto const num_worst = std::min<size_t>(5, camera_errors.size());
+  std::partial_sort(camera_errors.begin(), camera_errors.begin() + num_worst,
+                    camera_errors.end(), std::greater<camera_error_t>());
+  for (size_t i = 0; i < num_worst; ++i)
+  {
+    LOG_DEBUG(main_logger, "camera " << camera_errors[i].second
+                           << " reprojection RMSE: " << camera_errors[i].first);
+  }
+
+  if (!stats.outliers.empty())
+  {
+    LOG_INFO(main_logger, stats.outliers.size() << " observations remain "
+                          "above the outlier pruning threshold");
+  }
+}
+
+
 static int maptk_main(int argc, char const* argv[])
 {
   static bool        opt_help(false);
@@ -606,21 +681,16 @@ static int maptk_main(int argc, char const* argv[])
     return EXIT_FAILURE;
   }
 
-  // Copy input cameras into main camera map
+  // Copy input cameras into main camera map.  Dense camera maps hold the
+  // camera poses by value, so a copy is independent of the input cameras.
   kwiver::vital::camera_map::map_camera_t cameras;
   kwiver::vital::landmark_map_sptr lm_map;
-  kwiver::vital::camera_map_sptr input_cam_map(new kwiver::vital::simple_camera_map(input_cameras));
-  if (input_cameras.size() != 0)
-  {
-    for(kwiver::vital::camera_map::map_camera_t::value_type &v : input_cameras)
-    {
-      cameras[v.first] = v.second->clone();
-    }
-  }
+  auto const input_cam_map =
+    std::make_shared<kwiver::maptk::dense_camera_map>(input_cameras);
   kwiver::vital::camera_map_sptr cam_map;
-  if(!cameras.empty())
+  if (input_cam_map->size() != 0)
   {
-    cam_map = kwiver::vital::camera_map_sptr(new kwiver::vital::simple_camera_map(cameras));
+    cam_map = std::make_shared<kwiver::maptk::dense_camera_map>(*input_cam_map);
   }
 
   kwiver::vital::landmark_map_sptr reference_landmarks(new kwiver::vital::simple_landmark_map());
@@ -655,17 +725,20 @@ static int maptk_main(int argc, char const* argv[])
   bool init_unloaded_cams = config->get_value<bool>("initialize_unloaded_cameras", true);
   if (init_unloaded_cams)
   {
-    if( cam_map )
-    {
-      cameras = cam_map->cameras();
-    }
+    auto const all_cams =
+      (cam_map
+       ? std::make_shared<kwiver::maptk::dense_camera_map>(cam_map->cameras())
+       : std::make_shared<kwiver::maptk::dense_camera_map>());
     for(const kwiver::vital::frame_id_t& id : tracks->all_frame_ids())
     {
       // if id is already in the map, do nothing.
       // if id is not it the map add a null camera pointer
-      cameras[id];
+      if (!all_cams->contains(id))
+      {
+        all_cams->insert(id, kwiver::vital::camera_sptr());
+      }
     }
-    cam_map = kwiver::vital::camera_map_sptr(new kwiver::vital::simple_camera_map(cameras));
+    cam_map = all_cams;
   }
 
   //
@@ -728,19 +801,65 @@ static int maptk_main(int argc, char const* argv[])
   { // scope block
     kwiver::vital::scoped_cpu_timer t( "Tool-level SBA algorithm" );
 
-    double init_rmse = kwiver::arrows::reprojection_rmse(cam_map->cameras(),
-                                                        lm_map->landmarks(),
-                                                        tracks->tracks());
-    LOG_DEBUG(main_logger, "initial reprojection RMSE: " << init_rmse);
+    unsigned int const prune_iterations =
+      config->get_value<unsigned int>("outlier_pruning:max_iterations");
+    double const prune_threshold =
+      config->get_value<double>("outlier_pruning:threshold");
+    size_t const min_track_length =
+      config->get_value<size_t>("outlier_pruning:min_track_length");
+
+    auto stats = kwiver::maptk::compute_reprojection_statistics(
+      cam_map->cameras(), lm_map->landmarks(), tracks->tracks());
+    LOG_DEBUG(main_logger, "initial reprojection RMSE: " << stats.total.rmse());
 
     bundle_adjuster->optimize(cam_map, lm_map, tracks);
 
-    double end_rmse = kwiver::arrows::reprojection_rmse(cam_map->cameras(),
-                                                       lm_map->landmarks(),
-                                                       tracks->tracks());
-    LOG_DEBUG(main_logger, "final reprojection RMSE: " << end_rmse);
+    for (unsigned int i = 0; i < prune_iterations; ++i)
+    {
+      stats = kwiver::maptk::compute_reprojection_statistics(
+        cam_map->cameras(), lm_map->landmarks(), tracks->tracks(),
+        prune_threshold);
+      if (stats.outliers.empty())
+      {
+        break;
+      }
+
+      // Remove the outlier observations, then the landmarks of any tracks
+      // left too short to constrain them
+      tracks = kwiver::maptk::remove_outliers(*tracks, stats.outliers,
+                                              min_track_length);
+      auto const all_landmarks = lm_map->landmarks();
+      kwiver::vital::landmark_map::map_landmark_t landmarks;
+      for (auto const& t : tracks->tracks())
+      {
+        auto const lmi = all_landmarks.find(t->id());
+        if (lmi != all_landmarks.end())
+        {
+          landmarks.insert(*lmi);
+        }
+      }
+      LOG_INFO(main_logger, "Outlier pruning round " << (i + 1) << ": removed "
+                            << stats.outliers.size() << " of "
+                            << stats.total.count << " observations and "
+                            << (all_landmarks.size() - landmarks.size())
+                            << " landmarks (RMSE " << stats.total.rmse() << ")");
+      lm_map = std::make_shared<kwiver::vital::simple_landmark_map>(landmarks);
+
+      bundle_adjuster->optimize(cam_map, lm_map, tracks);
+    }
+
+    // Only report outliers against the threshold if pruning was enabled
+    stats = kwiver::maptk::compute_reprojection_statistics(
+      cam_map->cameras(), lm_map->landmarks(), tracks->tracks(),
+      prune_iterations > 0 ? prune_threshold : 0.0);
+    log_reprojection_statistics(stats);
   }
 
+  // Only the feature colors of the tracks are needed from here on, so keep
+  // them in a compact store and release the full track set and descriptors
+  kwiver::maptk::compact_feature_tracks const compact_tracks(*tracks, false);
+  tracks.reset();
+
 
   //
   // Adjust cameras/landmarks based on input cameras/reference points
@@ -781,10 +900,11 @@ static int maptk_main(int argc, char const* argv[])
                               << " reference points triangulated");
       }
 
-      double post_tri_rmse = kwiver::arrows::reprojection_rmse(cam_map->cameras(),
-                                                              sba_space_landmarks->landmarks(),
-                                                              reference_tracks->tracks());
-      LOG_DEBUG(main_logger, "Post-triangulation RMSE: " << post_tri_rmse);
+      auto const post_tri_stats = kwiver::maptk::compute_reprojection_statistics(
+        cam_map->cameras(), sba_space_landmarks->landmarks(),
+        reference_tracks->tracks());
+      LOG_DEBUG(main_logger, "Post-triangulation RMSE: "
+                             << post_tri_stats.total.rmse());
 
       // Estimate ST from sba-space to reference space.
       LOG_INFO(main_logger, "Estimating transform to reference landmarks (from "
@@ -816,7 +936,7 @@ static int maptk_main(int argc, char const* argv[])
   //
   // Compute landmark colors
   //
-  lm_map = kwiver::maptk::compute_landmark_colors(*lm_map, *tracks);
+  lm_map = kwiver::maptk::compute_landmark_colors(*lm_map, compact_tracks);
 
   //
   // Write the output PLY file